@@ -412,3 +412,42 @@ if test "${ch_cv_cxx_string}" = no; then
 AC_MSG_WARN(Your C++ compiler string support does not work.)
 fi
 ])dnl
+dnl
+dnl @synopsis CH_CXX_TARGET_ATTRIBUTE
+dnl
+dnl This macro checks if the C++ compiler can compile single functions
+dnl for other instruction sets (AVX2 and AVX-512) with the target
+dnl attribute, and can ask the processor which of them it has.
+dnl
+dnl If it can it defines CXX_HAVE_TARGET_ATTRIBUTE
+dnl
+dnl @version $Id$
+dnl
+AC_DEFUN([CH_CXX_TARGET_ATTRIBUTE],
+[
+AC_REQUIRE([AC_PROG_CXX])
+AC_CACHE_CHECK([whether ${CXX} supports the target attribute],
+ch_cv_cxx_target_attribute,
+[
+AC_LANG_SAVE
+AC_LANG_CPLUSPLUS
+AC_TRY_LINK([
+__attribute__((target("avx2"))) double f(double x) { return x * x; }
+__attribute__((target("avx512f"))) double g(double x) { return x * x; }
+],[
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return g(1.0) > 0.0;
+  if (__builtin_cpu_supports("avx2"))
+    return f(1.0) > 0.0;
+  return 0;
+],
+ch_cv_cxx_target_attribute=yes,
+ch_cv_cxx_target_attribute=no)
+AC_LANG_RESTORE
+])
+if test "${ch_cv_cxx_target_attribute}" = yes; then
+AC_DEFINE(CXX_HAVE_TARGET_ATTRIBUTE, 1,
+          [Define if C++ can compile functions for other instruction sets])
+fi
+])dnl
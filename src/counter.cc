@@ -35,6 +35,11 @@ counter::counter()
   : i(0)
 {}
 
+// ctor: start counting from I_
+counter::counter(int i_)
+  : i(i_)
+{}
+
 // ctor: copy
 counter::counter(const counter& original)
   : i(original.i)
@@ -32,6 +32,8 @@ class counter
 public:
   // ctor: (default) initialize i to zero
   counter();
+  // ctor: start counting from I_
+  explicit counter(int i_);
   // ctor: copy
   counter(const counter& original);
   // assignment
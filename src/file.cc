@@ -484,6 +484,229 @@ safe_ofstream::open(const CH_STD::string& path)
   return;
 }
 
+// binary_ofstream methods
+// ctor: open PATH for output, destroying its contents
+binary_ofstream::binary_ofstream(const CH_STD::string& path_)
+  throw (bad_file)
+  : CH_STD::ofstream(), path(path_)
+{
+  // 32 bit integers and 64 bit doubles are all we write
+  if (sizeof(unsigned int) != 4U || sizeof(double) != 8U)
+    {
+      throw bad_file(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
+		     + ":binary_ofstream::binary_ofstream(): binary files "
+		     "are not supported on this machine");
+    }
+  CH_STD::ofstream::open(path.c_str(), CH_STD::ios::out
+			 | CH_STD::ios::binary | CH_STD::ios::trunc);
+  if (!*this)
+    {
+      throw bad_file(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
+		     + ":binary_ofstream::binary_ofstream(): could not open "
+		     "file " + path + ": " + CH_STD::strerror(errno));
+    }
+}
+
+// dtor: do nothing
+binary_ofstream::~binary_ofstream()
+{}
+
+// binary_ofstream public methods
+// write SIZE bytes starting at DATA
+void
+binary_ofstream::put_bytes(const void* data, unsigned int size)
+  throw (bad_file)
+{
+  write(static_cast<const char*>(data), size);
+  if (!*this)
+    {
+      throw bad_file(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
+		     + ":binary_ofstream::put_bytes(): could not write to "
+		     "file " + path);
+    }
+  return;
+}
+
+// write the MAGIC string, format VERSION and byte order marks
+void
+binary_ofstream::put_header(const CH_STD::string& magic, unsigned int version)
+  throw (bad_file)
+{
+  put_bytes(magic.data(), magic.size());
+  put_unsigned(version);
+  // readers compare these with what they expect
+  put_unsigned(0x01020304U);
+  put_double(1.0e0);
+  return;
+}
+
+// write an unsigned integer (32 bits)
+void
+binary_ofstream::put_unsigned(unsigned int value)
+  throw (bad_file)
+{
+  put_bytes(&value, sizeof(value));
+  return;
+}
+
+// write a signed integer (32 bits)
+void
+binary_ofstream::put_int(int value)
+  throw (bad_file)
+{
+  put_bytes(&value, sizeof(value));
+  return;
+}
+
+// write a double (64 bits)
+void
+binary_ofstream::put_double(double value)
+  throw (bad_file)
+{
+  put_bytes(&value, sizeof(value));
+  return;
+}
+
+// write a string, preceded by its length
+void
+binary_ofstream::put_string(const CH_STD::string& value)
+  throw (bad_file)
+{
+  put_unsigned(value.size());
+  put_bytes(value.data(), value.size());
+  return;
+}
+
+// flush and close the file, making sure everything was written
+void
+binary_ofstream::finish()
+  throw (bad_file)
+{
+  flush();
+  close();
+  if (!*this)
+    {
+      throw bad_file(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
+		     + ":binary_ofstream::finish(): could not finish "
+		     "writing file " + path);
+    }
+  return;
+}
+
+// binary_ifstream methods
+// ctor: open PATH for input
+binary_ifstream::binary_ifstream(const CH_STD::string& path_)
+  throw (bad_file)
+  : CH_STD::ifstream(), path(path_)
+{
+  CH_STD::ifstream::open(path.c_str(), CH_STD::ios::in | CH_STD::ios::binary);
+  if (!*this)
+    {
+      throw bad_file(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
+		     + ":binary_ifstream::binary_ifstream(): could not open "
+		     "file " + path + ": " + CH_STD::strerror(errno));
+    }
+}
+
+// dtor: do nothing
+binary_ifstream::~binary_ifstream()
+{}
+
+// binary_ifstream private methods
+// read SIZE bytes into DATA
+void
+binary_ifstream::get_bytes(void* data, unsigned int size)
+  throw (bad_file)
+{
+  read(static_cast<char*>(data), size);
+  if (!*this)
+    {
+      throw bad_file(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
+		     + ":binary_ifstream::get_bytes(): unexpected end of "
+		     "file " + path);
+    }
+  return;
+}
+
+// binary_ifstream public methods
+// check the MAGIC string and byte order marks, return format version
+unsigned int
+binary_ifstream::get_header(const CH_STD::string& magic)
+  throw (bad_file)
+{
+  CH_STD::string found(magic.size(), ' ');
+  get_bytes(&found[0], found.size());
+  if (found != magic)
+    {
+      throw bad_file(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
+		     + ":binary_ifstream::get_header(): file " + path
+		     + " is not of the expected type");
+    }
+  unsigned int version(get_unsigned());
+  // the file must have been written by a similar machine
+  unsigned int order(get_unsigned());
+  double one(get_double());
+  if (order != 0x01020304U || one != 1.0e0)
+    {
+      throw bad_file(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
+		     + ":binary_ifstream::get_header(): file " + path
+		     + " was written on a machine with a different byte "
+		     "order");
+    }
+  return version;
+}
+
+// read an unsigned integer (32 bits)
+unsigned int
+binary_ifstream::get_unsigned()
+  throw (bad_file)
+{
+  unsigned int value(0U);
+  get_bytes(&value, sizeof(value));
+  return value;
+}
+
+// read a signed integer (32 bits)
+int
+binary_ifstream::get_int()
+  throw (bad_file)
+{
+  int value(0);
+  get_bytes(&value, sizeof(value));
+  return value;
+}
+
+// read a double (64 bits)
+double
+binary_ifstream::get_double()
+  throw (bad_file)
+{
+  double value(0.0e0);
+  get_bytes(&value, sizeof(value));
+  return value;
+}
+
+// read a string written by put_string()
+CH_STD::string
+binary_ifstream::get_string()
+  throw (bad_file)
+{
+  unsigned int size(get_unsigned());
+  CH_STD::string value(size, ' ');
+  if (size > 0U)
+    {
+      get_bytes(&value[0], size);
+    }
+  return value;
+}
+
+// return the name of the file
+CH_STD::string
+binary_ifstream::get_path() const
+{
+  return path;
+}
+
 CH_END_NAMESPACE
 
 /* $Id: file.cc,v 1.1.1.1 2004/11/25 20:24:05 banjo Exp $ */
@@ -148,6 +148,85 @@ public:
     throw (bad_file); // this, force_open()
 }; // end class safe_file
 
+// binary output file of fixed size values in the byte order of this
+// machine; the header records that order, so the file can be checked
+// (or memory mapped) when it is read
+class binary_ofstream : public CH_STD::ofstream
+{
+  CH_STD::string path;		// name of the file (for error messages)
+
+private:
+  // prevent copy construction and assignment
+  binary_ofstream(const binary_ofstream&);
+  binary_ofstream& operator=(const binary_ofstream&);
+public:
+  // ctor: open PATH for output, destroying its contents
+  explicit binary_ofstream(const CH_STD::string& path_)
+    throw (bad_file); // this
+  // dtor: parent will close stream if still open
+  ~binary_ofstream();
+
+  // write SIZE bytes starting at DATA
+  void put_bytes(const void* data, unsigned int size)
+    throw (bad_file); // this
+  // write the MAGIC string, format VERSION and byte order marks
+  void put_header(const CH_STD::string& magic, unsigned int version)
+    throw (bad_file); // put_bytes(), put_unsigned(), put_double()
+  // write an unsigned integer (32 bits)
+  void put_unsigned(unsigned int value)
+    throw (bad_file); // put_bytes()
+  // write a signed integer (32 bits)
+  void put_int(int value)
+    throw (bad_file); // put_bytes()
+  // write a double (64 bits)
+  void put_double(double value)
+    throw (bad_file); // put_bytes()
+  // write a string, preceded by its length
+  void put_string(const CH_STD::string& value)
+    throw (bad_file); // put_unsigned(), put_bytes()
+  // flush and close the file, making sure everything was written
+  void finish()
+    throw (bad_file); // this
+}; // end class binary_ofstream
+
+// binary input file written by a binary_ofstream
+class binary_ifstream : public CH_STD::ifstream
+{
+  CH_STD::string path;		// name of the file (for error messages)
+
+private:
+  // prevent copy construction and assignment
+  binary_ifstream(const binary_ifstream&);
+  binary_ifstream& operator=(const binary_ifstream&);
+  // read SIZE bytes into DATA
+  void get_bytes(void* data, unsigned int size)
+    throw (bad_file); // this
+public:
+  // ctor: open PATH for input
+  explicit binary_ifstream(const CH_STD::string& path_)
+    throw (bad_file); // this
+  // dtor: parent will close stream if still open
+  ~binary_ifstream();
+
+  // check the MAGIC string and byte order marks, return format version
+  unsigned int get_header(const CH_STD::string& magic)
+    throw (bad_file); // this, get_bytes(), get_unsigned(), get_double()
+  // read an unsigned integer (32 bits)
+  unsigned int get_unsigned()
+    throw (bad_file); // get_bytes()
+  // read a signed integer (32 bits)
+  int get_int()
+    throw (bad_file); // get_bytes()
+  // read a double (64 bits)
+  double get_double()
+    throw (bad_file); // get_bytes()
+  // read a string written by put_string()
+  CH_STD::string get_string()
+    throw (bad_file); // get_unsigned(), get_bytes()
+  // return the name of the file
+  CH_STD::string get_path() const;
+}; // end class binary_ifstream
+
 CH_END_NAMESPACE
 
 #endif // not CH_FILE_H
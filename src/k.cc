@@ -95,6 +95,15 @@ k::get_k(double T, double R) const
   return k0->get_value();
 }
 
+// put the prefactor and activation energy into the arguments
+void
+k::get_arrhenius(double& prefactor, double& energy) const
+{
+  prefactor = k0->get_value();
+  energy = 0.0e0;
+  return;
+}
+
 // virtual function for proper printing
 CH_STD::string
 k::stringify() const
@@ -122,6 +131,15 @@ k_arrhenius::get_k(double T, double R) const
   return k::get_k() * CH_STD::exp(-ea->get_value() / (R * T));
 }
 
+// put the prefactor and activation energy into the arguments
+void
+k_arrhenius::get_arrhenius(double& prefactor, double& energy) const
+{
+  prefactor = k::get_k();
+  energy = ea->get_value();
+  return;
+}
+
 // virtual function for output
 CH_STD::string
 k_arrhenius::stringify() const
@@ -159,14 +177,26 @@ k_lfer::~k_lfer()
 // defaults R = 8.314 kJ/molK
 double
 k_lfer::get_k(double T, double R) const
+{
+  double prefactor;
+  double ea;
+  get_arrhenius(prefactor, ea);
+  // calculate the rate constant
+  return prefactor * CH_STD::exp(-ea / (R * T));
+}
+
+// put the prefactor and activation energy into the arguments
+void
+k_lfer::get_arrhenius(double& prefactor, double& energy) const
 {
   double Hrxn(delH->get_value());
   double ea(e0->get_value() +  gamma->get_value() * Hrxn);
   // make sure activation energy is valid
   ea = (ea < 0.0e0) ? 0.0e0 : ea;
   ea = (ea < Hrxn) ? Hrxn : ea;
-  // calculate the rate constant
-  return k::get_k() * CH_STD::exp(-ea / (R * T));
+  prefactor = k::get_k();
+  energy = ea;
+  return;
 }
 
 // virtual function for output
@@ -177,6 +207,24 @@ k_lfer::stringify() const
     + gamma->stringify() + ", " + delH->stringify() + ")";
 }
 
+// k_cache methods
+// ctor: (default) remember values of RATE_
+// ctor: default rate_ = 0
+k_cache::k_cache(const k* rate_)
+  : rate(rate_), valid(false), T(0.0e0), R(0.0e0), generation(0UL),
+    value(0.0e0)
+{}
+
+// ctor: copy
+k_cache::k_cache(const k_cache& original)
+  : rate(original.rate), valid(original.valid), T(original.T),
+    R(original.R), generation(original.generation), value(original.value)
+{}
+
+// dtor: do nothing, rate constant is owned by someone else
+k_cache::~k_cache()
+{}
+
 CH_END_NAMESPACE
 
 /* $Id: k.cc,v 1.1.1.1 2004/11/25 20:24:05 banjo Exp $ */
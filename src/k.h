@@ -55,6 +55,9 @@ public:
   // both of these functions return value of k0 (independent of T)
   double get_k() const;
   virtual double get_k(double T, double R = constant::r) const;
+  // put the prefactor and activation energy, such that the rate
+  // constant is PREFACTOR exp(-ENERGY / RT), into the arguments
+  virtual void get_arrhenius(double& prefactor, double& energy) const;
 
   // virtual function for output
   virtual CH_STD::string stringify() const;
@@ -82,6 +85,8 @@ public:
 
   // return value of rate constant at T
   virtual double get_k(double T, double R = constant::r ) const;
+  // put the prefactor and activation energy into the arguments
+  virtual void get_arrhenius(double& prefactor, double& energy) const;
 
   // virtual function for output
   virtual CH_STD::string stringify() const;
@@ -112,11 +117,57 @@ public:
 
   // return value of rate constant at T
   virtual double get_k(double T, double R = constant::r ) const;
+  // put the prefactor and activation energy into the arguments
+  virtual void get_arrhenius(double& prefactor, double& energy) const;
 
   // virtual function for output
   virtual CH_STD::string stringify() const;
 }; // end class k_lfer
 
+// remember the last value of a rate constant so it is only evaluated
+// again when the temperature or a parameter value changes
+class k_cache
+{
+  const k* rate;		// rate constant whose value is remembered
+  bool valid;			// whether VALUE has been evaluated
+  double T;			// temperature VALUE was evaluated at
+  double R;			// gas constant VALUE was evaluated with
+  unsigned long generation;	// parameter generation VALUE was evaluated in
+  double value;			// value of RATE at T
+
+private:
+  // prevent assignment
+  k_cache& operator=(const k_cache&);
+public:
+  // ctor: (default) remember values of RATE_
+  explicit k_cache(const k* rate_ = 0);
+  // ctor: copy
+  k_cache(const k_cache& original);
+  // dtor: do nothing, rate constant is owned by someone else
+  ~k_cache();
+
+  // return value of rate constant at T, evaluating it only if needed
+  double get_k(double T_, double R_ = constant::r);
+}; // end class k_cache
+
+// inline functions
+// return value of rate constant at T, evaluating it only if needed
+inline double
+k_cache::get_k(double T_, double R_)
+{
+  // see if the last value is still good
+  if (!valid || T_ != T || R_ != R ||
+      generation != parameter::get_generation())
+    {
+      value = rate->get_k(T_, R_);
+      T = T_;
+      R = R_;
+      generation = parameter::get_generation();
+      valid = true;
+    }
+  return value;
+}
+
 CH_END_NAMESPACE
 
 #endif // not CH_K_H
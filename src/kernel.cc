@@ -0,0 +1,470 @@
+// Methods for the rate expressions of a mechanism, flattened into arrays.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "kernel.h"
+#include <algorithm>
+#include <cmath>
+#include "k.h"
+#include "parameter.h"
+#include "t_string.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// static instance variables
+const unsigned int rate_kernel::lanes;
+rate_kernel::multiply_function rate_kernel::multiply(0);
+CH_STD::string rate_kernel::instruction_set;
+
+// rate_kernel methods
+// ctor: (default) no mechanism
+rate_kernel::rate_kernel()
+  : speciess(), reactions(), directions(0U), slots(0U), prefactors(),
+    energies(), constants(), constants_valid(false), constants_T(0.0e0),
+    constants_R(0.0e0), generation(0UL), factor_species(), factor_order(),
+    real_direction(), real_species(), real_power(), net_start(),
+    net_species(), net_coefficient(), quantities(), products(), rates(),
+    changes()
+{}
+
+// dtor: do nothing
+rate_kernel::~rate_kernel()
+{}
+
+// rate_kernel private methods
+// add the terms of the rate of one direction of a reaction to FACTORS
+/* A term whose power is a small whole number is a factor of the
+ * product; any other is listed apart, to be applied with pow().
+ */
+bool
+rate_kernel::compile_terms(unsigned int direction,
+			   const stoich_map& coeff_species,
+			   const CH_STD::map<species*,unsigned int>& index,
+			   factor_seq& factors)
+{
+  for (stoich_map_citer it(coeff_species.begin()); it != coeff_species.end();
+       ++it)
+    {
+      CH_STD::map<species*,unsigned int>::const_iterator
+	found(index.find(it->first));
+      if (found == index.end())
+	{
+	  return false;
+	}
+      int order(it->second.get_order());
+      if (order < 0)
+	{
+	  real_direction.push_back(direction);
+	  real_species.push_back(found->second);
+	  real_power.push_back(it->second.get_power());
+	}
+      else if (order > 0)
+	{
+	  factors[direction].push_back(CH_STD::make_pair(found->second,
+							 order));
+	}
+    }
+  return true;
+}
+
+// find the rate constants of every direction at temperature T
+/* The prefactors and energies are only asked of the rate constants
+ * again when a parameter has changed; otherwise this is one loop of
+ * exp(), the same expression k_arrhenius::get_k() evaluates.
+ */
+void
+rate_kernel::find_constants(double T, double R)
+{
+  if (!constants_valid || generation != parameter::get_generation())
+    {
+      for (unsigned int r(0U); r < reactions.size(); ++r)
+	{
+	  const k* forward(reactions[r]->get_forward_constant());
+	  forward->get_arrhenius(prefactors[2U * r], energies[2U * r]);
+	  const k* reverse(reactions[r]->get_reverse_constant());
+	  if (reverse != 0)
+	    {
+	      reverse->get_arrhenius(prefactors[2U * r + 1U],
+				     energies[2U * r + 1U]);
+	    }
+	}
+      generation = parameter::get_generation();
+    }
+  double RT(R * T);
+  for (unsigned int j(0U); j < directions; ++j)
+    {
+      constants[j] = prefactors[j] * CH_STD::exp(-energies[j] / RT);
+    }
+  constants_valid = true;
+  constants_T = T;
+  constants_R = R;
+  return;
+}
+
+// multiply the constants by the factors, a block at a time
+/* Each factor is its quantity multiplied in ORDER times, one more time
+ * for each power up to the largest, by the quantity or by one, which is
+ * exactly what raise() gives.  Every direction of a block does the same
+ * operations, so the compiler can put the lanes of the block in vector
+ * registers.
+ */
+#ifdef CXX_HAVE_TARGET_ATTRIBUTE
+__attribute__((always_inline))
+#endif // CXX_HAVE_TARGET_ATTRIBUTE
+inline void
+rate_kernel::multiply_blocks(unsigned int directions, unsigned int slots,
+			     const unsigned int* factor_species,
+			     const int* factor_order, const double* quantities,
+			     const double* constants, double* products)
+{
+  for (unsigned int b(0U); b < directions; b += lanes)
+    {
+      double block[lanes];
+      for (unsigned int l(0U); l < lanes; ++l)
+	{
+	  block[l] = constants[b + l];
+	}
+      for (unsigned int s(0U); s < slots; ++s)
+	{
+	  const unsigned int* slot_species(factor_species + s * directions + b);
+	  const int* slot_order(factor_order + s * directions + b);
+	  for (unsigned int l(0U); l < lanes; ++l)
+	    {
+	      double amount(quantities[slot_species[l]]);
+	      double factor(1.0e0);
+	      for (int o(0); o < stoichiometric::max_order; ++o)
+		{
+		  factor *= (o < slot_order[l]) ? amount : 1.0e0;
+		}
+	      block[l] *= factor;
+	    }
+	}
+      for (unsigned int l(0U); l < lanes; ++l)
+	{
+	  products[b + l] = block[l];
+	}
+    }
+  return;
+}
+
+// multiply_blocks() for any processor
+void
+rate_kernel::multiply_generic(unsigned int directions, unsigned int slots,
+			      const unsigned int* factor_species,
+			      const int* factor_order,
+			      const double* quantities,
+			      const double* constants, double* products)
+{
+  multiply_blocks(directions, slots, factor_species, factor_order,
+		  quantities, constants, products);
+  return;
+}
+
+#ifdef CXX_HAVE_TARGET_ATTRIBUTE
+// multiply_blocks() for processors with AVX2
+__attribute__((target("avx2"))) void
+rate_kernel::multiply_avx2(unsigned int directions, unsigned int slots,
+			   const unsigned int* factor_species,
+			   const int* factor_order, const double* quantities,
+			   const double* constants, double* products)
+{
+  multiply_blocks(directions, slots, factor_species, factor_order,
+		  quantities, constants, products);
+  return;
+}
+
+// multiply_blocks() for processors with AVX-512
+__attribute__((target("avx512f"))) void
+rate_kernel::multiply_avx512f(unsigned int directions, unsigned int slots,
+			      const unsigned int* factor_species,
+			      const int* factor_order,
+			      const double* quantities,
+			      const double* constants, double* products)
+{
+  multiply_blocks(directions, slots, factor_species, factor_order,
+		  quantities, constants, products);
+  return;
+}
+#endif // CXX_HAVE_TARGET_ATTRIBUTE
+
+// rate_kernel public methods
+// flatten the reactions of the species
+/* The factors of each direction are in the order of its stoich_map, so
+ * the rates are those of model_reaction::get_net_rate() exactly, unless
+ * a power is not a small whole number.  The directions past the last
+ * reaction, and the reverse directions of reactions that are not
+ * reversible, have no rate constant, so their products are zero.
+ */
+void
+rate_kernel::compile(const model_species::seq& species_list,
+		     const model_reaction::seq& reaction_list)
+  throw (bad_pointer)
+{
+  speciess = species_list;
+  reactions = reaction_list;
+  CH_STD::map<species*,unsigned int> index;
+  for (unsigned int i(0U); i < speciess.size(); ++i)
+    {
+      index[speciess[i]] = i;
+    }
+  directions = (2U * reactions.size() + lanes - 1U) / lanes * lanes;
+  prefactors.assign(directions, 0.0e0);
+  energies.assign(directions, 0.0e0);
+  constants.assign(directions, 0.0e0);
+  constants_valid = false;
+  factor_seq factors(directions);
+  real_direction.clear();
+  real_species.clear();
+  real_power.clear();
+  net_start.assign(1U, 0U);
+  net_species.clear();
+  net_coefficient.clear();
+  for (unsigned int r(0U); r < reactions.size(); ++r)
+    {
+      if (reactions[r]->get_forward_constant() == 0)
+	{
+	  throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			    ":rate_kernel::compile(): forward rate constant "
+			    "pointer points to null in reaction: " +
+			    reactions[r]->stringify());
+	}
+      // a reaction that is not reversible has no terms in reverse
+      bool found(compile_terms(2U * r, reactions[r]->get_reactants(), index,
+			       factors));
+      if (found && reactions[r]->is_reversible())
+	{
+	  found = compile_terms(2U * r + 1U, reactions[r]->get_products(),
+				index, factors);
+	}
+      if (!found)
+	{
+	  throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			    ":rate_kernel::compile(): species of reaction "
+			    "not in the list of species: " +
+			    reactions[r]->stringify());
+	}
+      const stoich_map& net(reactions[r]->get_net_coefficients());
+      for (stoich_map_citer it(net.begin()); it != net.end(); ++it)
+	{
+	  // species the reaction does not change are left out
+	  if (it->second.get_coefficient() == 0.0e0)
+	    {
+	      continue;		// for (it)
+	    }
+	  net_species.push_back(index[it->first]);
+	  net_coefficient.push_back(it->second.get_coefficient());
+	}
+      net_start.push_back(net_species.size());
+    }
+  // store factor s of every direction together, unused ones with power 0
+  slots = 0U;
+  for (unsigned int j(0U); j < directions; ++j)
+    {
+      slots = CH_STD::max(slots, static_cast<unsigned int>(factors[j].size()));
+    }
+  factor_species.assign(slots * directions, 0U);
+  factor_order.assign(slots * directions, 0);
+  for (unsigned int j(0U); j < directions; ++j)
+    {
+      for (unsigned int s(0U); s < factors[j].size(); ++s)
+	{
+	  factor_species[s * directions + j] = factors[j][s].first;
+	  factor_order[s * directions + j] = factors[j][s].second;
+	}
+    }
+  quantities.assign(speciess.size(), 0.0e0);
+  products.assign(directions, 0.0e0);
+  rates.assign(reactions.size(), 0.0e0);
+  changes.assign(speciess.size(), 0.0e0);
+  // use the best instruction set unless one was chosen
+  if (multiply == 0)
+    {
+      set_instruction_set(get_instruction_sets().back());
+    }
+  return;
+}
+
+// copy the quantities of the species into the dense vector
+void
+rate_kernel::gather()
+  throw (bad_type)
+{
+  quantity::type type(model_reaction::get_amount_type());
+  for (unsigned int i(0U); i < speciess.size(); ++i)
+    {
+      quantities[i] = speciess[i]->get_quantity(type);
+    }
+  return;
+}
+
+// find the rates and rates of change at temperature T
+// defaults R = 8.314e-3 kJ/molK
+void
+rate_kernel::evaluate(double T, double R)
+{
+  if (!constants_valid || T != constants_T || R != constants_R ||
+      generation != parameter::get_generation())
+    {
+      find_constants(T, R);
+    }
+  if (directions > 0U)
+    {
+      (*multiply)(directions, slots,
+		  (slots > 0U) ? &factor_species[0] : 0,
+		  (slots > 0U) ? &factor_order[0] : 0,
+		  quantities.empty() ? 0 : &quantities[0], &constants[0],
+		  &products[0]);
+    }
+  for (unsigned int t(0U); t < real_direction.size(); ++t)
+    {
+      products[real_direction[t]] *= CH_STD::pow(quantities[real_species[t]],
+						 real_power[t]);
+    }
+  // net rates, added into the rates of change of their species
+  CH_STD::fill(changes.begin(), changes.end(), 0.0e0);
+  for (unsigned int r(0U); r < reactions.size(); ++r)
+    {
+      double rate(products[2U * r] - products[2U * r + 1U]);
+      rates[r] = rate;
+      for (unsigned int n(net_start[r]); n < net_start[r + 1U]; ++n)
+	{
+	  changes[net_species[n]] += net_coefficient[n] * rate;
+	}
+    }
+  return;
+}
+
+// set the derivative of each species to its rate of change
+void
+rate_kernel::scatter()
+{
+  for (unsigned int i(0U); i < speciess.size(); ++i)
+    {
+      speciess[i]->set_derivative(changes[i]);
+    }
+  return;
+}
+
+// gather(), evaluate() and scatter()
+// defaults R = 8.314e-3 kJ/molK
+void
+rate_kernel::rate_derivatives(double T, double R)
+  throw (bad_type)
+{
+  gather();
+  evaluate(T, R);
+  scatter();
+  return;
+}
+
+// return the number of species
+unsigned int
+rate_kernel::get_total_species() const
+{
+  return speciess.size();
+}
+
+// return the number of reactions
+unsigned int
+rate_kernel::get_total_reactions() const
+{
+  return reactions.size();
+}
+
+// return the quantities, in the order of the species
+CH_STD::vector<double>&
+rate_kernel::get_quantities()
+{
+  return quantities;
+}
+
+// return the net rates, in the order of the reactions
+const CH_STD::vector<double>&
+rate_kernel::get_rates() const
+{
+  return rates;
+}
+
+// return the rates of change, in the order of the species
+const CH_STD::vector<double>&
+rate_kernel::get_changes() const
+{
+  return changes;
+}
+
+// return the names of the instruction sets this processor can use
+CH_STD::vector<CH_STD::string>
+rate_kernel::get_instruction_sets()
+{
+  CH_STD::vector<CH_STD::string> sets(1U, "generic");
+#ifdef CXX_HAVE_TARGET_ATTRIBUTE
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    {
+      sets.push_back("avx2");
+    }
+  if (__builtin_cpu_supports("avx512f"))
+    {
+      sets.push_back("avx512f");
+    }
+#endif // CXX_HAVE_TARGET_ATTRIBUTE
+  return sets;
+}
+
+// return the name of the instruction set the products are found with
+const CH_STD::string&
+rate_kernel::get_instruction_set()
+{
+  return instruction_set;
+}
+
+// find the products with the instruction set NAME, return false if the
+// processor cannot
+bool
+rate_kernel::set_instruction_set(const CH_STD::string& name)
+{
+  CH_STD::vector<CH_STD::string> sets(get_instruction_sets());
+  if (CH_STD::find(sets.begin(), sets.end(), name) == sets.end())
+    {
+      return false;
+    }
+  // else
+  multiply = &multiply_generic;
+#ifdef CXX_HAVE_TARGET_ATTRIBUTE
+  if (name == "avx2")
+    {
+      multiply = &multiply_avx2;
+    }
+  else if (name == "avx512f")
+    {
+      multiply = &multiply_avx512f;
+    }
+#endif // CXX_HAVE_TARGET_ATTRIBUTE
+  instruction_set = name;
+  return true;
+}
+
+CH_END_NAMESPACE
+
+/* $Id$ */
@@ -0,0 +1,180 @@
+// -*- C++ -*-
+// Class for the rate expressions of a mechanism, flattened into arrays.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_KERNEL_H
+#define CH_KERNEL_H 1
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "constant.h"
+#include "except.h"
+#include "reaction.h"
+#include "species.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// the rate expressions and net stoichiometry of all the reactions of a
+// mechanism, compiled once into flat arrays
+//
+// Each species is known by its index in the list of species, and its
+// quantity is kept in one dense vector.  Each direction of each reaction
+// (forward, then reverse) has a rate constant, prefactor times
+// exp(-energy / RT), and the factors of its mass-action product, the
+// quantities of its species to their whole-number powers.  Factor s of
+// every direction is stored together, so the rates of a block of
+// directions are multiplied up side by side, one factor at a time, with
+// no branches; that loop is compiled for each instruction set the
+// compiler can target and the best one the processor has is chosen when
+// the program runs.  The rate constants are found together, only when
+// the temperature or a parameter changes, and the rare powers that are
+// not small whole numbers are applied afterwards.
+class rate_kernel
+{
+public:
+  // set up typedef's
+  typedef CH_STD::vector<unsigned int> index_seq;
+  typedef CH_STD::vector<CH_STD::vector<CH_STD::pair<unsigned int,int> > >
+    factor_seq;
+  // find PRODUCTS, CONSTANTS times the factors (see multiply_blocks())
+  typedef void (*multiply_function)(unsigned int directions,
+				    unsigned int slots,
+				    const unsigned int* factor_species,
+				    const int* factor_order,
+				    const double* quantities,
+				    const double* constants, double* products);
+
+  // static instance variables
+  static const unsigned int lanes = 8U; // directions in a block
+
+private:
+  model_species::seq speciess;	// species, in the order of their index
+  model_reaction::seq reactions; // reactions, in the order of their rates
+  unsigned int directions;	// both directions of every reaction, made up
+				// to a whole number of blocks
+  unsigned int slots;		// most factors of any direction
+  CH_STD::vector<double> prefactors; // of the rate constant of each direction
+  CH_STD::vector<double> energies; // activation energy of each direction
+  CH_STD::vector<double> constants; // rate constant of each direction
+  bool constants_valid;		// whether CONSTANTS have been found
+  double constants_T;		// temperature they were found at
+  double constants_R;		// gas constant they were found with
+  unsigned long generation;	// parameter generation of the prefactors
+  index_seq factor_species;	// species of each factor, by slot
+  CH_STD::vector<int> factor_order; // its power (0 in an unused slot)
+  index_seq real_direction;	// direction of each term whose power is not
+  index_seq real_species;	// a small whole number, its species
+  CH_STD::vector<double> real_power; // and its power
+  index_seq net_start;		// first net coefficient of each reaction
+  index_seq net_species;	// index of the species of each
+  CH_STD::vector<double> net_coefficient; // net coefficient of each
+  CH_STD::vector<double> quantities; // of the species
+  CH_STD::vector<double> products; // rate of each direction
+  CH_STD::vector<double> rates;	// net rate of each reaction
+  CH_STD::vector<double> changes; // rate of change of each species
+  static multiply_function multiply; // loop used to find the products
+  static CH_STD::string instruction_set; // what it was compiled for
+
+private:
+  // prevent copy construction and assignment
+  rate_kernel(const rate_kernel&);
+  rate_kernel& operator=(const rate_kernel&);
+  // add the terms of the rate of direction DIRECTION, the species in
+  // COEFF_SPECIES found in INDEX, to FACTORS (by direction), return
+  // false if a species is not in the list
+  bool compile_terms(unsigned int direction, const stoich_map& coeff_species,
+		     const CH_STD::map<species*,unsigned int>& index,
+		     factor_seq& factors);
+  // find the rate constants of every direction at temperature T
+  void find_constants(double T, double R);
+  // multiply the constants by the factors, a block at a time
+  static void multiply_blocks(unsigned int directions, unsigned int slots,
+			      const unsigned int* factor_species,
+			      const int* factor_order,
+			      const double* quantities,
+			      const double* constants, double* products);
+  // multiply_blocks() compiled for each instruction set
+  static void multiply_generic(unsigned int directions, unsigned int slots,
+			       const unsigned int* factor_species,
+			       const int* factor_order,
+			       const double* quantities,
+			       const double* constants, double* products);
+#ifdef CXX_HAVE_TARGET_ATTRIBUTE
+  static void multiply_avx2(unsigned int directions, unsigned int slots,
+			    const unsigned int* factor_species,
+			    const int* factor_order, const double* quantities,
+			    const double* constants, double* products);
+  static void multiply_avx512f(unsigned int directions, unsigned int slots,
+			       const unsigned int* factor_species,
+			       const int* factor_order,
+			       const double* quantities,
+			       const double* constants, double* products);
+#endif // CXX_HAVE_TARGET_ATTRIBUTE
+public:
+  // ctor: (default) no mechanism
+  rate_kernel();
+  // dtor: do nothing
+  ~rate_kernel();
+
+  // flatten the reactions REACTION_LIST of the species SPECIES_LIST
+  void compile(const model_species::seq& species_list,
+	       const model_reaction::seq& reaction_list)
+    throw (bad_pointer); // this
+  // copy the quantities of the species (of model_reaction's amount type)
+  // into the dense vector
+  void gather()
+    throw (bad_type); // model_species::get_quantity()
+  // find the rates and rates of change at temperature T from the
+  // quantities in the dense vector
+  void evaluate(double T, double R = constant::r);
+  // set the derivative of each species to its rate of change
+  void scatter();
+  // gather(), evaluate() and scatter(), the way model_reaction::
+  // rate_derivatives() for each reaction would
+  void rate_derivatives(double T, double R = constant::r)
+    throw (bad_type); // gather()
+  // return the number of species
+  unsigned int get_total_species() const;
+  // return the number of reactions
+  unsigned int get_total_reactions() const;
+  // return the quantities, in the order of the species
+  CH_STD::vector<double>& get_quantities();
+  // return the net rates, in the order of the reactions
+  const CH_STD::vector<double>& get_rates() const;
+  // return the rates of change, in the order of the species
+  const CH_STD::vector<double>& get_changes() const;
+  // return the names of the instruction sets this processor can find
+  // the products with, the best last
+  static CH_STD::vector<CH_STD::string> get_instruction_sets();
+  // return the name of the instruction set the products are found with
+  static const CH_STD::string& get_instruction_set();
+  // find the products with the instruction set NAME, return false (and
+  // change nothing) if the processor cannot
+  static bool set_instruction_set(const CH_STD::string& name);
+}; // end class rate_kernel
+
+CH_END_NAMESPACE
+
+#endif // not CH_KERNEL_H
+
+/* $Id$ */
@@ -164,115 +164,15 @@ double
 batch_reactor::reactor_eqn(model_species* species)
   throw (bad_type)
 {
-  // set up variables to reduce function calls
-  double rate(species->get_derivative());
-  double yprime(0.0e0);
-
-  // surface species equations
-  if (species->get_surface_coordination() > 0U)
-    {
-      if (amount_type == Emoles)
-	{
-	  // multiply rate by Avogadro's number
-	  // think of coverage as molecules/site (N_i/Ns)
-	  rate *= constant::avogadro;
-	}
-      switch (size_type)
-	{
-	case Evolume:
-	  // y_i' = r_i * V / Ns
-	  yprime = rate * get_volume() / get_sites();
-	  break;
-
-	case Eweight:
-	  // y_i' = r_i * W / Ns
-	  yprime = rate * get_weight() / get_sites();
-	  break;
-
-	case Esites:
-	  // no modifications: y_i' = r_i
-	  break;
-
-	default:		// throw an exception
-	  throw bad_type(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
-			 ":batch_reactor::reactor_eqn(): the denominator of "
-			 "the rate expression has invalid units");
-	  break;
-	}
-    }
-  // pressure equations
-  else if (fluid_type == quantity::Epressure)
-    {
-      if (amount_type == Emolecules)
-	{
-	  // divide rate by Avogadro's number
-	  rate /= constant::avogadro;
-	}
-      switch (size_type)
-	{
-	case Evolume:
-	  // y_i' = r_i * RT + (p_i / T) dT/dt
-	  yprime = rate * constant::r * get_temperature();
-	  break;
-
-	case Eweight:
-	  // y_i' = r_i * RTW/V + (p_i / T) dT/dt
-	  yprime = rate * constant::r * get_temperature() * get_weight()
-	    / get_volume();
-	  break;
-
-	case Esites:
-	  // y_i' = r_i * RTNs/V + (p_i / T) dT/dt
-	  yprime = rate * constant::r * get_temperature() * get_sites()
-	    / get_volume();
-	  break;
-
-	default:		// throw an exception
-	  throw bad_type(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
-			 ":batch_reactor::reactor_eqn(): the denominator of "
-			 "the rate expression has invalid units");
-	  break;
-	}
-      // correct for any change in temperature
-      // all pressure equations have a `+ (p_i / T) * dT/dt' term
-      yprime += species->get_quantity(quantity::Epressure) / get_temperature()
-	* get_heating_rate();
-    }
-  // concentration equations
-  else if (fluid_type == quantity::Econcentration)
+  // put the rate in the units of the quantity
+  double yprime(design_rate(species));
+  // correct for any change in temperature
+  // all pressure equations have a `+ (p_i / T) * dT/dt' term
+  if (species->get_surface_coordination() == 0U
+      && fluid_type == quantity::Epressure)
     {
-      if (amount_type == Emolecules)
-	{
-	  // divide rate by Avogadro's number
-	  rate /= constant::avogadro;
-	}
-      switch (size_type)
-	{
-	case Evolume:
-	  // no modifications for Evolume: y_i' = r_i
-	  break;
-
-	case Eweight:
-	  // y_i' = r_i * (W / V)
-	  yprime = rate * get_weight() / get_volume();
-	  break;
-
-	case Esites:
-	  // y_i' = r_i * (Ns / V)
-	  yprime = rate * get_sites() / get_volume();
-	  break;
-
-	default:		// throw an exception
-	  throw bad_type(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
-			 ":batch_reactor::reactor_eqn(): the denominator of "
-			 "the rate expression has invalid units");
-	}
-    }
-  else				// throw an exception
-    {
-      throw bad_type(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
-		     ":batch_reactor::reactor_eqn(): the units of the "
-		     "derivative are invalid for a batch reactor");
+      yprime += species->get_quantity(quantity::Epressure)
+	/ get_temperature() * get_heating_rate();
     }
   // set the derivative to the calculated value
   species->set_derivative(yprime);
@@ -280,6 +180,22 @@ batch_reactor::reactor_eqn(model_species* species)
   return yprime;
 }
 
+// return the change in the reactor equation per unit of rate and quantity
+double
+batch_reactor::reactor_eqn_slope(model_species* species,
+				 double& quantity_slope)
+  throw (bad_type)
+{
+  double slope(reactor::reactor_eqn_slope(species, quantity_slope));
+  // pressures change with the temperature, (p_i / T) dT/dt
+  if (species->get_surface_coordination() == 0U
+      && fluid_type == quantity::Epressure)
+    {
+      quantity_slope = get_heating_rate() / get_temperature();
+    }
+  return slope;
+}
+
 // update an individual gas-phase species
 void
 batch_reactor::kmc_step(model_species* msp, double dx, double T0, double T1)
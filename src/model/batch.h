@@ -51,7 +51,13 @@ public:
   virtual reactor* copy();
   // modify derivative according to the reactor design equations
   virtual double reactor_eqn(model_species* species)
-    throw (bad_type); // this, fluid_quantity::get_quantity()
+    throw (bad_type); // reactor::design_rate(),
+				// fluid_quantity::get_quantity()
+  // return the change in the reactor equation of SPECIES per unit of
+  // its rate, and put that per unit of its quantity into QUANTITY_SLOPE
+  virtual double reactor_eqn_slope(model_species* species,
+				   double& quantity_slope)
+    throw (bad_type); // reactor::reactor_eqn_slope()
   // update an individual gas-phase species
   virtual void kmc_step(model_species* msp, double dx, double T0, double T1)
     throw (bad_type, bad_value); // this, fluid_quantity::set_quantity()
@@ -0,0 +1,303 @@
+// Timing of the ways of evaluating the rates of the reactions.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "compare.h"
+#include "debug.h"
+#include "kernel.h"
+#include "reaction.h"
+#include "reactor.h"
+#include "t_string.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// benchmark methods
+// ctor: (default) a thousand evaluations
+benchmark::benchmark()
+  : integrator(), evaluations(1000U), timed(false), difference(0.0e0),
+    times()
+{}
+
+// ctor: copy the number of evaluations
+benchmark::benchmark(const benchmark& o)
+  throw (bad_pointer)
+  : integrator(o), evaluations(o.evaluations), timed(false),
+    difference(0.0e0), times()
+{}
+
+// dtor: do nothing
+benchmark::~benchmark()
+{}
+
+// benchmark private methods
+// time each way the first time, and return XF
+double
+benchmark::step(double /* xi */, double xf)
+  throw (bad_pointer, bad_type)
+{
+  if (!timed)
+    {
+      time_rates();
+      timed = true;
+    }
+  return xf;
+}
+
+// output the column headings, followed by that of the difference
+void
+benchmark::output_header()
+{
+  // call base class method
+  integrator::output_header();
+  // output header for the difference
+  *out_file << "\tdifference" << CH_STD::endl;
+  return;
+}
+
+// output the current output point and its values to *out_file
+void
+benchmark::output(double x_)
+  throw (bad_type, bad_request, bad_value, bad_file)
+{
+  output(x_, *out_file);
+  return;
+}
+
+// output the current output point, its values and the difference
+void
+benchmark::output(double x_, CH_STD::ostream& output_stream)
+  throw (bad_type, bad_request, bad_value, bad_file)
+{
+  // call base class method
+  integrator::output(x_, output_stream);
+  // output the largest relative difference
+  output_stream << '\t' << difference << '\n';
+  return;
+}
+
+// report the times, if debugging
+void
+benchmark::finish()
+  throw (bad_file)
+{
+  if (debug::get().get_level() > 0U)
+    {
+      debug::get().get_stream() << "benchmark: " << evaluations
+				<< " evaluations of "
+				<< mech->get_kernel().get_total_reactions()
+				<< " reactions, largest relative difference "
+				<< difference << CH_STD::endl;
+      times.report(debug::get().get_stream(), "benchmark:", evaluations);
+    }
+  return;
+}
+
+// find the rates of change by asking each reaction for its rate
+/* Every other evaluation with a changing temperature is just above the
+ * temperature of the reactor, so each finds its rate constants again.
+ */
+void
+benchmark::time_reactions(CH_STD::vector<double>& changes)
+  throw (bad_pointer, bad_type)
+{
+  double T(state_info->get_reactor()->get_temperature());
+  model_species::seq species(mech->species_seq_begin(),
+			     mech->species_seq_end());
+  for (unsigned int pass(0U); pass < 2U; ++pass)
+    {
+      for (unsigned int e(0U); e < evaluations; ++e)
+	{
+	  double T_e((pass > 0U && e % 2U == 0U) ? T * (1.0e0 + 1.0e-9) : T);
+	  for (model_species::seq_iter it(species.begin());
+	       it != species.end(); ++it)
+	    {
+	      (*it)->set_derivative(0.0e0);
+	    }
+	  for (model_reaction::seq_citer it(mech->reaction_seq_begin());
+	       it != mech->reaction_seq_end(); ++it)
+	    {
+	      (*it)->rate_derivatives(T_e);
+	    }
+	}
+      times.mark((pass > 0U) ? "per reaction, changing T" : "per reaction");
+      // keep those found at the temperature of the reactor
+      if (pass == 0U)
+	{
+	  for (unsigned int i(0U); i < species.size(); ++i)
+	    {
+	      changes[i] = species[i]->get_derivative();
+	    }
+	}
+    }
+  return;
+}
+
+// find the rates of change with the rate kernel
+void
+benchmark::time_kernel(CH_STD::vector<double>& changes)
+  throw (bad_type)
+{
+  double T(state_info->get_reactor()->get_temperature());
+  rate_kernel& kernel(mech->get_kernel());
+  const CH_STD::string& name(rate_kernel::get_instruction_set());
+  for (unsigned int pass(0U); pass < 2U; ++pass)
+    {
+      for (unsigned int e(0U); e < evaluations; ++e)
+	{
+	  double T_e((pass > 0U && e % 2U == 0U) ? T * (1.0e0 + 1.0e-9) : T);
+	  kernel.rate_derivatives(T_e);
+	}
+      times.mark("kernel " + name + ((pass > 0U) ? ", changing T" : ""));
+      // keep those found at the temperature of the reactor
+      if (pass == 0U)
+	{
+	  changes = kernel.get_changes();
+	}
+    }
+  return;
+}
+
+// time each way and find the largest difference between them
+void
+benchmark::time_rates()
+  throw (bad_pointer, bad_type)
+{
+  unsigned int n(mech->get_kernel().get_total_species());
+  CH_STD::vector<double> reference(n);
+  CH_STD::vector<double> changes(n);
+  times.start();
+  time_reactions(reference);
+  // try every instruction set, then go back to the one in use
+  CH_STD::string in_use(rate_kernel::get_instruction_set());
+  CH_STD::vector<CH_STD::string> sets(rate_kernel::get_instruction_sets());
+  difference = 0.0e0;
+  for (CH_STD::vector<CH_STD::string>::const_iterator it(sets.begin());
+       it != sets.end(); ++it)
+    {
+      rate_kernel::set_instruction_set(*it);
+      time_kernel(changes);
+      for (unsigned int i(0U); i < n; ++i)
+	{
+	  double size(CH_STD::max(CH_STD::fabs(reference[i]),
+				  CH_STD::fabs(changes[i])));
+	  if (size > 0.0e0)
+	    {
+	      difference = CH_STD::max(difference,
+					CH_STD::fabs(changes[i] - reference[i])
+					/ size);
+	    }
+	}
+    }
+  rate_kernel::set_instruction_set(in_use);
+  return;
+}
+
+// benchmark public methods
+// parse integrator input
+void
+benchmark::parse(token_seq_citer& token_it, token_seq_citer end)
+  throw (bad_input, bad_request, bad_value, bad_type, bad_pointer)
+{
+  // loop through input
+  while (token_it != end)
+    {
+      if (icompare(*token_it, "begin") == 0)
+	{
+	  ++token_it;		// next token
+	  if (icompare(*token_it, "state") == 0)
+	    {
+	      // call the state parser
+	      state_info->parse(++token_it, end);
+	      continue;		// while ()
+	    }
+	  else
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":benchmark::parse(): syntax error in input "
+			      "for integrator: do not know how to begin "
+			      + *token_it);
+	    }
+	}
+      // set the number of times each way is timed
+      else if (icompare(*token_it, "evaluations") == 0)
+	{
+	  int count(CH_STD::atoi((++token_it)->c_str()));
+	  if (count < 1)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":benchmark::parse(): syntax error in input "
+			      "for integrator: evaluations must be "
+			      "positive: " + *token_it);
+	    }
+	  evaluations = (unsigned int) count;
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      else if (icompare(*token_it, "end") == 0)
+	{
+	  // make sure it is the end of integrator input
+	  if (icompare(*++token_it, "integrator") != 0)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":benchmark::parse(): syntax error in input "
+			      "for integrator: corresponding end token does "
+			      "not end an integrator: " + *token_it);
+	    }
+	  // increment one further
+	  ++token_it;
+	  // return to caller
+	  return;
+	}
+      else
+	{
+	  throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			  ":benchmark::parse(): syntax error in input "
+			  "for integrator: unrecognized token: "
+			  + *token_it);
+	}
+    }
+  // end of file reached
+  throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		  "benchmark::parse(): syntax error in input for integrator: "
+		  "end of file reached while parsing input");
+  // shouldn't get here
+  return;
+}
+
+// create a copy of this benchmark, return pointer to it
+integrator*
+benchmark::copy() const
+  throw (bad_pointer)
+{
+  return new benchmark(*this);
+}
+
+CH_END_NAMESPACE
+
+/* $Id$ */
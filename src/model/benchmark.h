@@ -0,0 +1,104 @@
+// -*- C++ -*-
+// Timing of the ways of evaluating the rates of the reactions.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_MODEL_BENCHMARK_H
+#define CH_MODEL_BENCHMARK_H 1
+
+#include <vector>
+#include "except.h"
+#include "integrate.h"
+#include "profile.h"
+#include "species.h"
+#include "token.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// class timing the ways of finding the rates of change of the species
+// from the initial state
+//
+// The rates of change are found over and over, by asking each reaction
+// for its rate (model_reaction::rate_derivatives()) and by the rate
+// kernel of the mechanism with each instruction set the processor has,
+// first at the temperature of the reactor, when the rate constants need
+// not be found again, and then at a temperature changed every time, as
+// in a ramp.  The times, and those of a single evaluation, are reported
+// when debugging.  The quantities do not change; the output adds the
+// largest relative difference between the rates of change found each
+// way.
+class benchmark : public integrator
+{
+  unsigned int evaluations;	// times each way is timed
+  bool timed;			// have the ways been timed
+  double difference;		// largest relative difference between them
+  profile times;		// time taken each way
+
+private:
+  // prevent assignment
+  benchmark& operator=(const benchmark&);
+  // ctor: copy
+  explicit benchmark(const benchmark& original)
+    throw (bad_pointer); // integrator::integrator()
+  // time each way the first time, and return XF
+  virtual double step(double xi, double xf)
+    throw (bad_pointer, bad_type); // time_rates()
+  // output the column headings, followed by that of the difference
+  virtual void output_header();
+  // output the current output point and its values to *out_file
+  virtual void output(double x_)
+    throw (bad_type, bad_request, bad_value, bad_file); // output()
+  // output the current output point, its values and the difference to
+  // the stream
+  virtual void output(double x_, CH_STD::ostream& output_stream)
+    throw (bad_type, bad_request, bad_value, bad_file);
+				// integrator::output()
+  // report the times, if debugging
+  virtual void finish()
+    throw (bad_file);
+  // find the rates of change EVALUATIONS times at the temperature of the
+  // reactor and as many changing it, put the first into CHANGES
+  void time_reactions(CH_STD::vector<double>& changes)
+    throw (bad_pointer, bad_type); // model_reaction::rate_derivatives()
+  void time_kernel(CH_STD::vector<double>& changes)
+    throw (bad_type); // rate_kernel::rate_derivatives()
+  // time each way and find the largest difference between them
+  void time_rates()
+    throw (bad_pointer, bad_type); // time_reactions(), time_kernel()
+public:
+  // ctor: (default) a thousand evaluations
+  benchmark();
+  // dtor: do nothing
+  virtual ~benchmark();
+
+  // parse integrator input
+  virtual void parse(token_seq_citer& token_it, token_seq_citer end)
+    throw (bad_input, bad_request, bad_value, bad_type, bad_pointer); // this,
+				// state::parse()
+  // create a copy of this benchmark, return pointer to it
+  virtual integrator* copy() const
+    throw (bad_pointer); // benchmark()
+}; // end class benchmark
+
+CH_END_NAMESPACE
+
+#endif // not CH_MODEL_BENCHMARK_H
+
+/* $Id$ */
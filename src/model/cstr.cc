@@ -34,11 +34,12 @@ CH_BEGIN_NAMESPACE
 // cstr methods
 // ctor: (default) call flow_reactor ctor
 cstr::cstr()
-  : flow_reactor(), flow_in()
+  : flow_reactor(), flow_in(), total_fluid(0.0e0)
 {}
 
 cstr::cstr(const cstr& original)
-  : flow_reactor(original), flow_in(original.flow_in)
+  : flow_reactor(original), flow_in(original.flow_in),
+    total_fluid(original.total_fluid)
 {}
 
 // dtor: do nothing
@@ -77,27 +78,134 @@ cstr::initialize(model_species::seq_citer species_begin,
 	    }
 	}
     }
+  // the fluids are kept at the pressure or at their initial total
+  // concentration
+  total_fluid = get_pressure();
+  if (fluid_type == quantity::Econcentration)
+    {
+      total_fluid = 0.0e0;
+      for (model_species::seq_citer it(species_begin); it != species_end; ++it)
+	{
+	  if ((*it)->get_surface_coordination() < 1U)
+	    {
+	      total_fluid += (*it)->get_quantity(quantity::Econcentration);
+	    }
+	}
+    }
   return;
 }
 
-// reactor equations for CSTR
+// reactor equations for CSTR, all but the flow out
 double
 cstr::reactor_eqn(model_species* species)
   throw (bad_type)
 {
-  // set up variables to reduce function calls
-  double rate(species->get_derivative());
-  double yprime(0.0e0);
-
-  // FIXME: put in reactor design equations
-  yprime = rate;
-
+  // put the rate in the units of the quantity
+  double yprime(design_rate(species));
+  // add any flow in
+  flow_map_citer f_in(flow_in.find(species));
+  if (f_in != flow_in.end())
+    {
+      if (fluid_type == quantity::Epressure)
+	{
+	  // get proper constant (k or R) to use
+	  // (amount_type should also be the units of flow)
+	  double gas_constant(constant::k);
+	  if (amount_type == Emoles)
+	    {
+	      gas_constant = constant::r;
+	    }
+	  // y_i' += F_i RT/V
+	  yprime += f_in->second * gas_constant * get_temperature()
+	    / get_volume();
+	}
+      else
+	{
+	  // determine if we have to convert to moles
+	  double na(1.0e0);
+	  if (amount_type == Emolecules)
+	    {
+	      na = constant::avogadro;
+	    }
+	  // y_i' += F_i/V
+	  yprime += f_in->second / (na * get_volume());
+	}
+    }
   // set the derivative to the calculated value
   species->set_derivative(yprime);
   // return the corrected derivative value
   return yprime;
 }
 
+// return the fraction of the total change of the fluids that flows out
+// with MSP
+double
+cstr::outflow_fraction(model_species* msp, double& quantity_slope) const
+  throw (bad_type)
+{
+  // nothing flows out with the surface (or with no fluids)
+  if (msp->get_surface_coordination() > 0U || !(total_fluid > 0.0e0))
+    {
+      quantity_slope = 0.0e0;
+      return 0.0e0;
+    }
+  // u_i = y_i / sum of y_j
+  quantity_slope = 1.0e0 / total_fluid;
+  return msp->get_quantity(fluid_type) / total_fluid;
+}
+
+// set the flows out for the total change of the fluids
+void
+cstr::set_outflow(const model_species::seq& species_list,
+		  double total_change)
+  throw (bad_type, bad_value)
+{
+  // put the total change in the units of flow
+  double total_flow(0.0e0);
+  if (fluid_type == quantity::Epressure)
+    {
+      // get proper constant (k or R) to use
+      double gas_constant(constant::k);
+      if (amount_type == Emoles)
+	{
+	  gas_constant = constant::r;
+	}
+      // F = V dp / RT
+      total_flow = total_change * get_volume()
+	/ (gas_constant * get_temperature());
+    }
+  else if (fluid_type == quantity::Econcentration)
+    {
+      double na(1.0e0);
+      if (amount_type == Emolecules)
+	{
+	  na = constant::avogadro;
+	}
+      // F = V dc
+      total_flow = total_change * na * get_volume();
+    }
+  else				// invalid
+    {
+      throw bad_type(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		     ":cstr::set_outflow(): the units of the "
+		     "derivative are invalid for a CSTR");
+    }
+  set_flow(total_flow);
+  // each fluid takes its share
+  for (model_species::seq_citer it(species_list.begin());
+       it != species_list.end(); ++it)
+    {
+      if ((*it)->get_surface_coordination() < 1U)
+	{
+	  double quantity_slope(0.0e0);
+	  (*it)->set_quantity(quantity::Eflow,
+			      outflow_fraction(*it, quantity_slope)
+			      * total_flow);
+	}
+    }
+  return;
+}
+
 // update everything given the time increment
 void
 cstr::kmc_step(const model_species::seq_citer species_begin,
@@ -31,6 +31,15 @@
 CH_BEGIN_NAMESPACE
 
 // class for solution of continuous stirred-tank reactor problems
+//
+// In the mean-field equations the fluids flow in at the rates they were
+// given (or in the initial proportions of the total flow) and out at
+// whatever rate keeps their total (the pressure, or the initial total
+// concentration) constant.
+// The rate of change of species i is then s_i - u_i S, where s_i, from
+// reactor_eqn(), is its change from its reactions and flow in, S the sum
+// of those over the fluids and u_i, from outflow_fraction(), its share of
+// the total.
 class cstr : public flow_reactor
 {
   // typedefs
@@ -40,6 +49,7 @@ class cstr : public flow_reactor
 
 private:
   flow_map flow_in;		// input flow rates (units of amount_type)
+  double total_fluid;		// pressure or concentration of all the fluids
 
 public:
   // ctor: (default) call flow_reactor ctor
@@ -56,9 +66,20 @@ public:
 			  model_species::seq_citer species_end)
     throw (bad_type, bad_value); // flow_reactor::initialize(),
 				// model_species::get_quantity()
-  // modify derivative according to the reactor design equations
+  // modify derivative according to the reactor design equations, all
+  // but the flow out
   virtual double reactor_eqn(model_species* species)
-    throw (bad_type);
+    throw (bad_type); // reactor::design_rate()
+  // return the fraction of the total change of the fluids that flows
+  // out with MSP, and put its change per unit of the quantity of MSP
+  // into QUANTITY_SLOPE
+  virtual double outflow_fraction(model_species* msp,
+				  double& quantity_slope) const
+    throw (bad_type); // model_species::get_quantity()
+  // set the flows out for the total change of the fluids TOTAL_CHANGE
+  virtual void set_outflow(const model_species::seq& species_list,
+			   double total_change)
+    throw (bad_type, bad_value); // this, model_species::set_quantity()
   // update everything given the time increment
   virtual void kmc_step(const model_species::seq_citer species_begin,
 			const model_species::seq_citer species_end, double dx)
@@ -0,0 +1,180 @@
+// Methods for the part of the kinetic Monte Carlo surface one thread runs.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "domain.h"
+#include <cmath>
+#include "t_string.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// domain methods
+// ctor: take ownership of RANDOM_, with TYPES buckets and LEAVES rates
+domain::domain(rng* random_, unsigned int types, unsigned int leaves)
+  throw (bad_pointer)
+  : random(random_), pool(), buckets(types), net_rates(leaves, 0.0e0),
+    rates(leaves), stale(true), events(), destroyed(), changed(),
+    foreign_destroyed(), foreign_changed()
+{
+  // make sure there is a generator
+  if (random == 0)
+    {
+      throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":domain::domain(): random number generator pointer "
+			"is zero");
+    }
+}
+
+// dtor: delete the random number generator
+domain::~domain()
+{
+  // we own the random number generator
+  delete random;
+}
+
+// domain public methods
+// return the random number generator of this domain
+rng&
+domain::get_rng()
+{
+  return *random;
+}
+
+// return the pool ensembles of this domain are taken from
+ensemble_pool&
+domain::get_pool()
+{
+  return pool;
+}
+
+// return the bucket holding the ensembles of type TYPE
+ensemble_bucket&
+domain::get_bucket(unsigned int type)
+{
+  return buckets[type];
+}
+
+// return the net rate of the reaction at leaf I
+double
+domain::get_net_rate(unsigned int i) const
+{
+  return net_rates[i];
+}
+
+// change the net rate of the reaction at leaf I
+void
+domain::set_net_rate(unsigned int i, double net_rate, bool refresh)
+  throw (bad_value)
+{
+  net_rates[i] = net_rate;
+  // the tree only holds the magnitude
+  if (refresh)
+    {
+      rates.assign(i, CH_STD::fabs(net_rate));
+    }
+  else
+    {
+      rates.set(i, CH_STD::fabs(net_rate));
+    }
+  return;
+}
+
+// recalculate the sums of the rates
+void
+domain::refresh()
+{
+  rates.refresh();
+  return;
+}
+
+// return the sum of the absolute rates of the domain
+double
+domain::total() const
+{
+  return rates.total();
+}
+
+// select a reaction at random, return its leaf and net rate
+domain::event
+domain::select()
+  throw (bad_value)
+{
+  unsigned int i(rates.find(random->get_random_open(rates.total())));
+  return CH_STD::make_pair(i, net_rates[i]);
+}
+
+// return whether all the rates must be recalculated
+bool
+domain::is_stale() const
+{
+  return stale;
+}
+
+// set whether all the rates must be recalculated, return old value
+bool
+domain::set_stale(bool stale_)
+{
+  bool old(stale);
+  stale = stale_;
+  return old;
+}
+
+// return the events performed in the current cycle
+domain::event_seq&
+domain::get_events()
+{
+  return events;
+}
+
+// return the ensembles replaced by the last event
+ensemble::seq&
+domain::get_destroyed()
+{
+  return destroyed;
+}
+
+// return the environments changed by the last event
+environment::seq&
+domain::get_changed()
+{
+  return changed;
+}
+
+// return ensembles of other domains replaced in the current cycle
+ensemble::seq&
+domain::get_foreign_destroyed()
+{
+  return foreign_destroyed;
+}
+
+// return environments of other domains changed in the current cycle
+environment::seq&
+domain::get_foreign_changed()
+{
+  return foreign_changed;
+}
+
+CH_END_NAMESPACE
+
+/* $Id: domain.cc,v 1.1.1.1 2004/11/25 20:24:08 banjo Exp $ */
@@ -0,0 +1,126 @@
+// -*- C++ -*-
+// Part of the kinetic Monte Carlo surface simulated by one thread.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_MODEL_DOMAIN_H
+#define CH_MODEL_DOMAIN_H 1
+
+#include <utility>
+#include <vector>
+#include "ensemble.h"
+#include "environment.h"
+#include "except.h"
+#include "rate_tree.h"
+#include "rng.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// a square block of the surface with its own random number generator,
+// ensemble pool, buckets (one per ensemble type) and reaction rates, so
+// events in blocks far enough apart can be performed at the same time
+class domain
+{
+public:
+  // typedef's
+  typedef CH_STD::vector<domain*> seq;
+  typedef seq::iterator seq_iter;
+  typedef seq::const_iterator seq_citer;
+  // an event performed: the leaf of the reaction and the sign of its rate
+  typedef CH_STD::pair<unsigned int,double> event;
+  typedef CH_STD::vector<event> event_seq;
+
+private:
+  rng* random;			// generator for events in this domain
+  ensemble_pool pool;		// recycled ensembles for this domain
+  // ensembles owned by environments in this domain, by type
+  CH_STD::vector<ensemble_bucket> buckets;
+  CH_STD::vector<double> net_rates; // current net rate of each reaction
+  rate_tree rates;		// absolute net rates of the reactions
+  bool stale;			// must all the rates be recalculated
+  event_seq events;		// events performed in the current cycle
+  ensemble::seq destroyed;	// ensembles replaced by the last event
+  environment::seq changed;	// environments changed by the last event
+  // ensembles and environments in other domains changed this cycle
+  ensemble::seq foreign_destroyed;
+  environment::seq foreign_changed;
+
+private:
+  // prevent copy construction and assignment
+  domain(const domain&);
+  domain& operator=(const domain&);
+public:
+  // ctor: take ownership of RANDOM_, with TYPES ensemble buckets and
+  // LEAVES reaction rates
+  domain(rng* random_, unsigned int types, unsigned int leaves)
+    throw (bad_pointer); // this
+  // dtor: delete the random number generator
+  ~domain();
+
+  // return the random number generator of this domain
+  rng& get_rng();
+  // return the pool ensembles of this domain are taken from
+  ensemble_pool& get_pool();
+  // return the bucket holding the ensembles of type TYPE
+  ensemble_bucket& get_bucket(unsigned int type);
+  // return the number of ensembles of type TYPE (zero if npos)
+  unsigned int size(unsigned int type) const;
+  // return the net rate of the reaction at leaf I
+  double get_net_rate(unsigned int i) const;
+  // change the net rate of the reaction at leaf I; if REFRESH the sums
+  // are left for refresh() to update
+  void set_net_rate(unsigned int i, double net_rate, bool refresh = false)
+    throw (bad_value); // rate_tree::set(), rate_tree::assign()
+  // recalculate the sums of the rates after set_net_rate(i, r, true)
+  void refresh();
+  // return the sum of the absolute rates of the domain
+  double total() const;
+  // select a reaction at random, return its leaf and net rate
+  event select()
+    throw (bad_value); // rate_tree::find()
+  // return whether all the rates must be recalculated
+  bool is_stale() const;
+  // set whether all the rates must be recalculated, return old value
+  bool set_stale(bool stale_);
+  // return the events performed in the current cycle
+  event_seq& get_events();
+  // return the ensembles replaced by the last event
+  ensemble::seq& get_destroyed();
+  // return the environments changed by the last event
+  environment::seq& get_changed();
+  // return ensembles of other domains replaced in the current cycle
+  ensemble::seq& get_foreign_destroyed();
+  // return environments of other domains changed in the current cycle
+  environment::seq& get_foreign_changed();
+}; // end class domain
+
+// inline functions
+// return the number of ensembles of type TYPE (zero if npos)
+inline unsigned int
+domain::size(unsigned int type) const
+{
+  return (type < buckets.size()) ? buckets[type].size() : 0U;
+}
+
+CH_END_NAMESPACE
+
+#endif // not CH_MODEL_DOMAIN_H
+
+/* $Id: domain.h,v 1.1.1.1 2004/11/25 20:24:08 banjo Exp $ */
@@ -28,10 +28,20 @@
 // set namespace to avoid possible clashes
 CH_BEGIN_NAMESPACE
 
+// static instance variables
+const unsigned int ensemble::npos = ~0U;
+
 // ensemble class methods
+// ctor: (default) create an empty ensemble
+ensemble::ensemble()
+  : sorted_species(), coordination(0U), handle(npos), type(npos),
+    group(npos), environments(), owner(0)
+{}
+
 // ctor: sort the given list of species and insert into the sequence
 ensemble::ensemble(const model_species::seq& speciess)
-  : sorted_species(), coordination(0U)
+  : sorted_species(), coordination(0U), handle(npos), type(npos),
+    group(npos), environments(), owner(0)
 {
   // reserve the maximum size we would need
   sorted_species.reserve(speciess.size());
@@ -39,22 +49,18 @@ ensemble::ensemble(const model_species::seq& speciess)
   for (model_species::seq_citer it(speciess.begin()); it != speciess.end();
        ++it)
     {
-      unsigned int coord((*it)->get_surface_coordination());
-      // see if it is a surface species
-      if (coord > 0U)
-	{
-	  sorted_species.push_back(*it);
-	  coordination += coord;
-	}
+      add_species(*it);
     }
   // sort the species sequence
-  CH_STD::sort(sorted_species.begin(), sorted_species.end());
+  finish();
 }
 
 // ctor: copy
 ensemble::ensemble(const ensemble& original)
   : sorted_species(original.sorted_species),
-    coordination(original.coordination)
+    coordination(original.coordination), handle(npos),
+    type(original.type), group(original.group),
+    environments(original.environments), owner(0)
 {}
 
 // dtor: do nothing
@@ -98,6 +104,242 @@ ensemble::end() const
   return sorted_species.end();
 }
 
+// remove all species and environments, keeping the storage
+void
+ensemble::clear()
+{
+  sorted_species.clear();
+  environments.clear();
+  owner = 0;
+  coordination = 0U;
+  type = npos;
+  group = npos;
+  return;
+}
+
+// add a species (ignored if not a surface species), call finish() after
+void
+ensemble::add_species(model_species* surface_species)
+{
+  unsigned int coord(surface_species->get_surface_coordination());
+  // see if it is a surface species
+  if (coord > 0U)
+    {
+      sorted_species.push_back(surface_species);
+      coordination += coord;
+    }
+  return;
+}
+
+// add an environment the species of the ensemble are on
+void
+ensemble::add_environment(environment* env)
+{
+  environments.push_back(env);
+  return;
+}
+
+// sort the species after adding them
+void
+ensemble::finish()
+{
+  // sort the species sequence
+  CH_STD::sort(sorted_species.begin(), sorted_species.end());
+  return;
+}
+
+// return the environments the species are on
+const ensemble::env_seq&
+ensemble::get_environments() const
+{
+  return environments;
+}
+
+// return the position of the ensemble in its bucket (or npos)
+unsigned int
+ensemble::get_handle() const
+{
+  return handle;
+}
+
+// change the position of the ensemble in its bucket, return old
+unsigned int
+ensemble::set_handle(unsigned int handle_)
+{
+  unsigned int old(handle);
+  handle = handle_;
+  return old;
+}
+
+// return the environment whose ensembles include this one
+environment*
+ensemble::get_owner() const
+{
+  return owner;
+}
+
+// change the environment whose ensembles include this one, return old
+environment*
+ensemble::set_owner(environment* owner_)
+{
+  environment* old(owner);
+  owner = owner_;
+  return old;
+}
+
+// return the number of the mechanism ensemble this is one of (or npos)
+unsigned int
+ensemble::get_type() const
+{
+  return type;
+}
+
+// change the number of the mechanism ensemble this is one of, return old
+unsigned int
+ensemble::set_type(unsigned int type_)
+{
+  unsigned int old(type);
+  type = type_;
+  return old;
+}
+
+// return the position of its sites among the groups of its owner
+unsigned int
+ensemble::get_group() const
+{
+  return group;
+}
+
+// change the position of its sites among the groups of its owner,
+// return old
+unsigned int
+ensemble::set_group(unsigned int group_)
+{
+  unsigned int old(group);
+  group = group_;
+  return old;
+}
+
+// ensemble_bucket methods
+// ctor: (default) create empty bucket
+ensemble_bucket::ensemble_bucket()
+  : entries()
+{}
+
+// ctor: copy
+ensemble_bucket::ensemble_bucket(const ensemble_bucket& original)
+  : entries(original.entries)
+{}
+
+// assignment
+ensemble_bucket&
+ensemble_bucket::operator=(const ensemble_bucket& right)
+{
+  entries = right.entries;
+  return *this;
+}
+
+// dtor: do nothing
+ensemble_bucket::~ensemble_bucket()
+{}
+
+// ensemble_bucket public methods
+// add ENS (owned by ENV) to the end of the bucket
+void
+ensemble_bucket::insert(ensemble* ens, environment* env)
+{
+  ens->set_handle(entries.size());
+  entries.push_back(CH_STD::make_pair(ens, env));
+  return;
+}
+
+// remove ENS from the bucket, return false if it was not in it
+bool
+ensemble_bucket::erase(ensemble* ens)
+{
+  unsigned int h(ens->get_handle());
+  // make sure it is really in this bucket
+  if (h >= entries.size() || entries[h].first != ens)
+    {
+      return false;
+    }
+  // move the last entry into the hole
+  if (h + 1U < entries.size())
+    {
+      entries[h] = entries.back();
+      entries[h].first->set_handle(h);
+    }
+  entries.pop_back();
+  ens->set_handle(ensemble::npos);
+  return true;
+}
+
+// return true if there are no ensembles in the bucket
+bool
+ensemble_bucket::empty() const
+{
+  return entries.empty();
+}
+
+// ensemble_pool methods
+// ctor: (default) create an empty pool
+ensemble_pool::ensemble_pool()
+  : owned(), available()
+{}
+
+// dtor: delete all the ensembles created by the pool
+ensemble_pool::~ensemble_pool()
+{
+  for (ensemble::seq_iter it(owned.begin()); it != owned.end(); ++it)
+    {
+      delete *it;
+      *it = 0;
+    }
+}
+
+// ensemble_pool public methods
+// return an empty ensemble, creating one if none are available
+ensemble*
+ensemble_pool::get()
+{
+  ensemble* ens(0);
+  if (available.empty())
+    {
+      // grow the pool
+      ens = new ensemble();
+      owned.push_back(ens);
+    }
+  else
+    {
+      // reuse the most recently returned one
+      ens = available.back();
+      available.pop_back();
+      ens->clear();
+    }
+  return ens;
+}
+
+// give an ensemble which is no longer used back to the pool
+void
+ensemble_pool::put(ensemble* ens)
+{
+  ens->set_handle(ensemble::npos);
+  available.push_back(ens);
+  return;
+}
+
+// take over all of the ensembles of OTHER, leaving it empty
+void
+ensemble_pool::take(ensemble_pool& other)
+{
+  owned.insert(owned.end(), other.owned.begin(), other.owned.end());
+  available.insert(available.end(), other.available.begin(),
+		   other.available.end());
+  other.owned.clear();
+  other.available.clear();
+  return;
+}
+
 CH_END_NAMESPACE
 
 /* $Id: ensemble.cc,v 1.1.1.1 2004/11/25 20:24:08 banjo Exp $ */
@@ -22,15 +22,21 @@
 #ifndef CH_MODEL_ENSEMBLE_H
 #define CH_MODEL_ENSEMBLE_H 1
 
+#include <deque>
 #include <map>
+#include <utility>
 #include <vector>
-#include "point.h"
 #include "species.h"
 
 // set namespace to avoid possible clashes
 CH_BEGIN_NAMESPACE
 
-// this class describes the species required for a reaction
+// forward declaration
+class environment;
+
+// this class describes the species required for a reaction; those
+// found on the surface only give the number of the ensemble of the
+// mechanism they are (their type) and the environments they are on
 class ensemble
 {
 public:
@@ -41,15 +47,23 @@ public:
   typedef CH_STD::deque<ensemble*> deq;
   typedef deq::iterator deq_iter;
   typedef deq::const_iterator deq_citer;
+  typedef CH_STD::vector<environment*> env_seq;
 
 private:
   model_species::seq sorted_species; // the surface reactants
   unsigned int coordination;	// the total coordination of the ensemble
+  unsigned int handle;		// position in the bucket holding it
+  unsigned int type;		// which ensemble of the mechanism it is
+  unsigned int group;		// which group of sites of its owner it is on
+  env_seq environments;		// environments the species are on
+  environment* owner;		// environment whose ensembles include this
 
 private:
   // prevent assignment
   ensemble& operator=(const ensemble&);
 public:
+  // ctor: (default) create an empty ensemble (see ensemble_pool)
+  ensemble();
   // ctor: sort the model_species list and insert into sorted species
   explicit ensemble(const model_species::seq& speciess);
   // ctor: copy
@@ -67,8 +81,115 @@ public:
   model_species::seq_citer begin() const;
   // return iterator to the end of the species sequences
   model_species::seq_citer end() const;
+  // remove all species and environments, keeping the storage
+  void clear();
+  // add a species (ignored if not a surface species), call finish() after
+  void add_species(model_species* surface_species);
+  // add an environment the species of the ensemble are on
+  void add_environment(environment* env);
+  // sort the species after adding them
+  void finish();
+  // return the environments the species are on
+  const env_seq& get_environments() const;
+  // return the position of the ensemble in its bucket (or npos)
+  unsigned int get_handle() const;
+  // change the position of the ensemble in its bucket, return old
+  unsigned int set_handle(unsigned int handle_);
+  // return the environment whose ensembles include this one
+  environment* get_owner() const;
+  // change the environment whose ensembles include this one, return old
+  environment* set_owner(environment* owner_);
+  // return the number of the mechanism ensemble this is one of (or npos)
+  unsigned int get_type() const;
+  // change the number of the mechanism ensemble this is one of, return old
+  unsigned int set_type(unsigned int type_);
+  // return the position of its sites among the groups of its owner
+  unsigned int get_group() const;
+  // change the position of its sites among the groups of its owner,
+  // return old
+  unsigned int set_group(unsigned int group_);
+  // handle of an ensemble which is not in a bucket
+  static const unsigned int npos;
 }; // end class ensemble
 
+// all of the ensembles of one type currently on the surface, together
+// with the environment which owns each; each ensemble knows its
+// position (handle) so it can be removed in constant time by moving the
+// last entry into its place, and entries can be selected by index
+class ensemble_bucket
+{
+public:
+  // typedef's
+  typedef CH_STD::pair<ensemble*,environment*> entry;
+  typedef CH_STD::vector<entry> seq;
+  typedef seq::iterator seq_iter;
+  typedef seq::const_iterator seq_citer;
+
+private:
+  seq entries;			// the ensembles and their environments
+
+public:
+  // ctor: (default) create empty bucket
+  ensemble_bucket();
+  // ctor: copy
+  ensemble_bucket(const ensemble_bucket& original);
+  // assignment (required for map)
+  ensemble_bucket& operator=(const ensemble_bucket& right);
+  // dtor: do nothing (ensembles are owned by environments)
+  ~ensemble_bucket();
+
+  // add ENS (owned by ENV) to the end of the bucket
+  void insert(ensemble* ens, environment* env);
+  // remove ENS from the bucket, return false if it was not in it
+  bool erase(ensemble* ens);
+  // return the number of ensembles in the bucket
+  unsigned int size() const;
+  // return true if there are no ensembles in the bucket
+  bool empty() const;
+  // return the entry at position I
+  const entry& operator[](unsigned int i) const;
+}; // end class ensemble_bucket
+
+// recycles ensemble objects (and their storage) between kmc steps
+// rather than returning them to the heap; owns every ensemble it makes
+class ensemble_pool
+{
+  ensemble::seq owned;		// all the ensembles created by the pool
+  ensemble::seq available;	// ensembles not currently in use
+
+private:
+  // prevent copy construction and assignment
+  ensemble_pool(const ensemble_pool&);
+  ensemble_pool& operator=(const ensemble_pool&);
+public:
+  // ctor: (default) create an empty pool
+  ensemble_pool();
+  // dtor: delete all the ensembles created by the pool
+  ~ensemble_pool();
+
+  // return an empty ensemble, creating one if none are available
+  ensemble* get();
+  // give an ensemble which is no longer used back to the pool
+  void put(ensemble* ens);
+  // take over all of the ensembles of OTHER, leaving it empty
+  void take(ensemble_pool& other);
+}; // end class ensemble_pool
+
+// inline functions
+// return the number of ensembles in the bucket
+inline unsigned int
+ensemble_bucket::size() const
+{
+  return entries.size();
+}
+
+// return the entry at position I
+inline const ensemble_bucket::entry&
+ensemble_bucket::operator[](unsigned int i) const
+{
+  return entries[i];
+}
+
 CH_END_NAMESPACE
 
 #endif // not CH_MODEL_ENSEMBLE_H
@@ -37,25 +37,37 @@ environment::type environment::env_type = environment::Enn;
 bool environment::radial = true;
 unsigned int environment::max_sites = 0U;
 rng* environment::random = 0;
+ensemble_pool* environment::pool = 0;
 model_species* environment::empty_site = 0;
 
+// environment::group_less methods
+// compare groups lexicographically by the indices of their environments
+bool
+environment::group_less::operator()(const group& left,
+				    const group& right) const
+{
+  return CH_STD::lexicographical_compare(left.begin(), left.end(),
+					 right.begin(), right.end(),
+					 index_less());
+}
+
 // environment class methods
-// ctor: set center
-environment::environment(lattice_point* center_)
-  : center(center_), multisite(), neighbors(), connected(), sites(),
-    ensembles(), ensemble_env(), initialized(false)
+// ctor: set the groups of sites of the surface, what recognizes the
+// ensembles of interest, where products can be put on the groups, and
+// the position on the surface of the center point, remember the current
+// empty site
+environment::environment(const stencil* pattern_,
+			 const ensemble_matcher* matcher_,
+			 const placement_table* placements_,
+			 unsigned int index_)
+  : pattern(pattern_), matcher(matcher_), placements(placements_),
+    index(index_), multisite(),
+    neighbors(), ensembles(), initialized(false), empty(empty_site)
 {}
 
-// dtor: delete ensemble pointers
+// dtor: do nothing (ensembles belong to the pool)
 environment::~environment()
-{
-  // loop through and delete pointers, this will invalidate points
-  for (ensemble::seq_iter it(ensembles.begin()); it != ensembles.end(); ++it)
-    {
-      delete *it;
-      *it = 0;
-    }
-}
+{}
 
 // environment private methods
 environment::type
@@ -127,7 +139,7 @@ environment::connectivity(group& touch, group_set& groups,
 	{
 	  // loop from the current group to the end
 	  group_set_citer in(out);
-	  while (++in != sites.end())
+	  while (++in != groups.end())
 	    {
 	      // create a new group which is the sum of the two given
 	      group combined(out->begin(), out->end());
@@ -135,7 +147,7 @@ environment::connectivity(group& touch, group_set& groups,
 	      // insert all combined groups whose sum envs <= max_sites
 	      if (combined.size() <= max_sites)
 		{
-		  sites.insert(combined);
+		  groups.insert(combined);
 		}
 	    }
 	}
@@ -233,156 +245,181 @@ environment::neighbor_sites(group_set& groups, unsigned int n_sites)
   return;
 }
 
-// use connect to create the ensembles containing this site
+// create the ensembles of the groups of sites containing this site
+// which the matcher recognizes
+/* Only groups holding one of the ensembles of the mechanism are kept,
+ * and the matcher finds those from the ids on the lattice, so no
+ * ensemble is made for the many groups of no interest.
+ */
 void
-environment::create_ensembles()
+environment::create_ensembles(ensemble_pool& pool_)
   throw (bad_request)
 {
   // clear the containers we will be filling
   ensembles.clear();
-  ensemble_env.clear();
-  // loop through all the sites (connected environments)
-  for (group_set_citer it(sites.begin()); it != sites.end(); ++it)
-    {
-      unsigned int site_size(it->size());
-      // do not include sites of the maximum size having an empty site in
-      // in the middle
-      if (!radial && center->get_species() == empty_site
-	  && site_size == max_sites)
+  // get the sites (connected environments) from the stencil
+  seq members;
+  CH_STD::vector<unsigned int> ends;
+  pattern->get_groups(index, members, ends);
+  // loop through all the sites
+  for (unsigned int i(0U); i < ends.size(); ++i)
+    {
+      seq_citer begin(members.begin() + ((i > 0U) ? ends[i - 1U] : 0U));
+      seq_citer end(members.begin() + ends[i]);
+      // see if there is an ensemble of interest on them
+      ensemble* ens(create_ensemble(begin, end, i, pool_));
+      if (ens != 0)
 	{
-	  // make sure this is the maximum possible for this env type
-	  switch (env_type)
-	    {
-	    case Esingle:
-	      // not applicable
-	      break;
-
-	    case Enn:
-	      if (max_sites == 5U)
-		// do not use this site
-		continue;	// for (it)
-	      break;
-
-	    case Ennn:
-	      if (max_sites == 9U)
-		// do not use this site
-		continue;	// for (it)
-	      break;
-
-	    default:
-	      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
-				":environment::create_ensembles(): the "
-				"environment type has been corrupted");
-	      break;
-	    }
+	  // add it to the ensembles around this point
+	  ensembles.push_back(ens);
 	}
-      // create an empty sequence of model_species
-      model_species::seq ms_seq;
-      ms_seq.reserve(it->size());
-      // multisite flag
-      bool multisite(false);
-      // loop through the environments in this site
-      for (group_citer git(it->begin()); git != it->end(); ++git)
+    }
+  return;
+}
+
+// replace the ensembles of the groups of sites containing this site
+// which include any of REACTING, putting the old ones in REMOVE
+/* The other groups hold the same species as before, so their ensembles
+ * are kept (and stay in the buckets they are in).  The ensembles are
+ * kept in the order of their groups, as create_ensembles() leaves them,
+ * so where an ensemble is among those of its environment does not
+ * depend on how the surface came to be as it is.
+ */
+void
+environment::update_ensembles(const seq& reacting, ensemble::seq& remove,
+			      ensemble_pool& pool_)
+  throw (bad_request)
+{
+  // get the groups including a reacting site from the stencil
+  seq members;
+  CH_STD::vector<unsigned int> ends;
+  CH_STD::vector<unsigned int> positions;
+  pattern->get_groups(index, reacting, members, ends, positions);
+  // drop the ensembles on those groups, keeping the order of the rest
+  // (both are in the order of the groups)
+  ensemble::seq_iter out(ensembles.begin());
+  CH_STD::vector<unsigned int>::const_iterator pos_it(positions.begin());
+  for (ensemble::seq_citer it(ensembles.begin()); it != ensembles.end();
+       ++it)
+    {
+      unsigned int group((*it)->get_group());
+      while (pos_it != positions.end() && *pos_it < group)
 	{
-	  // get the species and multisite information
-	  CH_STD::pair<model_species*,seq>
-	    species_multi((*git)->get_species());
-	  // see if it is a single site species
-	  if (species_multi.second.empty())
-	    {
-	      // insert the species into the sequence
-	      ms_seq.push_back(species_multi.first);
-	    }
-	  else			// multisite species
-	    {
-	      // set flag
-	      multisite = true;
-	      // see if multi-site species is contained entirely in this
-	      // connected set
-	      bool contained(true);
-	      for (seq_citer multi_it(species_multi.second.begin());
-		   multi_it != species_multi.second.end(); ++multi_it)
-		{
-		  // try to find this env in the current group (it)
-		  if (it->find(*multi_it) == it->end())
-		    {
-		      // not found
-		      contained = false;
-		      break;	// for (multi_it)
-		    }
-		}
-	      if (contained)
-		{
-		  // insert the species into the sequence
-		  ms_seq.push_back(species_multi.first);
-		}
-	      else
-		{
-		  // clear the species sequence
-		  ms_seq.clear();
-		  break;	// for (git)
-		}
-	    }
-	  // test for failure
-	  if (ms_seq.empty())
-	    {
-	      // failed, do not continue this for (git) loop
-	      break;
-	    }
+	  ++pos_it;
 	}
-      // check for failure
-      if (!ms_seq.empty())
+      if (pos_it != positions.end() && *pos_it == group)
 	{
-	  // see if there were any multisite species
-	  if (multisite)
-	    {
-	      // make sure multisite species are inserted the proper amount
-	      CH_STD::map<model_species*,counter> species_count;
-	      for (model_species::seq_citer sp_it(ms_seq.begin());
-		   sp_it != ms_seq.end(); ++sp_it)
-		{
-		  // increment the number of time this appears in the sequence
-		  ++species_count[*sp_it];
-		}
-	      // clear the species sequence
-	      ms_seq.clear();
-	      // insert each species the proper number of times
-	      for (CH_STD::map<model_species*,counter>::const_iterator mm_it(species_count.begin()); mm_it != species_count.end(); ++mm_it)
-		{
-		  int coord = mm_it->first->get_surface_coordination();
-		  int count = mm_it->second.get_count();
-		  for (int i(0); i < count / coord; ++i)
-		    {
-		      ms_seq.push_back(mm_it->first);
-		    }
-		}
-	    }
-	  // perform the insertion into the containers
-	  insert_ensemble(ms_seq, seq(it->begin(), it->end()));
+	  remove.push_back(*it);
+	}
+      else
+	{
+	  *out++ = *it;
 	}
-      // else try the next site (it)
+    }
+  ensembles.erase(out, ensembles.end());
+  // create the ensembles now on those groups
+  for (unsigned int i(0U); i < ends.size(); ++i)
+    {
+      seq_citer begin(members.begin() + ((i > 0U) ? ends[i - 1U] : 0U));
+      seq_citer end(members.begin() + ends[i]);
+      ensemble* ens(create_ensemble(begin, end, positions[i], pool_));
+      if (ens == 0)
+	{
+	  continue;		// for (i)
+	}
+      // put it among the others in the order of the groups
+      ensembles.push_back(ens);
+      ensemble::seq_iter place(ensembles.end() - 1);
+      while (place != ensembles.begin()
+	     && (*(place - 1))->get_group() > positions[i])
+	{
+	  *place = *(place - 1);
+	  --place;
+	}
+      *place = ens;
     }
   return;
 }
 
-// properly insert the given sequence of species and ennvironments those
-// species are on into ensemble containers
-void
-environment::insert_ensemble(const model_species::seq& speciess,
-			     const seq& envs)
-{
-  // create an ensemble from the sequence
-  ensemble* surface_species = new ensemble(speciess);
-  // insert it into the sequence
-  ensembles.push_back(surface_species);
-  // add the ensemble and environment pointers to the map
-  ensemble_env.insert(CH_STD::make_pair(surface_species, envs));
-  return;
+// return the ensemble on the group of sites GROUP (from BEGIN to END)
+// of this site, taken from POOL_, or 0 if it holds none of interest
+ensemble*
+environment::create_ensemble(seq_citer begin, seq_citer end,
+			     unsigned int group, ensemble_pool& pool_)
+  throw (bad_request)
+{
+  unsigned int site_size(end - begin);
+  // do not include sites of the maximum size having an empty site in
+  // in the middle
+  if (!radial && get_center() == empty
+      && site_size == max_sites)
+    {
+      // make sure this is the maximum possible for this env type
+      switch (env_type)
+	{
+	case Esingle:
+	  // not applicable
+	  break;
+
+	case Enn:
+	  if (max_sites == 5U)
+	    // do not use this site
+	    return 0;
+	  break;
+
+	case Ennn:
+	  if (max_sites == 9U)
+	    // do not use this site
+	    return 0;
+	  break;
+
+	default:
+	  throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			    ":environment::create_ensemble(): the "
+			    "environment type has been corrupted");
+	  break;
+	}
+    }
+  // see which ensemble of the mechanism, if any, is on these sites
+  unsigned int type(matcher->find(begin, end));
+  if (type == ensemble::npos)
+    {
+      return 0;
+    }
+  // loop through the environments in this site
+  for (seq_citer git(begin); git != end; ++git)
+    {
+      // see if multi-site species is contained entirely in this
+      // connected set
+      for (seq_citer multi_it((*git)->multisite.begin());
+	   multi_it != (*git)->multisite.end(); ++multi_it)
+	{
+	  // try to find this env in the current group
+	  if (CH_STD::find(begin, end, *multi_it) == end)
+	    {
+	      // not found, so no ensemble here
+	      return 0;
+	    }
+	}
+    }
+  // get an empty ensemble to fill; its type says what species are on
+  // it, so only the environments are needed
+  ensemble* ens(pool_.get());
+  for (seq_citer git(begin); git != end; ++git)
+    {
+      // the species is on this environment
+      ens->add_environment(*git);
+    }
+  ens->set_type(type);
+  ens->set_group(group);
+  ens->set_owner(this);
+  return ens;
 }
 
 // place a sequence of species onto sites in the sequence of envs
 bool
-environment::place_species(const model_species::seq& speciess, seq& envs)
+environment::place_species(const model_species::seq& speciess,
+			     const seq& envs, rng& random_)
   throw (bad_request, bad_pointer)
 {
   // make sure there are more species left to place
@@ -410,6 +447,11 @@ environment::place_species(const model_species::seq& speciess, seq& envs)
 			surf_species->get_name() + " is not a surface species "
 			"and therefore can not be placed on surface");
     }
+  // single site species can go anywhere, so skip building sets of sites
+  if (place_single_species(speciess, envs, random_))
+    {
+      return true;
+    }
   // else
   // declare containers we will need to pass
   model_species::seq species_left(speciess.begin() + 1U, speciess.end());
@@ -419,7 +461,7 @@ environment::place_species(const model_species::seq& speciess, seq& envs)
   // convert the set of sites into a vector
   CH_STD::vector<group> sites(sites_set.begin(), sites_set.end());
   // randomize the vector
-  CH_STD::random_shuffle(sites.begin(), sites.end(), *random);
+  CH_STD::random_shuffle(sites.begin(), sites.end(), random_);
   // go through the randomized list and try to place the species
   CH_STD::vector<group>::iterator site_it(sites.begin());
   while (site_it != sites.end())
@@ -438,7 +480,7 @@ environment::place_species(const model_species::seq& speciess, seq& envs)
 	    }
 	}
       // try to place the rest of the species on the rest of the sites
-      if (place_species(species_left, envs_left))
+      if (place_species(species_left, envs_left, random_))
 	{
 	  // put species on the sites
 	  for (group_iter git(site_it->begin()); git != site_it->end(); ++git)
@@ -535,6 +577,49 @@ environment::place_species(const model_species::seq& speciess, seq& envs)
 #endif // 0
 }
 
+// place a sequence of single site species, one on each of envs, return
+// false (placing nothing) if any species is not single site
+/* Equivalent to what place_species() does with single site species
+ * (the same random choices are made for the same generator state), but
+ * without creating a set of one-environment sites for every species.
+ */
+bool
+environment::place_single_species(const model_species::seq& speciess,
+				  const seq& envs, rng& random_)
+  throw (bad_pointer)
+{
+  // there must be a site for each species
+  if (speciess.size() != envs.size())
+    {
+      return false;
+    }
+  for (model_species::seq_citer it(speciess.begin()); it != speciess.end();
+       ++it)
+    {
+      if ((*it)->get_surface_coordination() != 1U)
+	{
+	  return false;
+	}
+    }
+  // environments still available, and the candidates in random order
+  seq left(envs);
+  seq candidates;
+  candidates.reserve(envs.size());
+  for (model_species::seq_citer it(speciess.begin()); it != speciess.end();
+       ++it)
+    {
+      // randomize the available sites in order of index
+      candidates.assign(left.begin(), left.end());
+      CH_STD::sort(candidates.begin(), candidates.end(), index_less());
+      CH_STD::random_shuffle(candidates.begin(), candidates.end(), random_);
+      // put the species on the first one
+      environment* env(candidates.front());
+      env->set_species(*it);
+      left.erase(CH_STD::find(left.begin(), left.end(), env));
+    }
+  return true;
+}
+
 // put all possible connected sites in sites
 void
 environment::get_sites(int coord, const seq& envs, group_set& sites)
@@ -585,27 +670,6 @@ environment::get_sites(int coord, const seq& envs, group_set& sites)
   return;
 }
 
-// return whether the given environment is a neighbor of this one
-bool
-environment::is_neighbor(const environment* env)
-{
-  for (seq_citer it(neighbors.begin()); it != neighbors.end(); ++it)
-    {
-      if (*it == env)
-	{
-	  return true;
-	}
-    }
-  return false;
-}
-
-// return the type of species on this site
-CH_STD::pair<model_species*,environment::seq>
-environment::get_species() const
-{
-  return CH_STD::make_pair(center->get_species(), multisite);
-}
-
 // change the species which occupies the center site, return old species
 model_species*
 environment::set_species(model_species* center_species)
@@ -620,7 +684,8 @@ environment::set_species(model_species* center_species)
   // erase record of multiple site species
   multisite.clear();
   // change the species
-  model_species* old(center->set_species(center_species));
+  model_species* old(pattern->get_surface()->set_species(index,
+							 center_species));
   // return old species
   return old;
 }
@@ -669,6 +734,24 @@ environment::set_max_sites(unsigned int max_sites_)
   return old;
 }
 
+// return how many rows or columns a group of sites may reach
+unsigned int
+environment::get_reach()
+{
+  if (env_type == Esingle)
+    {
+      return 0U;
+    }
+  // else
+  if (radial && max_sites > 1U)
+    {
+      // a chain of max_sites environments
+      return max_sites - 1U;
+    }
+  // a site and its neighbors
+  return 1U;
+}
+
 // set the random number generator (must be done before initialization)
 void
 environment::set_rng(rng* random_)
@@ -685,6 +768,15 @@ environment:: set_empty_site(model_species* empty_site_)
   return;
 }
 
+// set the pool ensembles are taken from (must be done before
+// initialization)
+void
+environment::set_pool(ensemble_pool* pool_)
+{
+  pool = pool_;
+  return;
+}
+
 // set the neighbors of this environment
 // note: must be done to entire surface before initialize() is called
 void
@@ -697,19 +789,18 @@ environment::set_neighbors(const matrix& surface)
       return;
     }
   // else
-  // get where we are
-  CH_STD::pair<unsigned int,unsigned int> rc(center->get_position());
-  int row(rc.first);
-  int column(rc.second);
+  // get the information on the size of the surface
+  int rows(surface.size());
+  // in case it is not square
+  int columns(surface.begin()->size());
+  // get where we are (the environments are numbered row by row)
+  int row(index / columns);
+  int column(index % columns);
   // set up indices of the surrounding envionments
   int up(row - 1);
   int down(row + 1);
   int left(column - 1);
   int right(column + 1);
-  // get the information on the size of the surface
-  int rows(surface.size());
-  // in case it is not square
-  int columns(surface.begin()->size());
   // adjust desired position according to periodicity
   up = (up < 0) ? rows - 1 : up;
   down = (down >= rows) ? 0 : down;
@@ -740,10 +831,38 @@ environment::set_neighbors(const matrix& surface)
   return;
 }
 
-// set up environment pointers using the given matrix of environments
+// put the groups of sites containing this environment in GROUPS, the
+// environments they contain in TOUCH
+void
+environment::connect(group& touch, group_set& groups)
+  throw (bad_input)
+{
+  // get the environments are <= max_sites away
+  connectivity(touch, groups, max_sites);
+  return;
+}
+
+// create the ensembles of this environment
 void
 environment::initialize()
-  throw (bad_pointer, bad_input, bad_request)
+  throw (bad_pointer, bad_request)
+{
+  // make sure there is somewhere to get ensembles
+  if (pool == 0)
+    {
+      throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":environment::initialize(): ensemble pool "
+			"has not been set, cannot initialize");
+    }
+  // use the pool shared by all environments
+  initialize(*pool);
+  return;
+}
+
+// create the ensembles of this environment, taking them from POOL_
+void
+environment::initialize(ensemble_pool& pool_)
+  throw (bad_pointer, bad_request)
 {
   // make sure random number generator has been set
   if (random == 0)
@@ -752,12 +871,8 @@ environment::initialize()
 			":environment::initialize(): random number generator "
 			"has not been set, cannot initialize");
     }
-  // clear out the sites container
-  sites.clear();
-  // get the environments are <= max_sites away
-  connectivity(connected, sites, max_sites);
   // create all ensembles which include this sight
-  create_ensembles();
+  create_ensembles(pool_);
   initialized = true;
   return;
 }
@@ -767,7 +882,20 @@ environment::initialize()
 void
 environment::change_ensemble(ensemble* reactants,
 			     const model_species::seq& products,
-			     ensemble::deq& remove, group& changed)
+			     ensemble::seq& remove, seq& changed)
+  throw (bad_pointer, bad_request)
+{
+  // use the generator and pool shared by all environments
+  change_ensemble(reactants, products, remove, changed, *random, *pool);
+  return;
+}
+
+// exchange an ensemble with a new one using the given generator and pool
+void
+environment::change_ensemble(ensemble* reactants,
+			     const model_species::seq& products,
+			     ensemble::seq& remove, seq& changed, rng& random_,
+			     ensemble_pool& pool_)
   throw (bad_pointer, bad_request)
 {
   if (!initialized)
@@ -778,72 +906,130 @@ environment::change_ensemble(ensemble* reactants,
 			"ensemble");
     }
   // make sure the old ensemble is owned by this environment
-  map_iter old_ens_env(ensemble_env.find(reactants));
-  if (old_ens_env == ensemble_env.end())
+  if (CH_STD::find(ensembles.begin(), ensembles.end(), reactants)
+      == ensembles.end())
     {
       throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
 			":environment::change_ensemble(): could not find the "
 			"given old pointer in this environment");
     }
-  // get a set of all the affected environments
+  // the environments the reactants are on
+  const seq& reacting(reactants->get_environments());
+  // get all the affected environments
   // add this point
-  changed.insert(this);		// should be in connected as well
+  changed.push_back(this);	// should be in its touching points as well
   // add the environments connected to this point
-  changed.insert(connected.begin(), connected.end());
+  pattern->get_touching(index, changed);
   // loop through the environments involved in reaction
-  for (seq_citer it(old_ens_env->second.begin());
-       it != old_ens_env->second.end(); ++it)
+  for (seq_citer it(reacting.begin()); it != reacting.end(); ++it)
     {
       // insert environments connected to them as well
-      changed.insert((*it)->connected.begin(), (*it)->connected.end());
-    }
-  // get all (ugh) of the ensembles for the pertinent environments
-  for (group_citer it(changed.begin()); it != changed.end(); ++it)
-    {
-      // insert faster for deques
-      remove.insert(remove.end(), (*it)->ensembles.begin(),
-		    (*it)->ensembles.end());
+      pattern->get_touching((*it)->index, changed);
     }
+  // put them in order and remove the duplicates
+  CH_STD::sort(changed.begin(), changed.end(), index_less());
+  changed.erase(CH_STD::unique(changed.begin(), changed.end()),
+		changed.end());
   // make sure the size the the old ensemble and list of products is the name
   // create an ensemble from products
   ensemble prods(products);
-  if (reactants->get_coordination() != prods.get_coordination())
+  // (every site of the reactants is one of their environments)
+  if (reacting.size() != prods.get_coordination())
     {
       throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
 			":environment::change_ensemble(): total coordination "
 			"of surface species in reactants (" +
-			t_string(reactants->get_coordination()) + ") does not "
+			t_string(reacting.size()) + ") does not "
 			"match that in the products (" +
 			t_string(prods.get_coordination()) + ")");
 			
     }
-  // use the ensemble to get a list of the surface species
-  model_species::seq surface_products(prods.begin(), prods.end());
-  // randomize the list of surface species
-  CH_STD::random_shuffle(surface_products.begin(), surface_products.end(),
-			 *random);
-  // change the species on the environments involved in reaction
-  place_species(surface_products, old_ens_env->second);
-  // re-create the ensembles for the affected environments
-  for (group_citer it(changed.begin()); it != changed.end(); ++it)
+  // see if the ways of putting the products on the group of sites of
+  // the reactants were listed (products covering more than one site)
+  const placement_table::seq*
+    choices(placements->find(reactants->get_group(), prods.begin(),
+			     prods.end()));
+  if (choices != 0)
+    {
+      if (choices->empty())
+	{
+	  throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			    ":environment::change_ensemble(): the products "
+			    "can not be put on the sites of the reactants");
+	}
+      // pick one of them
+      const placement_table::placement&
+	chosen((*choices)[random_.get_random(choices->size())]);
+      seq multi;
+      for (unsigned int i(0U); i < reacting.size(); ++i)
+	{
+	  // the other sites its species covers
+	  multi.clear();
+	  for (CH_STD::vector<unsigned int>::const_iterator
+		 it(chosen.others[i].begin()); it != chosen.others[i].end();
+	       ++it)
+	    {
+	      multi.push_back(reacting[*it]);
+	    }
+	  reacting[i]->set_species(chosen.species[i], multi);
+	}
+    }
+  else
     {
-      (*it)->create_ensembles();
+      // use the ensemble to get a list of the surface species
+      model_species::seq surface_products(prods.begin(), prods.end());
+      // randomize the list of surface species
+      CH_STD::random_shuffle(surface_products.begin(),
+			     surface_products.end(), random_);
+      // change the species on the environments involved in reaction
+      place_species(surface_products, reacting, random_);
+    }
+  // re-create the ensembles on the reacting sites for the affected
+  // environments
+  for (seq_citer it(changed.begin()); it != changed.end(); ++it)
+    {
+      (*it)->update_ensembles(reacting, remove, pool_);
     }
   return;
 }
 
-// return an iterator to the beginning of sites
-environment::group_set_citer
-environment::sites_begin() const
+// return whether the given environment is a neighbor of this one
+bool
+environment::is_neighbor(const environment* env) const
+{
+  for (seq_citer it(neighbors.begin()); it != neighbors.end(); ++it)
+    {
+      if (*it == env)
+	{
+	  return true;
+	}
+    }
+  return false;
+}
+
+// return the type of species on this site
+CH_STD::pair<model_species*,environment::seq>
+environment::get_species() const
 {
-  return sites.begin();
+  return CH_STD::make_pair(get_center(), multisite);
 }
 
-// return an iterator to the end of sites
-environment::group_set_citer
-environment::sites_end() const
+// put back a species as it was when the surface was saved
+void
+environment::restore_species(model_species* center_species,
+			     const seq& multisite_)
+  throw (bad_request, bad_pointer)
 {
-  return sites.end();
+  // the ensembles are created from the species during initialization
+  if (initialized)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":environment::restore_species(): the ensembles of "
+			"this environment have already been created");
+    }
+  pattern->get_surface()->set_species(index, center_species);
+  multisite = multisite_;
+  return;
 }
 
 // return an iterator to the beginning sequence of ensembles
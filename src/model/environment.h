@@ -30,9 +30,11 @@
 #include "ensemble.h"
 #include "except.h"
 #include "lattice.h"
-#include "point.h"
+#include "matcher.h"
+#include "placement.h"
 #include "rng.h"
 #include "species.h"
+#include "stencil.h"
 
 // set namespace to avoid possible clashes
 CH_BEGIN_NAMESPACE
@@ -41,6 +43,11 @@ CH_BEGIN_NAMESPACE
 class environment
 {
 public:
+  // order environments by index so containers do not depend on addresses
+  struct index_less
+  {
+    bool operator()(const environment* left, const environment* right) const;
+  };
   // set up typedef's
   typedef CH_STD::vector<environment*> seq;
   typedef seq::iterator seq_iter;
@@ -48,34 +55,38 @@ public:
   typedef CH_STD::vector<seq> matrix;
   typedef matrix::iterator matrix_iter;
   typedef matrix::const_iterator matrix_citer;
-  typedef CH_STD::set<environment*> group;
+  typedef CH_STD::set<environment*,index_less> group;
   typedef group::iterator group_iter;
   typedef group::const_iterator group_citer;
   typedef CH_STD::deque<group> group_deq;
   typedef group_deq::iterator group_deq_iter;
   typedef group_deq::const_iterator group_deq_citer;
-  typedef CH_STD::set<group> group_set;
+  // order groups by the indices of their environments
+  struct group_less
+  {
+    bool operator()(const group& left, const group& right) const;
+  };
+  typedef CH_STD::set<group,group_less> group_set;
   typedef group_set::iterator group_set_iter;
   typedef group_set::const_iterator group_set_citer;
-  typedef CH_STD::map<ensemble*,seq> map;
-  typedef map::iterator map_iter;
-  typedef map::const_iterator map_citer;
 
 private:
   // enumeration for the types of environments (refer to as environment::Efoo)
   enum type { Esingle, Enn, Ennn };
-  lattice_point* center;	// pointer to whose environment this is
+  const stencil* pattern;	// groups of sites on the surface of the point
+  const ensemble_matcher* matcher; // recognizes the ensembles to keep
+  const placement_table* placements; // where products can go on groups
+  unsigned int index;		// position of this environment on surface
   seq multisite;		// if species is on multiple sites, those envs
   seq neighbors;		// neighboring environments
-  group connected;		// given max_sites, what envnmnts touch this
-  group_set sites;		// sites containing this environment
   ensemble::seq ensembles;	// ensembles available around this point
-  map ensemble_env;		// environments in each ensemble
   bool initialized;		// whether neighbors have been set
+  model_species* empty;		// empty site species when created
   static type env_type;		// the type of environment to use
   static bool radial;		// what types of sites to allow
   static unsigned int max_sites; // maximum number of sites needed for reaction
   static rng* random;		// random number generator
+  static ensemble_pool* pool;	// where to get new ensembles from
   static model_species* empty_site; // empty site species
 
 private:
@@ -95,32 +106,49 @@ private:
   void radiate(group& touch, group_set& groups, unsigned int n_sites);
   // create sites with only neighbors
   void neighbor_sites(group_set& groups, unsigned int n_sites);
-  // use connect to create the ensembles containing this site
-  void create_ensembles()
+  // create the ensembles of the groups of sites containing this site
+  // which the matcher recognizes, taking them from POOL_
+  void create_ensembles(ensemble_pool& pool_)
+    throw (bad_request);	// create_ensemble()
+  // replace the ensembles of the groups of sites containing this site
+  // which include any of REACTING (whose species have changed), putting
+  // the old ones in REMOVE and taking the new ones from POOL_
+  void update_ensembles(const seq& reacting, ensemble::seq& remove,
+			ensemble_pool& pool_)
+    throw (bad_request);	// create_ensemble()
+  // return the ensemble on the group of sites GROUP (from BEGIN to END)
+  // of this site, taken from POOL_, or 0 if it holds none of interest
+  ensemble* create_ensemble(seq_citer begin, seq_citer end,
+			    unsigned int group, ensemble_pool& pool_)
     throw (bad_request);	// this
-  // properly insert the given sequence of species and ennvironments those
-  // species are on into ensemble containers
-  void insert_ensemble(const model_species::seq& speciess, const seq& envs);
   // place a sequence of species onto sites in the sequence of envs
-  bool place_species(const model_species::seq& speciess, seq& envs)
+  bool place_species(const model_species::seq& speciess, const seq& envs,
+		     rng& random_)
     throw (bad_request, bad_pointer); // this, set_species()
+  // place a sequence of single site species, one on each of envs, return
+  // false (placing nothing) if any species is not single site
+  bool place_single_species(const model_species::seq& speciess,
+			    const seq& envs, rng& random_)
+    throw (bad_pointer); // set_species()
   // put all possible connected sites in sites
   void get_sites(int coord, const seq& envs, group_set& sites);
-  // return whether the given environment is a neighbor of this one
-  bool is_neighbor(const environment* env);
-  // return the type of species on this site and any sites which share species
-  CH_STD::pair<model_species*,seq> get_species() const;
+  // return the species which occupies the center site
+  model_species* get_center() const;
   // change the species which occupies the center site, return old species
   model_species* set_species(model_species* center_species)
-    throw (bad_pointer); // this
+    throw (bad_pointer); // this, lattice::set_species()
   // place a multi-site species on the center site, return old species
   model_species* set_species(model_species* center_species,
 			     const seq& multisite_)
     throw (bad_pointer); // set_species()
 public:
-  // ctor: set center
-  explicit environment(lattice_point* center_);
-  // dtor: delete ensemble pointers
+  // ctor: set the groups of sites of the surface, what recognizes the
+  // ensembles of interest, where products can be put on the groups, and
+  // the position on the surface of the center point (also its position
+  // in the sequence of environments)
+  environment(const stencil* pattern_, const ensemble_matcher* matcher_,
+	      const placement_table* placements_, unsigned int index_);
+  // dtor: do nothing (ensembles belong to the pool)
   ~environment();
 
   // set the type of environment to use, return old type
@@ -131,33 +159,87 @@ public:
   // set the maximum number of sites required for any reaction in the mechanism
   // return old value
   static unsigned int set_max_sites(unsigned int max_sites_);
+  // return how many rows or columns a group of sites may reach from
+  // any of its environments
+  static unsigned int get_reach();
   // set the random number generator (must be done before initialization
   static void set_rng(rng* random_);
-  // set the empty site species
+  // set the empty site species (must be done before construction)
   static void set_empty_site(model_species* empty_site_);
+  // set the pool ensembles are taken from (must be done before
+  // initialization)
+  static void set_pool(ensemble_pool* pool_);
   // set the neighbors of this environment
   void set_neighbors(const matrix& surface)
     throw (bad_value); // this
-  // set up environment pointers using the given matrix of environments
+  // put the groups of sites containing this environment in GROUPS and
+  // the environments they contain in TOUCH by following the neighbors
+  // (done for one environment to create the stencil of the surface)
+  void connect(group& touch, group_set& groups)
+    throw (bad_input);		// connectivity()
+  // create the ensembles of this environment
   void initialize()
-    throw(bad_pointer, bad_input, bad_request); // this, connectivity(),
-				// create_ensembles()
-  // exchange an ensemble with a new one, update everything, put affected
-  // environments in changed
+    throw(bad_pointer, bad_request); // this, create_ensembles()
+  // as above, but taking the ensembles from POOL_ rather than the one
+  // shared by all environments (so several threads can initialize
+  // different environments at once)
+  void initialize(ensemble_pool& pool_)
+    throw(bad_pointer, bad_request); // this, create_ensembles()
+  // exchange an ensemble with a new one, update everything, put the
+  // ensembles replaced in remove and affected environments (in order of
+  // index) in changed; the new ensembles are those of the changed
+  // environments which are in no bucket (ensemble::get_handle())
+  void change_ensemble(ensemble* reactants, const model_species::seq& products,
+		       ensemble::seq& remove, seq& changed)
+    throw (bad_pointer, bad_request); // change_ensemble()
+  // as above, but making the random choices with RANDOM_ and taking the
+  // new ensembles from POOL_ rather than the ones shared by all
+  // environments (so several parts of the surface can be changed at once)
   void change_ensemble(ensemble* reactants, const model_species::seq& products,
-		       ensemble::deq& remove, group& changed)
+		       ensemble::seq& remove, seq& changed, rng& random_,
+		       ensemble_pool& pool_)
     throw (bad_pointer, bad_request); // this, place_species(),
 				// create_ensembles()
-  // return an iterator to the beginning of sites
-  group_set_citer sites_begin() const;
-  // return an iterator to the end of sites
-  group_set_citer sites_end() const;
+  // return whether the given environment is a neighbor of this one
+  bool is_neighbor(const environment* env) const;
+  // return the type of species on this site and any sites which share species
+  CH_STD::pair<model_species*,seq> get_species() const;
+  // put back a species (on the MULTISITE_ environments if it covers more
+  // than one) as it was when the surface was saved; must be done before
+  // initialization
+  void restore_species(model_species* center_species, const seq& multisite_)
+    throw (bad_request, bad_pointer); // this, lattice::set_species()
+  // return the position of this environment on the surface
+  unsigned int get_index() const;
   // return an iterator to the beginning sequence of ensembles
   ensemble::seq_citer ensembles_seq_begin() const;
   // return an iterator to the end sequence of ensembles
   ensemble::seq_citer ensembles_seq_end() const;
 }; // end class environment
 
+// inline functions
+// return the species which occupies the center site
+inline model_species*
+environment::get_center() const
+{
+  return pattern->get_surface()->get_species(index);
+}
+
+// return the position of this environment on the surface
+inline unsigned int
+environment::get_index() const
+{
+  return index;
+}
+
+// compare environments by their position on the surface
+inline bool
+environment::index_less::operator()(const environment* left,
+				    const environment* right) const
+{
+  return left->get_index() < right->get_index();
+}
+
 CH_END_NAMESPACE
 
 #endif // not CH_MODEL_ENVIRONMENT_H
@@ -24,12 +24,15 @@
 
 #include <cmath>
 #include "integrate.h"
+#include "benchmark.h"
 #include "compare.h"
 #include "kmc.h"
+#include "ode.h"
 #include "quantity.h"
 #include "precision.h"
 #include "reaction.h"
 #include "reactor.h"
+#include "steady.h"
 #include "t_string.h"
 
 // set namespace to avoid possible clashes
@@ -98,7 +101,8 @@ integrator::initial_values()
 // virtual method to initialize integrator (must be called from derived class)
 void
 integrator::initialize()
-  throw (bad_pointer, bad_input, bad_value, bad_type, bad_request)
+  throw (bad_pointer, bad_input, bad_value, bad_type, bad_request,
+	 bad_file)
 {
   // make sure mech got set
   if (mech == 0)
@@ -154,7 +158,7 @@ integrator::output_header()
 // output the current output point and its values to the given stream
 void
 integrator::output(double x)
-  throw (bad_type, bad_request, bad_value)
+  throw (bad_type, bad_request, bad_value, bad_file)
 {
   output(x, *out_file);
   return;
@@ -163,7 +167,7 @@ integrator::output(double x)
 // output the current output point and its values (no new line) to the stream
 void
 integrator::output(double x, CH_STD::ostream& output_stream)
-  throw (bad_type, bad_request, bad_value)
+  throw (bad_type, bad_request, bad_value, bad_file)
 {
   // output the current output point
   output_stream << x;
@@ -192,6 +196,14 @@ integrator::output(double x, CH_STD::ostream& output_stream)
   return;
 }
 
+// finish the output after the last output point (nothing to do)
+void
+integrator::finish()
+  throw (bad_file)
+{
+  return;
+}
+
 // integrator public methods
 // create a new integrator of the given type, return pointer or zero
 // must be changed when new classes are derived from integrator
@@ -204,6 +216,18 @@ integrator::new_integrator(const CH_STD::string& type)
     {
       return new kmc();
     }
+  else if (icompare(type, "ode") == 0)
+    {
+      return new ode();
+    }
+  else if (icompare(type, "steady") == 0)
+    {
+      return new steady();
+    }
+  else if (icompare(type, "benchmark") == 0)
+    {
+      return new benchmark();
+    }
   // else
   return 0;
 }
@@ -238,7 +262,8 @@ integrator::set_output(CH_STD::ofstream* out_file_)
 // generic integration method
 void
 integrator::solve(model_mechanism* mm)
-  throw (bad_pointer, bad_input, bad_value, bad_type, bad_request)
+  throw (bad_pointer, bad_input, bad_value, bad_type, bad_request,
+	 bad_file)
 {
   // set the mechanism so we don't have to pass it around to everything
   mech = mm;
@@ -263,11 +288,19 @@ integrator::solve(model_mechanism* mm)
   for (output_citer it = state_info->get_output()->begin();
        it != state_info->get_output()->end(); ++it)
     {
+      // skip output points not after the start, which has been output
+      // (a restarted run starts part way through)
+      if (*it <= x0)
+	{
+	  continue;		// for (it)
+	}
       // call the method to step from current output to next
       x_init = step(x_init, *it);
       // output current values
       output(x_init);
     }
+  // make sure all of the output is written
+  finish();
   return;
 }  
 
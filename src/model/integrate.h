@@ -52,7 +52,8 @@ private:
 protected:
   // virtual method to initialize integrator (must be called from derived class)
   virtual void initialize()
-    throw (bad_pointer, bad_input, bad_value, bad_type, bad_request); // this,
+    throw (bad_pointer, bad_input, bad_value, bad_type, bad_request,
+	   bad_file); // this,
                                 // this, state::initialize()
   // set initial value of the independent variable, return old
   double set_initial(double x0_ = 0.0e0);
@@ -60,11 +61,14 @@ protected:
   virtual void output_header();
   // output the current output point and its values (no new line) to *out_file
   virtual void output(double x)
-    throw (bad_type, bad_request, bad_value); // output()
+    throw (bad_type, bad_request, bad_value, bad_file); // output()
   // output the current output point and its values (no new line) to the stream
   virtual void output(double x, CH_STD::ostream& output_stream)
-    throw (bad_type, bad_request, bad_value); // integrate::output(),
+    throw (bad_type, bad_request, bad_value, bad_file); // integrate::output(),
                                 // model_species::get_quantity()
+  // virtual method to finish the output after the last output point
+  virtual void finish()
+    throw (bad_file); // this
 public:
   // ctor: (default) create default state, set other pointers to zero
   integrator();
@@ -87,9 +91,11 @@ public:
     throw (bad_file); // this
   // generic solving method
   void solve(model_mechanism* mm)
-    throw (bad_pointer, bad_input, bad_value, bad_type, bad_request); // this,
+    throw (bad_pointer, bad_input, bad_value, bad_type, bad_request,
+	   bad_file); // this,
 				// initial_values(), kmc::initialize(),
-				// output(), kmc::output(), kmc::step()
+				// output(), kmc::output(), kmc::step(),
+				// finish()
 }; // end class integrator
 
 CH_END_NAMESPACE
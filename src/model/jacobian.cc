@@ -0,0 +1,225 @@
+// Methods for the jacobian of the rates of the reactions of a mechanism.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "jacobian.h"
+#include <algorithm>
+#include <map>
+#include <set>
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// rate_jacobian methods
+// ctor: (default) no mechanism
+rate_jacobian::rate_jacobian()
+  : reactions(), row_start(1U, 0U), columns(), diagonal(), values(),
+    partial_start(1U, 0U), update_start(1U, 0U), update_positions(),
+    update_coefficients(), partials()
+{}
+
+// dtor: do nothing
+rate_jacobian::~rate_jacobian()
+{}
+
+// rate_jacobian public methods
+// find the pattern for the species and reactions
+/* The rate of a reaction depends on its reactants and, if reversible,
+ * its products, in the order model_reaction::rate_partials() gives
+ * their derivatives; each of those derivatives goes into the column of
+ * its species in the row of every species the reaction changes.
+ */
+void
+rate_jacobian::analyze(const model_species::seq& species_list,
+		       model_reaction::seq_citer begin,
+		       model_reaction::seq_citer end)
+{
+  reactions.assign(begin, end);
+  unsigned int n(species_list.size());
+  CH_STD::map<species*,unsigned int> index;
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      index[species_list[i]] = i;
+    }
+  // list the species each reaction depends on and changes
+  CH_STD::vector<CH_STD::vector<species*> > depends(reactions.size());
+  CH_STD::vector<CH_STD::vector<CH_STD::pair<unsigned int,double> > >
+    changes(reactions.size());
+  for (unsigned int r(0U); r < reactions.size(); ++r)
+    {
+      const stoich_map& reactants(reactions[r]->get_reactants());
+      for (stoich_map_citer it(reactants.begin()); it != reactants.end();
+	   ++it)
+	{
+	  depends[r].push_back(it->first);
+	}
+      if (reactions[r]->is_reversible())
+	{
+	  const stoich_map& products(reactions[r]->get_products());
+	  for (stoich_map_citer it(products.begin()); it != products.end();
+	       ++it)
+	    {
+	      depends[r].push_back(it->first);
+	    }
+	}
+      const stoich_map& net(reactions[r]->get_net_coefficients());
+      for (stoich_map_citer it(net.begin()); it != net.end(); ++it)
+	{
+	  CH_STD::map<species*,unsigned int>::const_iterator
+	    found(index.find(it->first));
+	  if (found != index.end() && it->second.get_coefficient() != 0.0e0)
+	    {
+	      double coefficient(it->second.get_coefficient());
+	      changes[r].push_back(CH_STD::make_pair(found->second,
+						     coefficient));
+	    }
+	}
+    }
+  // find the pattern, always with the diagonal
+  CH_STD::vector<CH_STD::set<unsigned int> > pattern(n);
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      pattern[i].insert(i);
+    }
+  for (unsigned int r(0U); r < reactions.size(); ++r)
+    {
+      for (unsigned int d(0U); d < depends[r].size(); ++d)
+	{
+	  CH_STD::map<species*,unsigned int>::const_iterator
+	    found(index.find(depends[r][d]));
+	  if (found == index.end())
+	    {
+	      continue;		// for (d)
+	    }
+	  for (unsigned int c(0U); c < changes[r].size(); ++c)
+	    {
+	      pattern[changes[r][c].first].insert(found->second);
+	    }
+	}
+    }
+  row_start.assign(1U, 0U);
+  columns.clear();
+  diagonal.resize(n);
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      diagonal[i] = columns.size()
+	+ CH_STD::distance(pattern[i].begin(), pattern[i].find(i));
+      columns.insert(columns.end(), pattern[i].begin(), pattern[i].end());
+      row_start.push_back(columns.size());
+    }
+  values.assign(columns.size(), 0.0e0);
+  // find where each derivative of each rate goes
+  partial_start.assign(1U, 0U);
+  update_start.assign(1U, 0U);
+  update_positions.clear();
+  update_coefficients.clear();
+  for (unsigned int r(0U); r < reactions.size(); ++r)
+    {
+      for (unsigned int d(0U); d < depends[r].size(); ++d)
+	{
+	  CH_STD::map<species*,unsigned int>::const_iterator
+	    found(index.find(depends[r][d]));
+	  if (found != index.end())
+	    {
+	      for (unsigned int c(0U); c < changes[r].size(); ++c)
+		{
+		  unsigned int i(changes[r][c].first);
+		  index_seq::const_iterator row(columns.begin() + row_start[i]);
+		  index_seq::const_iterator row_end(columns.begin()
+						    + row_start[i + 1U]);
+		  update_positions.push_back(CH_STD::lower_bound(row, row_end,
+								 found->second)
+					     - columns.begin());
+		  update_coefficients.push_back(changes[r][c].second);
+		}
+	    }
+	  update_start.push_back(update_positions.size());
+	}
+      partial_start.push_back(update_start.size() - 1U);
+    }
+  partials.assign(partial_start.back(), 0.0e0);
+  return;
+}
+
+// find the derivatives at temperature T from the current quantities
+void
+rate_jacobian::evaluate(double T, double R)
+  throw (bad_pointer, bad_type)
+{
+  CH_STD::fill(values.begin(), values.end(), 0.0e0);
+  for (unsigned int r(0U); r < reactions.size(); ++r)
+    {
+      if (partial_start[r] < partial_start[r + 1U])
+	{
+	  reactions[r]->rate_partials(T, &partials[partial_start[r]], R);
+	}
+    }
+  // add each into the rows of the species its reaction changes
+  for (unsigned int d(0U); d < partials.size(); ++d)
+    {
+      for (unsigned int u(update_start[d]); u < update_start[d + 1U]; ++u)
+	{
+	  values[update_positions[u]] += update_coefficients[u] * partials[d];
+	}
+    }
+  return;
+}
+
+// return the number of rows (and columns)
+unsigned int
+rate_jacobian::size() const
+{
+  return diagonal.size();
+}
+
+// return the start of each row in the nonzeros
+const rate_jacobian::index_seq&
+rate_jacobian::get_row_start() const
+{
+  return row_start;
+}
+
+// return the column of each nonzero
+const rate_jacobian::index_seq&
+rate_jacobian::get_columns() const
+{
+  return columns;
+}
+
+// return the position of the diagonal of each row in the nonzeros
+const rate_jacobian::index_seq&
+rate_jacobian::get_diagonal() const
+{
+  return diagonal;
+}
+
+// return the derivatives, in the order of the nonzeros
+const CH_STD::vector<double>&
+rate_jacobian::get_values() const
+{
+  return values;
+}
+
+CH_END_NAMESPACE
+
+/* $Id$ */
@@ -0,0 +1,96 @@
+// -*- C++ -*-
+// Class for the jacobian of the rates of the reactions of a mechanism.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_MODEL_JACOBIAN_H
+#define CH_MODEL_JACOBIAN_H 1
+
+#include <vector>
+#include "constant.h"
+#include "except.h"
+#include "reaction.h"
+#include "species.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// the derivatives of the rates of change of the species of a mechanism
+// (the sums of the net rates of their reactions times their net
+// stoichiometric coefficients) with respect to their quantities
+//
+// Species i depends on species j only if j is in the rate expression of
+// a reaction changing i, so the jacobian is sparse.  Its pattern is
+// found once from the stoichiometry, by rows (compressed sparse rows,
+// with every diagonal, see sparse_lu), along with where each derivative
+// of the rate of each reaction goes.  Each evaluation then only asks
+// each reaction for the derivatives of its rate and adds them in, in
+// time linear in the number of nonzeros.
+class rate_jacobian
+{
+public:
+  // set up typedef's
+  typedef CH_STD::vector<unsigned int> index_seq;
+
+private:
+  model_reaction::seq reactions; // reactions whose rates are differentiated
+  index_seq row_start;		// start of each row
+  index_seq columns;		// column of each nonzero
+  index_seq diagonal;		// position of the diagonal of each row
+  CH_STD::vector<double> values; // the derivatives
+  index_seq partial_start;	// first rate derivative of each reaction
+  index_seq update_start;	// first nonzero each rate derivative changes
+  index_seq update_positions;	// nonzero changed by each update
+  CH_STD::vector<double> update_coefficients; // net coefficient of each
+  CH_STD::vector<double> partials; // the rate derivatives of the reactions
+
+private:
+  // prevent copy construction and assignment
+  rate_jacobian(const rate_jacobian&);
+  rate_jacobian& operator=(const rate_jacobian&);
+public:
+  // ctor: (default) no mechanism
+  rate_jacobian();
+  // dtor: do nothing
+  ~rate_jacobian();
+
+  // find the pattern for the rows and columns SPECIES_LIST and the
+  // reactions from BEGIN to END (other species are taken as constant)
+  void analyze(const model_species::seq& species_list,
+	       model_reaction::seq_citer begin, model_reaction::seq_citer end);
+  // find the derivatives at temperature T from the current quantities
+  void evaluate(double T, double R = constant::r)
+    throw (bad_pointer, bad_type); // model_reaction::rate_partials()
+  // return the number of rows (and columns)
+  unsigned int size() const;
+  // return the start of each row in the nonzeros (and the end of the last)
+  const index_seq& get_row_start() const;
+  // return the column of each nonzero
+  const index_seq& get_columns() const;
+  // return the position of the diagonal of each row in the nonzeros
+  const index_seq& get_diagonal() const;
+  // return the derivatives, in the order of the nonzeros
+  const CH_STD::vector<double>& get_values() const;
+}; // end class rate_jacobian
+
+CH_END_NAMESPACE
+
+#endif // not CH_MODEL_JACOBIAN_H
+
+/* $Id$ */
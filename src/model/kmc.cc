@@ -23,27 +23,54 @@
 #endif
 
 #include "kmc.h"
+#include <algorithm>
+#include <cerrno>
 #include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <sstream>
 #include <typeinfo>
 #include "compare.h"
 #include "constant.h"
 #include "debug.h"
-#include "point.h"
 #include "precision.h"
 #include "quantity.h"
 #include "t_string.h"
+#include "thread.h"
 
 // set namespace to avoid possible clashes
 CH_BEGIN_NAMESPACE
 
+// static instance variables
+const char* const kmc::checkpoint_magic = "CHIMP kmc checkpoint";
+const unsigned int kmc::checkpoint_version = 3U;
+const char* const kmc::setup_phases[] = { "create environments",
+					  "set neighbors",
+					  "initialize environments" };
+
 // kmc methods
 // ctor: (default) set up defaults
 kmc::kmc()
-  : integrator(), random(0), sites(0U), surface(), environments(), ensembles(),
-    rxn_ens(), max_coordination(0U), max_sites(0U), surface_filename(),
-    surface_out(), steps(0U), event_rate(false), scale(1.0e0), rate_scale(),
-    rxn_count(), count_out(), env_type("nn"), env_radial(true)
+  : integrator(), random(0), sites(0U), surface(), pool(), environments(),
+    pattern(&surface, &environments), matcher(&surface), placements(),
+    ensemble_ids(),
+    ensemble_types(), buckets(), rxn_ens(), rxn_order(), net_rates(),
+    rates(), rxn_depend(), fluids(),
+    fluid_amounts(), fluid_depend(), stale_rates(), stale(),
+    rates_current(false), rate_temperature(0.0e0), exact_ramp(false),
+    ramp_window(1.0e0), window_T(0.0e0, 0.0e0), destroyed(), changed(),
+    max_coordination(0U),
+    max_sites(0U), surface_filename(),
+    surface_out(), surface_format("text"), surface_snapshots(0),
+    output_records(64U), writer(), steps(0U), event_rate(false),
+    scale(1.0e0), rate_scale(),
+    rxn_count(), count_out(), env_type("nn"), env_radial(true), threads(1U),
+    sublattice_events(1.0e0), domains(), sublattices(), env_domain(),
+    rxn_types(), unit_rates(), fluid_rxns(), replicas(1U),
+    replica_runs(), replica_mechs(), replica_x(), checkpoint_filename(),
+    checkpoint_steps(0U), checkpoint_seconds(0.0e0), checkpoint_step(0U),
+    checkpoint_time(0), restart_filename(), setup_times()
 {
   // set random to default rng
   random = rng::new_rng();
@@ -55,12 +82,30 @@ kmc::kmc()
 kmc::kmc(const kmc& o)
   throw (bad_pointer)
   : integrator(o), random(0), sites(o.sites), surface(o.surface),
-    environments(o.environments), ensembles(o.ensembles), rxn_ens(o.rxn_ens),
+    pool(), environments(o.environments), pattern(&surface, &environments),
+    matcher(&surface), placements(), ensemble_ids(o.ensemble_ids),
+    ensemble_types(o.ensemble_ids.size(), 0), buckets(o.buckets),
+    rxn_ens(o.rxn_ens),
+    rxn_order(o.rxn_order), net_rates(o.net_rates), rates(o.rates),
+    rxn_depend(o.rxn_depend), fluids(o.fluids),
+    fluid_amounts(o.fluid_amounts), fluid_depend(o.fluid_depend),
+    stale_rates(o.stale_rates), stale(o.stale), rates_current(false),
+    rate_temperature(o.rate_temperature), exact_ramp(o.exact_ramp),
+    ramp_window(o.ramp_window), window_T(o.window_T), destroyed(), changed(),
     max_coordination(o.max_coordination), max_sites(o.max_sites),
-    surface_filename(o.surface_filename), surface_out(), steps(0U),
+    surface_filename(o.surface_filename), surface_out(),
+    surface_format(o.surface_format), surface_snapshots(0),
+    output_records(o.output_records), writer(), steps(0U),
     event_rate(o.event_rate), scale(o.scale), rate_scale(o.rate_scale),
     rxn_count(o.rxn_count), count_out(), env_type(o.env_type),
-    env_radial(o.env_radial)
+    env_radial(o.env_radial), threads(o.threads),
+    sublattice_events(o.sublattice_events), domains(), sublattices(),
+    env_domain(), rxn_types(), unit_rates(), fluid_rxns(),
+    replicas(o.replicas), replica_runs(), replica_mechs(), replica_x(),
+    checkpoint_filename(o.checkpoint_filename),
+    checkpoint_steps(o.checkpoint_steps),
+    checkpoint_seconds(o.checkpoint_seconds), checkpoint_step(0U),
+    checkpoint_time(0), restart_filename(o.restart_filename), setup_times()
 {
   // make sure random on original was set
   if (o.random == 0)
@@ -72,6 +117,12 @@ kmc::kmc(const kmc& o)
     }
   // make a copy
   random = o.random->copy();
+  // point at the species of our own copy of each type of ensemble
+  for (ensemble_id_map_citer it(ensemble_ids.begin());
+       it != ensemble_ids.end(); ++it)
+    {
+      ensemble_types[it->second] = &it->first;
+    }
 }
 
 // dtor: delete the rng
@@ -79,6 +130,14 @@ kmc::~kmc()
 {
   // we own the random number generator
   delete random;
+  // and the snapshot file, which the writer may still be writing to
+  try
+    {
+      writer.finish();
+    }
+  catch (...)
+    {}
+  delete surface_snapshots;
   // loop through and delete the environments
   for (environment::seq_iter it(environments.begin());
        it != environments.end(); ++it)
@@ -86,6 +145,25 @@ kmc::~kmc()
       delete *it;
       *it = 0;
     }
+  // the domains own their random number generators and pools
+  for (domain::seq_iter it(domains.begin()); it != domains.end(); ++it)
+    {
+      delete *it;
+      *it = 0;
+    }
+  // the replicas use their mechanisms, so delete them first
+  for (CH_STD::vector<kmc*>::iterator it(replica_runs.begin());
+       it != replica_runs.end(); ++it)
+    {
+      delete *it;
+      *it = 0;
+    }
+  for (CH_STD::vector<model_mechanism*>::iterator it(replica_mechs.begin());
+       it != replica_mechs.end(); ++it)
+    {
+      delete *it;
+      *it = 0;
+    }
 }
 
 // kmc private methods
@@ -118,10 +196,43 @@ kmc::set_rng_seed(ul_int seed)
 // set everything up
 void
 kmc::initialize()
-  throw (bad_pointer, bad_input, bad_value, bad_type, bad_request)
+  throw (bad_pointer, bad_input, bad_value, bad_type, bad_request,
+	 bad_file)
 {
+  // time the phases of setting up, reported when debugging
+  setup_times.start();
+  // checkpoints hold the state of a single serial run
+  if ((checkpoint_filename.size() > 0U || restart_filename.size() > 0U)
+      && (threads > 1U || replicas > 1U))
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":kmc::initialize(): checkpoints can not be written "
+			"or restarted from when running in several threads "
+			"or with replicas");
+    }
+  // independent copies do the simulating if more than one was asked for
+  if (replicas > 1U)
+    {
+      // copy before anything is changed by initialization
+      create_replicas();
+      integrator::initialize();
+      setup_times.mark("create replicas");
+      report_setup();
+      return;
+    }
   // call the base class initializer
   integrator::initialize();
+  // the cycles of a parallel run hold the rates at the temperature the
+  // cycle starts at, so they can not follow a ramp exactly
+  if (threads > 1U && exact_ramp
+      && CH_STD::fabs(state_info->get_reactor()->get_heating_rate())
+      > precision::get().get_double())
+    {
+      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":kmc::initialize(): temperature_ramp exact can not "
+		      "be used with a heating rate when running in several "
+		      "threads");
+    }
   // call the kmc initializer for the reactor, and reset scale
   scale = state_info->get_reactor()->kmc_initialize(sites, scale);
   // calculate the maximum coordination needed by a surface species
@@ -139,9 +250,7 @@ kmc::initialize()
 	  // open up the surface output file, if one was specified
 	  if (surface_filename.size() > 0U)
 	    {
-	      // open the surface file, destroying contents
-	      // NOTE: could use safe_ofstream here
-	      surface_out.open(surface_filename.c_str());
+	      open_surface();
 	    }
 	}
       else
@@ -175,15 +284,37 @@ kmc::initialize()
   // set up the reaction counter
   initialize_rxn_counter();
   // initialize surface to be empty (does nothing if surface size is zero)
-  surface.initialize(empty);
-  // create environments and initialize them
+  surface.initialize(empty, get_surface_species());
+  // start the intervals between checkpoints now
+  checkpoint_step = steps;
+  checkpoint_time = CH_STD::time(0);
+  setup_times.mark("mechanism ensembles");
+  // continue where a previous run left off
+  if (restart_filename.size() > 0U)
+    {
+      restart(empty);
+      setup_times.mark("restart");
+      report_setup();
+      return;
+    }
+  // create environments
   create_environments(empty);
+  // fill the surface with the apropriate initial coverages
+  initial_coverage(empty);
+  setup_times.mark("initial coverage");
+  // create the ensembles of the covered surface
+  initialize_environments();
   // get ensembles of interest
   get_ensembles();
+  setup_times.mark("collect ensembles");
   // calculate the scaling factor for each reaction
   calc_rate_scale();
-  // fill the surface with the apropriate initial coverages
-  initial_coverage(empty);
+  // set up the reaction rate tree
+  index_reactions();
+  // determine which rates change when a reaction is performed
+  create_dependencies();
+  setup_times.mark("rates");
+  report_setup();
   return;
 }
 
@@ -200,6 +331,22 @@ kmc::calc_max_coordination()
   return max_coordination;
 }
 
+// return the species which occupy surface sites, in mechanism order
+model_species::seq
+kmc::get_surface_species() const
+{
+  model_species::seq surface_species;
+  for (model_species::seq_citer it(mech->species_seq_begin());
+       it != mech->species_seq_end(); ++it)
+    {
+      if ((*it)->get_surface_coordination() > 0U)
+	{
+	  surface_species.push_back(*it);
+	}
+    }
+  return surface_species;
+}
+
 // loop through the reactions and insert the surface reactants into ensembles
 void
 kmc::create_ensembles(model_species* empty_site)
@@ -227,32 +374,23 @@ kmc::create_ensembles(model_species* empty_site)
 	{
 	  // calculate max_sites
 	  max_sites = (coord > max_sites) ? coord : max_sites;
-	  // insert the reactant ensemble and empty map into ensembles
-	  // assign the iterator to forward
-	  ensemble_map_iter_pair forward_reverse;
-	  forward_reverse.first = 
-	    ensembles.insert(CH_STD::make_pair(reactant_ensemble,
-					       ens_env_map())).first;
-	  // should we insert the reverse reaction as well?
+	  // number the reactant ensemble, the forward type
+	  ensemble_id_pair forward_reverse(intern_ensemble(reactant_ensemble),
+					   ensemble::npos);
+	  // should we number the reverse ensemble as well?
 	  if ((*it)->is_reversible())
 	    {
-	      forward_reverse.second =
-		ensembles.insert(CH_STD::make_pair(product_ensemble, 
-						   ens_env_map())).first;
-	    }
-	  else			// not reversible
-	    {
-	      forward_reverse.second = ensembles.end();
+	      forward_reverse.second = intern_ensemble(product_ensemble);
 	    }
-	  // insert reaction and ensemble iterators into the map
+	  // insert reaction and ensemble types into the map
 	  rxn_ens.insert(CH_STD::make_pair(*it, forward_reverse));
 	}
       else
 	{
 	  // reaction does not involve surface or lattice not used
 	  rxn_ens.insert(CH_STD::make_pair(*it,
-					   CH_STD::make_pair(ensembles.end(),
-							     ensembles.end())));
+					   CH_STD::make_pair(ensemble::npos,
+							     ensemble::npos)));
 	}
     }
   // make sure ensembles of empty sites <= max_coordination are included
@@ -265,13 +403,33 @@ kmc::create_ensembles(model_species* empty_site)
 	  model_species::seq empties(i, empty_site);
 	  // create an ensemble with that sequence
 	  ensemble empty_ens(empties);
-	  // insert the ensemble into the map
-	  ensembles.insert(CH_STD::make_pair(empty_ens, ens_env_map()));
+	  // number the ensemble
+	  intern_ensemble(empty_ens);
 	}
     }
   return;
 }
 
+// return the number of the type of ensemble ENS, numbering it if new
+/* Types are numbered in the order the reactions first need them, so the
+ * numbers (and the order of the buckets) are the same every run, and
+ * the ensembles on the surface carry only the number.
+ */
+unsigned int
+kmc::intern_ensemble(const ensemble& ens)
+{
+  CH_STD::pair<ensemble_id_map_iter,bool>
+    result(ensemble_ids.insert(CH_STD::make_pair(ens,
+						 (unsigned int)
+						 ensemble_types.size())));
+  if (result.second)
+    {
+      ensemble_types.push_back(&result.first->first);
+      buckets.push_back(ensemble_bucket());
+    }
+  return result.first->second;
+}
+
 // setup rxn counter, if we need to
 void
 kmc::initialize_rxn_counter()
@@ -287,15 +445,27 @@ kmc::initialize_rxn_counter()
 	   it != mech->reaction_seq_end(); ++it)
 	{
 	  // insert this reaction into the map
-	  rxn_count.insert(CH_STD::make_pair(*it, CH_STD::make_pair(counter(), counter())));
+	  rxn_count.insert(CH_STD::make_pair(*it, counter_pair()));
 	}
     }
   return;
 }
 
-// create and initialize the environments
+// state shared by the threads setting up environments
+struct kmc::setup_cycle
+{
+  kmc* self;			// integrator being set up
+  thread_team* team;		// threads setting up environments
+  environment::matrix* env_surface; // environments by row and column
+  unsigned int first;		// first stage to perform
+  unsigned int last;		// last stage to perform
+  CH_STD::vector<ensemble_pool*> pools; // where each member gets ensembles
+};
+
+// create and connect the environments, find their groups of sites
 void
-kmc::create_environments(model_species* empty_site)
+kmc::create_environments(model_species* empty_site,
+			 const occupant_seq* occupants)
   throw (bad_request, bad_value, bad_pointer, bad_input)
 {
   // set environment static variables
@@ -309,47 +479,297 @@ kmc::create_environments(model_species* empty_site)
   environment::set_rng(random);
   // set the empty site species
   environment::set_empty_site(empty_site);
+  // set where environments get their ensembles
+  environment::set_pool(&pool);
   // get the size of the surface
   unsigned int surface_size(surface.get_size());
   // CREATE THE ENVIRONMENTS
-  // note: this is a killer, having to loop through three times to create,
-  // connect, and initialize the environments
-  // create a matrix of environments with the correct number of rows
-  environment::matrix env_surface(surface_size);
-  // get iterator to the first row
-  environment::matrix_iter row_it(env_surface.begin());
-  // loop through and create the columns
-  for (unsigned int row(0U); row < surface_size; ++row)
-    {
-      // reserve the proper length of the column
-      row_it->reserve(surface_size);
-      // loop through the columns
-      for (unsigned int col(0U); col < surface_size; ++col)
-	{
-	  // create environment pointer
-	  environment* ep = new environment(surface.get_point(row, col));
-	  // put it in the matrix
-	  row_it->push_back(ep);
-	  // put it in the sequence
-	  environments.push_back(ep);
-	}
-      // go to next row
-      ++row_it;
-    }
-  // now loop through all environments and have them set their neighbors
-  for (environment::seq_iter eit(environments.begin());
-       eit != environments.end(); ++eit)
-    {
-      // determine which environments are neighbors
-      (*eit)->set_neighbors(env_surface);
-    }
-  // now loop through again and initialize the surface environments
-  // this calculates all possible sites
-  for (environment::seq_iter eit(environments.begin());
-       eit != environments.end(); ++eit)
-    {
-      // call the initializer and get all the sites (sets of environments)
-      (*eit)->initialize();
+  // the environments are created, connected, and initialized in three
+  // passes, each shared out among the threads in blocks
+  environment::matrix env_surface(surface_size,
+				  environment::seq(surface_size, 0));
+  environments.assign(surface_size * surface_size, 0);
+  thread_team team(threads);
+  setup_cycle cycle;
+  cycle.self = this;
+  cycle.team = &team;
+  cycle.env_surface = &env_surface;
+  cycle.first = 0U;
+  cycle.last = 1U;
+  // create the environments and have them set their neighbors
+  team.run(&kmc::setup_work, &cycle);
+  // find the groups of sites every environment has
+  pattern.create();
+  // put back the species saved in a checkpoint
+  if (occupants != 0)
+    {
+      if (occupants->size() != environments.size())
+	{
+	  throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			    ":kmc::create_environments(): number of saved "
+			    "sites (" + t_string(occupants->size()) + ") does "
+			    "not match the number of environments ("
+			    + t_string(environments.size()) + ")");
+	}
+      for (unsigned int i(0U); i < environments.size(); ++i)
+	{
+	  // convert the indices of the sites covered into environments
+	  const CH_STD::vector<unsigned int>& covered((*occupants)[i].second);
+	  environment::seq multisite;
+	  multisite.reserve(covered.size());
+	  for (CH_STD::vector<unsigned int>::const_iterator it(covered.begin());
+	       it != covered.end(); ++it)
+	    {
+	      if (*it >= environments.size())
+		{
+		  throw bad_request(PACKAGE ":" __FILE__ ":" +
+				    t_string(__LINE__) +
+				    ":kmc::create_environments(): saved "
+				    "site index (" + t_string(*it) + ") is "
+				    "not on the surface");
+		}
+	      multisite.push_back(environments[*it]);
+	    }
+	  environments[i]->restore_species((*occupants)[i].first, multisite);
+	}
+    }
+  setup_times.mark("stencil");
+  return;
+}
+
+// number the types of ensemble and have the matcher recognize them
+void
+kmc::create_matcher()
+  throw (bad_pointer)
+{
+  matcher.clear();
+  for (unsigned int i(0U); i < ensemble_types.size(); ++i)
+    {
+      matcher.insert(*ensemble_types[i], i);
+    }
+  matcher.finish();
+  return;
+}
+
+// list the ways the products of the reactions covering more than one
+// site can be put on the groups of sites of the surface
+/* When the stencil shares the shapes of the groups among all of the
+ * points, those of the first point stand for every point; on a surface
+ * too small for that nothing is listed and the products are placed by
+ * searching the sites as they react.
+ */
+void
+kmc::create_placements()
+  throw (bad_request)
+{
+  placements.clear();
+  if (!pattern.is_shared())
+    {
+      return;
+    }
+  // the products put on the ensembles of each reaction (and the
+  // reactants put on the products if it is reversible), with the sites
+  // they cover, if any covers more than one
+  CH_STD::vector<CH_STD::pair<unsigned int,const model_species::seq*> >
+    products;
+  for (model_reaction::seq_citer it(mech->reaction_seq_begin());
+       it != mech->reaction_seq_end(); ++it)
+    {
+      rxn_ensemble_map_citer rxn_ens_it(rxn_ens.find(*it));
+      if (rxn_ens_it == rxn_ens.end()
+	  || rxn_ens_it->second.first == ensemble::npos)
+	{
+	  continue;		// for (it)
+	}
+      const model_species::seq* sides[2] = { (*it)->get_product_seq_ptr(),
+					     0 };
+      if (rxn_ens_it->second.second != ensemble::npos)
+	{
+	  sides[1] = (*it)->get_reactant_seq_ptr();
+	}
+      for (unsigned int i(0U); i < 2U; ++i)
+	{
+	  if (sides[i] == 0)
+	    {
+	      continue;		// for (i)
+	    }
+	  for (model_species::seq_citer sp(sides[i]->begin());
+	       sp != sides[i]->end(); ++sp)
+	    {
+	      if ((*sp)->get_surface_coordination() > 1U)
+		{
+		  products.push_back(CH_STD::make_pair(ensemble(*sides[i])
+						       .get_coordination(),
+						       sides[i]));
+		  break;	// for (sp)
+		}
+	    }
+	}
+    }
+  if (products.empty())
+    {
+      return;
+    }
+  // list their placements on each group of the same size
+  environment::seq members;
+  CH_STD::vector<unsigned int> ends;
+  pattern.get_groups(0U, members, ends);
+  for (unsigned int g(0U); g < ends.size(); ++g)
+    {
+      environment::seq group(members.begin() + ((g > 0U) ? ends[g - 1U] : 0U),
+			     members.begin() + ends[g]);
+      for (unsigned int i(0U); i < products.size(); ++i)
+	{
+	  if (products[i].first == group.size())
+	    {
+	      placements.insert(g, group, *products[i].second);
+	    }
+	}
+    }
+  return;
+}
+
+// create the ensembles of the environments for the species on them
+void
+kmc::initialize_environments()
+  throw (bad_request, bad_pointer)
+{
+  // environments only keep the ensembles the mechanism has
+  create_matcher();
+  create_placements();
+  thread_team team(threads);
+  setup_cycle cycle;
+  cycle.self = this;
+  cycle.team = &team;
+  cycle.env_surface = 0;
+  // each member of the team takes ensembles from a pool of its own
+  // (the first using ours)
+  cycle.first = 2U;
+  cycle.last = 2U;
+  cycle.pools.assign(1U, &pool);
+  for (unsigned int i(1U); i < team.get_size(); ++i)
+    {
+      cycle.pools.push_back(new ensemble_pool());
+    }
+  CH_STD::string failure;
+  try
+    {
+      team.run(&kmc::setup_work, &cycle);
+    }
+  catch (bad_request& e)
+    {
+      // hand over the ensembles created so far before giving up
+      failure = e.what();
+    }
+  // the environments now use ensembles from all of the pools
+  for (unsigned int i(1U); i < cycle.pools.size(); ++i)
+    {
+      pool.take(*cycle.pools[i]);
+      delete cycle.pools[i];
+      cycle.pools[i] = 0;
+    }
+  if (failure.size() > 0U)
+    {
+      throw bad_request(failure);
+    }
+  return;
+}
+
+// what each thread setting up environments does, DATA is a setup_cycle
+void
+kmc::setup_work(void* data, unsigned int rank)
+{
+  setup_cycle* cycle(static_cast<setup_cycle*>(data));
+  thread_team* team(cycle->team);
+  for (unsigned int stage(cycle->first); stage <= cycle->last; ++stage)
+    {
+      // a member leaving early would leave the others at the barrier
+      try
+	{
+	  cycle->self->setup_stage(*cycle, stage, rank, team->get_size());
+	}
+      catch (CH_STD::exception& e)
+	{
+	  team->fail(e.what());
+	}
+      catch (...)
+	{
+	  team->fail("kmc::setup_work(): unknown exception");
+	}
+      bool passed(team->barrier());
+      // time the stage once every member has finished it
+      if (rank == 0U)
+	{
+	  cycle->self->setup_times.mark(setup_phases[stage]);
+	}
+      if (!passed)
+	{
+	  break;		// for (stage)
+	}
+    }
+  return;
+}
+
+// perform stage STAGE of setting up the environments as member RANK
+// of a team of SIZE
+/* Each member takes a block of consecutive environments.  Creating an
+ * environment and setting its neighbors only write to that
+ * environment (and its own places in the containers, which were sized
+ * beforehand), and creating its ensembles only reads the species of
+ * the others, so the members never touch the same data.
+ */
+void
+kmc::setup_stage(setup_cycle& cycle, unsigned int stage, unsigned int rank,
+		 unsigned int size)
+  throw (bad_value, bad_pointer, bad_request)
+{
+  unsigned int count(environments.size());
+  unsigned int begin((unsigned long) count * rank / size);
+  unsigned int end((unsigned long) count * (rank + 1U) / size);
+  unsigned int columns(surface.get_size());
+  switch (stage)
+    {
+    case 0U:			// create the environments
+      for (unsigned int i(begin); i < end; ++i)
+	{
+	  // its index is that of its lattice point
+	  environment* ep(new environment(&pattern, &matcher, &placements,
+					  i));
+	  environments[i] = ep;
+	  (*cycle.env_surface)[i / columns][i % columns] = ep;
+	}
+      break;
+
+    case 1U:			// connect them
+      for (unsigned int i(begin); i < end; ++i)
+	{
+	  environments[i]->set_neighbors(*cycle.env_surface);
+	}
+      break;
+
+    case 2U:			// create their ensembles
+      for (unsigned int i(begin); i < end; ++i)
+	{
+	  environments[i]->initialize(*cycle.pools[rank]);
+	}
+      break;
+
+    default:
+      throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":kmc::setup_stage(): unknown stage " +
+		      t_string(stage));
+      break;
+    }
+  return;
+}
+
+// write how long each phase of setting up took to the debugging stream
+void
+kmc::report_setup() const
+{
+  if (debug::get().get_level() > 0U)
+    {
+      setup_times.report(debug::get().get_stream(), "kmc setup:");
     }
   return;
 }
@@ -359,31 +779,29 @@ kmc::create_environments(model_species* empty_site)
 void
 kmc::get_ensembles()
 {
-  // create a set from the vector of environments
-  environment::group env_set(environments.begin(), environments.end());
   // insert the ensembles currently offered by the surface into ensembles
-  get_ensembles(env_set);
+  get_ensembles(environments);
   return;
 }
 
 // get the ensembles from the given environments and put them in ensembles
 void
-kmc::get_ensembles(environment::group& changed_environments)
+kmc::get_ensembles(const environment::seq& changed_environments)
 {
   // loop through environments and get the ensembles offered by each
-  for (environment::group_iter env_it(changed_environments.begin());
+  for (environment::seq_citer env_it(changed_environments.begin());
        env_it != changed_environments.end(); ++env_it)
     {
       // loop through the ensembles at this environment
       for (ensemble::seq_citer it((*env_it)->ensembles_seq_begin());
 	   it != (*env_it)->ensembles_seq_end(); ++it)
 	{
-	  // see if this ensemble is in the current mechanism
-	  ensemble_map_iter em_it(ensembles.find(**it));
-	  if (em_it != ensembles.end())
+	  // insert this specific ensemble and environment into the bucket
+	  // of its type (it would not be here if it were of no interest),
+	  // unless it was there before the environment changed
+	  if ((*it)->get_handle() == ensemble::npos)
 	    {
-	      // insert this specific ensemble and environment into the map
-	      em_it->second.insert(CH_STD::make_pair(*it, *env_it));
+	      buckets[(*it)->get_type()].insert(*it, *env_it);
 	    }
 	}
     }
@@ -403,16 +821,17 @@ kmc::calc_rate_scale()
   if (event_rate)
     {
       // loop through all the reactions
-      for (rxn_ensemble_iter_map_iter rxn_ens_it(rxn_ens.begin());
+      for (rxn_ensemble_map_iter rxn_ens_it(rxn_ens.begin());
 	   rxn_ens_it != rxn_ens.end(); ++rxn_ens_it)
 	{
 	  double scale(1.0e0);
 	  // make sure there is a surface ensemble
-	  if (rxn_ens_it->second.first != ensembles.end())
+	  if (rxn_ens_it->second.first != ensemble::npos)
 	    {
 	      // avoid multiple counting of multisite ensembles
 	      unsigned int
-		coord(rxn_ens_it->second.first->first.get_coordination());
+		coord(ensemble_types[rxn_ens_it->second.first]
+		      ->get_coordination());
 	      if (coord < 1U)
 		{
 		  throw bad_request(PACKAGE ":" __FILE__ ":" +
@@ -463,7 +882,7 @@ kmc::calc_rate_scale()
       // we only are performing kmc on a small part and replicating it
       reactor_scale /= scale;
       // loop through all the reactions
-      for (rxn_ensemble_iter_map_iter rxn_ens_it(rxn_ens.begin());
+      for (rxn_ensemble_map_iter rxn_ens_it(rxn_ens.begin());
 	   rxn_ens_it != rxn_ens.end(); ++rxn_ens_it)
 	{
 	  // initialize the scaling factors for this reaction
@@ -471,7 +890,7 @@ kmc::calc_rate_scale()
 	  double r_scale(reactor_scale);
 	  // see if there is a surface ensemble
 	  // (non gas-phase reaction using lattice)
-	  if (rxn_ens_it->second.first != ensembles.end())
+	  if (rxn_ens_it->second.first != ensemble::npos)
 	    {
 	      // scaling for the total number of sites this size (``coverage'')
 	      double inv_sites(site_scale(rxn_ens_it, site_count));
@@ -496,15 +915,17 @@ void
 kmc::count_sites(CH_STD::vector<counter>& site_count) const
   throw (bad_value)
 {
+  environment::seq members;
+  CH_STD::vector<unsigned int> ends;
   // loop through all the environments
   for (environment::seq_citer env_it(environments.begin());
        env_it != environments.end(); ++env_it)
     {
       // loop through the sites at this environment
-      for (environment::group_set_citer site_it((*env_it)->sites_begin());
-	   site_it != (*env_it)->sites_end(); ++site_it)
+      pattern.get_groups((*env_it)->get_index(), members, ends);
+      for (unsigned int i(0U); i < ends.size(); ++i)
 	{
-	  unsigned int site_size(site_it->size());
+	  unsigned int site_size(ends[i] - ((i > 0U) ? ends[i - 1U] : 0U));
 	  // make sure not to overun vector boundaries
 	  if (site_size > max_sites)
 	    {
@@ -531,13 +952,13 @@ kmc::count_sites(CH_STD::vector<counter>& site_count) const
 
 // return the inverse of the total possible sites available for this rxn
 double
-kmc::site_scale(rxn_ensemble_iter_map_iter rxn_ens_it,
+kmc::site_scale(rxn_ensemble_map_iter rxn_ens_it,
 		const CH_STD::vector<counter>& site_count) const
   throw (bad_value)
 {
   // get the size of the ensemble for this reaction
   unsigned int
-    ens_coord(rxn_ens_it->second.first->first.get_coordination());
+    ens_coord(ensemble_types[rxn_ens_it->second.first]->get_coordination());
   // get the total ensembles of this size on the surface
   int possible_sites(get_site_count(site_count, ens_coord));
   // make sure there are sets of environments of this size
@@ -580,7 +1001,7 @@ kmc::get_site_count(const CH_STD::vector<counter>& site_count, int size) const
 
 // scaling correction for reactios with multisite species
 void
-kmc::multisite_scale(rxn_ensemble_iter_map_iter rxn_ens_it,
+kmc::multisite_scale(rxn_ensemble_map_iter rxn_ens_it,
 		     const CH_STD::vector<counter>& site_count,
 		     double& f_scale, double& r_scale) const
   throw (bad_value)
@@ -694,7 +1115,7 @@ kmc::coverage_scale(const stoich_map& reactants) const
 // initialize the surface to the appropriate coverages
 void
 kmc::initial_coverage(model_species* empty_site)
-  throw (bad_input, bad_request, bad_value, bad_pointer, bad_type)
+  throw (bad_input, bad_request, bad_value, bad_pointer, bad_type, bad_file)
 {
   // see if we have to do anything
   if (!empty_site)
@@ -747,21 +1168,74 @@ kmc::initial_coverage(model_species* empty_site)
 		  rxn.add_product(*sp_it);
 		  // set the current coverage to zero
 		  (*sp_it)->set_quantity(quantity::Econcentration, 0.0e0);
-		  // perform the reaction until desired coverage is reached
+		  // get the groups of empty sites it could go on, in random
+		  // order (choosing each time at random among the groups
+		  // still empty, as a reaction would)
+		  environment::seq members;
+		  CH_STD::vector<unsigned int> ends;
+		  empty_places(empty_site, coord, members, ends);
+		  CH_STD::vector<unsigned int> order(ends.size());
+		  for (unsigned int i(0U); i < order.size(); ++i)
+		    {
+		      order[i] = i;
+		    }
+		  CH_STD::random_shuffle(order.begin(), order.end(), *random);
+		  CH_STD::vector<unsigned int>::const_iterator
+		    place_it(order.begin());
+		  // place the species until desired coverage is reached
 		  while ((*sp_it)->get_quantity() < coverage - 5.0e-1 / sites)
 		    {
-		      // perform the reaction and make sure it goes
-		      if (!perform_reaction(rxn))
+		      // find the next group still empty
+		      environment::seq_citer begin;
+		      environment::seq_citer end;
+		      for (; place_it != order.end(); ++place_it)
 			{
-			  // no more of the required ensemble type
+			  begin = members.begin()
+			    + ((*place_it > 0U) ? ends[*place_it - 1U] : 0U);
+			  end = members.begin() + ends[*place_it];
+			  environment::seq_citer it(begin);
+			  while (it != end
+				 && surface.get_species((*it)->get_index())
+				 == empty_site)
+			    {
+			      ++it;
+			    }
+			  if (it == end)
+			    {
+			      break;	// for (place_it)
+			    }
+			}
+		      if (place_it == order.end())
+			{
+			  // no more groups of empty sites large enough
 			  break;	// while (coverage)
 			}
-		      // debugging information
-		      if (debug::get().get_level() > 2U)
+		      ++place_it;
+		      // put the species on each site of the group, covering
+		      // the others as well
+		      for (environment::seq_citer it(begin); it != end; ++it)
 			{
-			  // output surface and quantity information
-			  output(0.0e0, debug::get().get_stream());
+			  environment::seq multisite;
+			  for (environment::seq_citer mit(begin); mit != end;
+			       ++mit)
+			    {
+			      if (mit != it)
+				{
+				  multisite.push_back(*mit);
+				}
+			    }
+			  (*it)->restore_species(*sp_it, multisite);
 			}
+		      // update the coverages using the reactor equations
+		      state_info->get_reactor()
+			->kmc_reaction(*rxn.get_reactant_seq_ptr(),
+				       *rxn.get_product_seq_ptr(), scale);
+		    }
+		  // debugging information
+		  if (debug::get().get_level() > 2U)
+		    {
+		      // output surface and quantity information
+		      output(0.0e0, debug::get().get_stream());
 		    }
 		}
 	      // increment the total coverage
@@ -788,38 +1262,114 @@ kmc::initial_coverage(model_species* empty_site)
   return;
 }
 
+// put each group of COORD empty sites once in MEMBERS, their ends in ENDS
+void
+kmc::empty_places(model_species* empty_site, unsigned int coord,
+		  environment::seq& members,
+		  CH_STD::vector<unsigned int>& ends) const
+{
+  members.clear();
+  ends.clear();
+  environment::seq groups;
+  CH_STD::vector<unsigned int> group_ends;
+  for (environment::seq_citer env_it(environments.begin());
+       env_it != environments.end(); ++env_it)
+    {
+      unsigned int index((*env_it)->get_index());
+      if (surface.get_species(index) != empty_site)
+	{
+	  continue;		// for (env_it)
+	}
+      // every group containing this site is in its list, so only take
+      // those it is the lowest index site of
+      pattern.get_groups(index, groups, group_ends);
+      for (unsigned int i(0U); i < group_ends.size(); ++i)
+	{
+	  unsigned int begin((i > 0U) ? group_ends[i - 1U] : 0U);
+	  if (group_ends[i] - begin != coord
+	      || *CH_STD::min_element(groups.begin() + begin,
+				      groups.begin() + group_ends[i],
+				      environment::index_less()) != *env_it)
+	    {
+	      continue;		// for (i)
+	    }
+	  // make sure all of its sites are empty
+	  unsigned int j(begin);
+	  while (j < group_ends[i]
+		 && surface.get_species(groups[j]->get_index()) == empty_site)
+	    {
+	      ++j;
+	    }
+	  if (j == group_ends[i])
+	    {
+	      members.insert(members.end(), groups.begin() + begin,
+			     groups.begin() + j);
+	      ends.push_back(members.size());
+	    }
+	}
+    }
+  return;
+}
+
 // method to handle a kinetic Monte Carlo solution
 double
 kmc::step(double xi, double xf)
-  throw (bad_pointer, bad_type, bad_value, bad_request, bad_input)
+  throw (bad_pointer, bad_type, bad_value, bad_request, bad_input,
+	 bad_file)
 {
   // step within a try block so we can output information if it fails
   try
     {
+      // see if the replicas do the work
+      if (!replica_runs.empty())
+	{
+	  replica_steps(xf);
+	  return xf;
+	}
+      // see if the events should be spread across threads
+      if (threads > 1U && parallel_steps(xi, xf))
+	{
+	  return xi;
+	}
+      // see if a checkpoint is due between output points
+      checkpoint(xi, true);
+      // see if the rates must be followed through a temperature ramp
+      if (exact_ramp
+	  && CH_STD::fabs(state_info->get_reactor()->get_heating_rate())
+	  > precision::get().get_double())
+	{
+	  ramp_steps(xi, xf);
+	  return xi;
+	}
       // perform Monte Carlo steps until the final time is reached
       while (xi < xf)
 	{
+	  // see if a checkpoint is due before the next event
+	  checkpoint(xi);
 	  // appropriately choose a reaction
-	  CH_STD::pair<rxn_ensemble_iter_map_iter,double>
-	    rxn_for_rev_it_rate(select_reaction());
+	  CH_STD::pair<unsigned int,double> rxn_rate(select_reaction());
+	  rxn_ensemble_map_iter rxn_for_rev_it(rxn_order[rxn_rate.first]);
 	  // debugging information
 	  if (debug::get().get_level() > 1U)
 	    {
 	      // output the reaction performed and time
 	      debug::get().get_stream() << "kmc step " << steps + 1
 		<< ":x = " << xi << ":reaction "
-		<< rxn_for_rev_it_rate.first->first->stringify()
+		<< rxn_for_rev_it->first->stringify()
 		<< CH_STD::endl;
 	    }
 	  // perform the reaction
-	  perform_reaction(rxn_for_rev_it_rate.first,
-			   rxn_for_rev_it_rate.second);
+	  perform_reaction(rxn_for_rev_it, rxn_rate.second);
+	  // only the rates sharing its species have changed
+	  mark_dependents(rxn_rate.first);
 	  // get the time step (inverse of total transistion probability)
-	  double dx(-(CH_STD::log(random->get_random_open_open())
-		      / CH_STD::fabs(rxn_for_rev_it_rate.second)));
+	  double dx(random->get_random_exponential()
+		    / CH_STD::fabs(rxn_rate.second));
 	  // have the reactor update everything
 	  state_info->get_reactor()->kmc_step(mech->species_seq_begin(),
 					      mech->species_seq_end(), dx);
+	  // see if the reactor changed anything the rates depend on
+	  check_reactor();
 	  // update the independent variable
 	  xi += dx;
 	  // increment the kmc step counter
@@ -833,126 +1383,1774 @@ kmc::step(double xi, double xf)
     }
   catch (CH_STD::exception& e)
     {
-      // say we caught an exception
-      *out_file << "# caught exception" << CH_STD::endl;
-      // try to print out current output values
-      output(xi);
+      // replicas have no output file of their own
+      if (out_file != 0)
+	{
+	  // say we caught an exception, after the records still queued
+	  emit(*out_file, "# caught exception\n");
+	  // try to print out current output values
+	  output(xi);
+	  // write it all out now, keeping the exception we caught
+	  try
+	    {
+	      finish();
+	    }
+	  catch (bad_file&)
+	    {}
+	}
       // throw it again
       throw;
     }
   return xi;
 }
 
-// calculate total probability and select a reaction to be performed
-// return that reaction, its ensembles, and total transition probability
-// the sign of the total transition probability determines the direction
-// of the reaction
-CH_STD::pair<kmc::rxn_ensemble_iter_map_iter,double>
-kmc::select_reaction()
-  throw (bad_pointer, bad_type, bad_request)
+// put the reactions in order for selection and size the rate tree
+void
+kmc::index_reactions()
 {
-  // the total transition (reaction) probability
-  double total_rate(0.0e0);
-  // map of the reactions and their rates (to determine direction of reaction)
-  CH_STD::map<model_reaction*,double> rates;
-  // the map of the cumulative rate and reaction it corresponds to
-  CH_STD::map<double,rxn_ensemble_iter_map_iter> cum_rates;
-  // get the rates for each reaction in the mechanism
-  for (rxn_ensemble_iter_map_iter rxn_ens_it(rxn_ens.begin());
-       rxn_ens_it != rxn_ens.end(); ++rxn_ens_it)
-    {
-      // get the net rate of the reaction
-      double net_rate(get_net_rate(rxn_ens_it));
-      // insert net rate into map
-      rates.insert(CH_STD::make_pair(rxn_ens_it->first, net_rate));
-      // update the total rate for all moves (reactions)
-      double old_total(total_rate);
-      total_rate += CH_STD::fabs(net_rate);
-      // make sure net rate != 0
-      if (total_rate > old_total)
-	{
-	  // insert new total rate and the corresponding reaction/ensemble
-	  // iterator into cumulative map
-	  cum_rates.insert(CH_STD::make_pair(total_rate, rxn_ens_it));
-	}
-    }
-  // make sure a reaction is possible
-  if (total_rate < precision::get().get_double())
+  // start over
+  rxn_order.clear();
+  // each reaction gets the next leaf in the tree, in mechanism order so
+  // selection does not depend on where reactions are in memory
+  for (model_reaction::seq_citer it(mech->reaction_seq_begin());
+       it != mech->reaction_seq_end(); ++it)
     {
-      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
-			":kmc::select_reaction(): sum total of all absolute "
-			"rates is equivalent to zero: "
-			+ t_string(total_rate));
+      rxn_order.push_back(rxn_ens.find(*it));
     }
-  // get random number in range [0, total_rate)
-  double r(random->get_random_open(total_rate));
-  // insert into cum_rates map and get iterator
-  CH_STD::pair<CH_STD::map<double,rxn_ensemble_iter_map_iter>::iterator,bool>
-    rate_rxn_ens_it_bool(cum_rates.insert(CH_STD::make_pair(r, rxn_ens.end())));
-  // next entry is the one we want
-  ++rate_rxn_ens_it_bool.first;
-  // get the rate
-  CH_STD::map<model_reaction*,double>::iterator
-    rate_it(rates.find(rate_rxn_ens_it_bool.first->second->first));
-  // make sure it found it
-  if (rate_it == rates.end())
+  // all rates are zero until the first selection
+  net_rates.assign(rxn_order.size(), 0.0e0);
+  rates.resize(rxn_order.size());
+  // nothing is known about the rates yet
+  stale_rates.clear();
+  stale.assign(rxn_order.size(), false);
+  rates_current = false;
+  return;
+}
+
+// determine which reaction rates depend on each reaction and fluid
+/* A rate depends only on the quantities of the species in its
+ * reactants and products and on the number of its forward and reverse
+ * ensembles.  Performing a reaction changes the quantities of its own
+ * species, and only ensembles containing one of its (surface) species
+ * can be destroyed or created, since the sites that change hold those
+ * species before or after.  Reactions sharing a species with the one
+ * performed are therefore the only ones whose rates can change.
+ */
+void
+kmc::create_dependencies()
+{
+  // map each species to the reactions it appears in
+  CH_STD::map<species*,CH_STD::vector<unsigned int> > species_rxns;
+  for (unsigned int i(0U); i < rxn_order.size(); ++i)
     {
-      throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
-			":kmc::select_reaction(): rate/reaction map has "
-			"been corrupted");
+      model_reaction* rxn(rxn_order[i]->first);
+      // species on either side affect the rate
+      for (stoich_map_citer it(rxn->get_reactants().begin());
+	   it != rxn->get_reactants().end(); ++it)
+	{
+	  species_rxns[it->first].push_back(i);
+	}
+      for (stoich_map_citer it(rxn->get_products().begin());
+	   it != rxn->get_products().end(); ++it)
+	{
+	  // do not enter a species on both sides twice
+	  if (rxn->get_reactants().find(it->first)
+	      == rxn->get_reactants().end())
+	    {
+	      species_rxns[it->first].push_back(i);
+	    }
+	}
     }
-  // determine sign of rate
-  if (rate_it->second < 0.0e0)
+  // each reaction affects all the reactions its species appear in
+  rxn_depend.assign(rxn_order.size(), CH_STD::vector<unsigned int>());
+  for (CH_STD::map<species*,CH_STD::vector<unsigned int> >::const_iterator
+	 sp_it(species_rxns.begin()); sp_it != species_rxns.end(); ++sp_it)
     {
-      // reverse reaction
-      total_rate *= -1.0e0;
-      // increment the counter, if necessary
-      if (count_out.is_open())
+      for (CH_STD::vector<unsigned int>::const_iterator
+	     i_it(sp_it->second.begin()); i_it != sp_it->second.end(); ++i_it)
 	{
-	  ++(rxn_count[rate_rxn_ens_it_bool.first->second->first].second);
+	  rxn_depend[*i_it].insert(rxn_depend[*i_it].end(),
+				   sp_it->second.begin(), sp_it->second.end());
 	}
     }
-  // forward reaction
-  else if (count_out.is_open())
+  // remove the duplicates
+  for (unsigned int i(0U); i < rxn_depend.size(); ++i)
     {
-      ++(rxn_count[rate_rxn_ens_it_bool.first->second->first].first);
+      CH_STD::sort(rxn_depend[i].begin(), rxn_depend[i].end());
+      rxn_depend[i].erase(CH_STD::unique(rxn_depend[i].begin(),
+					 rxn_depend[i].end()),
+			  rxn_depend[i].end());
     }
-  // return the pair
-  return CH_STD::make_pair(rate_rxn_ens_it_bool.first->second, total_rate);
+  // the reactor can change fluid quantities in a step (e.g., flow)
+  fluids.clear();
+  fluid_amounts.clear();
+  fluid_depend.clear();
+  for (model_species::seq_citer it(mech->species_seq_begin());
+       it != mech->species_seq_end(); ++it)
+    {
+      // see if it is a fluid species in a reaction
+      CH_STD::map<species*,CH_STD::vector<unsigned int> >::const_iterator
+	sp_it(species_rxns.find(*it));
+      if ((*it)->get_surface_coordination() < 1U && sp_it != species_rxns.end())
+	{
+	  fluids.push_back(*it);
+	  fluid_amounts.push_back(0.0e0);
+	  fluid_depend.push_back(sp_it->second);
+	}
+    }
+  return;
 }
 
-// calculate the net reaction rate of a reaction
-double
-kmc::get_net_rate(rxn_ensemble_iter_map_citer rxn_ens_it) const
-  throw (bad_pointer, bad_type, bad_request)
+// flag the rate of the reaction at leaf I for recalculation
+void
+kmc::mark_stale(unsigned int i)
 {
-  // set up needed rate variables
-  double f_rate(0.0e0);
-  double r_rate(0.0e0);
-  if (sites > 0U)		// lattice is used
+  // only put it in the list once
+  if (!stale[i])
     {
-      // get the rates excluding the surface species
-      f_rate = rxn_ens_it->first->get_fluid_forward_rate(state_info->get_reactor()->get_temperature());
-      r_rate = rxn_ens_it->first->get_fluid_reverse_rate(state_info->get_reactor()->get_temperature());
+      stale[i] = true;
+      stale_rates.push_back(i);
     }
-  else				// no lattice
+  return;
+}
+
+// flag the reactions affected by performing the reaction at leaf I
+void
+kmc::mark_dependents(unsigned int i)
+{
+  for (CH_STD::vector<unsigned int>::const_iterator it(rxn_depend[i].begin());
+       it != rxn_depend[i].end(); ++it)
+    {
+      mark_stale(*it);
+    }
+  return;
+}
+
+// flag the reactions affected by changes the reactor made in a step
+void
+kmc::check_reactor()
+  throw (bad_type)
+{
+  // nothing to do if everything will be recalculated anyway
+  if (!rates_current)
+    {
+      return;
+    }
+  // every rate constant changes with temperature
+  if (state_info->get_reactor()->get_temperature() != rate_temperature)
+    {
+      rates_current = false;
+      return;
+    }
+  check_fluids();
+  return;
+}
+
+// flag the reactions affected by fluid quantities the reactor changed
+void
+kmc::check_fluids()
+  throw (bad_type)
+{
+  // see which fluid quantities are different from when rates were found
+  quantity::type fluid_type(state_info->get_reactor()->get_fluid_type());
+  for (unsigned int f(0U); f < fluids.size(); ++f)
+    {
+      if (fluids[f]->get_quantity(fluid_type) != fluid_amounts[f])
+	{
+	  for (CH_STD::vector<unsigned int>::const_iterator
+		 it(fluid_depend[f].begin()); it != fluid_depend[f].end(); ++it)
+	    {
+	      mark_stale(*it);
+	    }
+	}
+    }
+  return;
+}
+
+// recalculate the stale rates and update the rate tree
+void
+kmc::update_rates()
+  throw (bad_pointer, bad_type, bad_request, bad_value)
+{
+  if (rates_current)
+    {
+      // only recalculate what may have changed
+      for (CH_STD::vector<unsigned int>::const_iterator
+	     it(stale_rates.begin()); it != stale_rates.end(); ++it)
+	{
+	  // get the net rate of the reaction (sign gives direction)
+	  net_rates[*it] = get_net_rate(rxn_order[*it]);
+	  // the tree only holds the magnitude
+	  rates.set(*it, CH_STD::fabs(net_rates[*it]));
+	  stale[*it] = false;
+	}
+    }
+  else
+    {
+      // get the rates for each reaction in the mechanism
+      for (unsigned int i(0U); i < rxn_order.size(); ++i)
+	{
+	  net_rates[i] = get_net_rate(rxn_order[i]);
+	  rates.assign(i, CH_STD::fabs(net_rates[i]));
+	  stale[i] = false;
+	}
+      // update the sums in the tree
+      rates.refresh();
+      // save the conditions the rates were calculated at
+      rate_temperature = state_info->get_reactor()->get_temperature();
+      rates_current = true;
+    }
+  stale_rates.clear();
+  // remember the fluid quantities the rates now reflect
+  quantity::type fluid_type(state_info->get_reactor()->get_fluid_type());
+  for (unsigned int f(0U); f < fluids.size(); ++f)
+    {
+      fluid_amounts[f] = fluids[f]->get_quantity(fluid_type);
+    }
+  return;
+}
+
+// perform kinetic Monte Carlo steps from XI to XF following the rates
+// exactly as they change during a temperature ramp
+/* Choosing the time step from the rates at the start of a step is
+ * only correct if the rates stay constant until the next event.
+ * During a ramp they do not, so the ramp is divided into windows
+ * spanning RAMP_WINDOW degrees.  Every rate constant is monotonic in
+ * temperature, so between events the rate of a reaction can not
+ * exceed the larger of its rates at the two ends of the window.
+ * Candidate events are generated using the sum of these bounds, and
+ * a candidate for a reaction is accepted with a probability equal to
+ * its rate at the time of the candidate divided by its bound.
+ * Rejected candidates are null events that only advance time
+ * (thinning), which makes the accepted events follow the time
+ * dependent rates exactly.  Windows end at XF so each call stops
+ * exactly at the output point.
+ */
+void
+kmc::ramp_steps(double& xi, double xf)
+  throw (bad_pointer, bad_type, bad_value, bad_request, bad_input)
+{
+  reactor* rctr(state_info->get_reactor());
+  // the rate tree holds bounds while we are here
+  rates_current = false;
+  double window_end(xi);
+  while (xi < xf)
+    {
+      // start a new window if the last one is used up
+      if (!(xi < window_end))
+	{
+	  window_end = xi
+	    + CH_STD::fabs(ramp_window / rctr->get_heating_rate());
+	  window_T.first = rctr->get_temperature();
+	  window_T.second = window_T.first
+	    + rctr->get_heating_rate() * (window_end - xi);
+	  rates_current = false;
+	}
+      // bring the bounds up to date with the last event
+      update_bounds();
+      double total_bound(rates.total());
+      // see if a candidate event comes before the window (or output) ends
+      double limit((window_end < xf) ? window_end : xf);
+      double dx(limit - xi);
+      bool candidate(false);
+      if (total_bound > 0.0e0)
+	{
+	  double wait(random->get_random_exponential() / total_bound);
+	  if (xi + wait < limit)
+	    {
+	      dx = wait;
+	      candidate = true;
+	    }
+	}
+      // have the reactor update everything (including temperature)
+      rctr->kmc_step(mech->species_seq_begin(), mech->species_seq_end(), dx);
+      xi = (candidate) ? xi + dx : limit;
+      if (candidate)
+	{
+	  // the reaction the candidate belongs to
+	  unsigned int i(rates.find(random->get_random_open(total_bound)));
+	  // its rate at the current temperature
+	  double net_rate(get_net_rate(rxn_order[i]));
+	  // accept it in proportion to how close the rate is to its bound
+	  if (random->get_random_open(rates.get(i)) < CH_STD::fabs(net_rate))
+	    {
+	      rxn_ensemble_map_iter rxn_for_rev_it(rxn_order[i]);
+	      // debugging information
+	      if (debug::get().get_level() > 1U)
+		{
+		  // output the reaction performed and time
+		  debug::get().get_stream() << "kmc step " << steps + 1
+		    << ":x = " << xi << ":reaction "
+		    << rxn_for_rev_it->first->stringify() << CH_STD::endl;
+		}
+	      // increment the counter, if necessary
+	      if (!rxn_count.empty())
+		{
+		  if (net_rate < 0.0e0)
+		    {
+		      ++(rxn_count[rxn_for_rev_it->first].second);
+		    }
+		  else
+		    {
+		      ++(rxn_count[rxn_for_rev_it->first].first);
+		    }
+		}
+	      // perform the reaction
+	      perform_reaction(rxn_for_rev_it, net_rate);
+	      // only the bounds sharing its species have changed
+	      mark_dependents(i);
+	      // increment the kmc step counter
+	      ++steps;
+	      if (debug::get().get_level() > 2U)
+		{
+		  // output surface and quantity information
+		  output(xi, debug::get().get_stream());
+		}
+	    }
+	}
+      // see if the reactor changed any fluid quantities
+      check_fluids();
+    }
+  // the rate tree no longer holds rates
+  rates_current = false;
+  return;
+}
+
+// recalculate the stale rate bounds and update the rate tree
+void
+kmc::update_bounds()
+  throw (bad_pointer, bad_type, bad_request, bad_value)
+{
+  if (rates_current)
+    {
+      // only recalculate what may have changed
+      for (CH_STD::vector<unsigned int>::const_iterator
+	     it(stale_rates.begin()); it != stale_rates.end(); ++it)
+	{
+	  rates.set(*it, get_rate_bound(rxn_order[*it]));
+	  stale[*it] = false;
+	}
+    }
+  else
+    {
+      // get the bounds for each reaction in the mechanism
+      for (unsigned int i(0U); i < rxn_order.size(); ++i)
+	{
+	  rates.assign(i, get_rate_bound(rxn_order[i]));
+	  stale[i] = false;
+	}
+      // update the sums in the tree
+      rates.refresh();
+      rates_current = true;
+    }
+  stale_rates.clear();
+  // remember the fluid quantities the bounds now reflect
+  quantity::type fluid_type(state_info->get_reactor()->get_fluid_type());
+  for (unsigned int f(0U); f < fluids.size(); ++f)
+    {
+      fluid_amounts[f] = fluids[f]->get_quantity(fluid_type);
+    }
+  return;
+}
+
+// return a bound on the forward plus reverse rate of a reaction in the
+// current window
+double
+kmc::get_rate_bound(rxn_ensemble_map_citer rxn_ens_it) const
+  throw (bad_pointer, bad_type, bad_request)
+{
+  // rates at either end of the window
+  double f_start(0.0e0);
+  double r_start(0.0e0);
+  get_rates(rxn_ens_it, window_T.first, f_start, r_start);
+  double f_end(0.0e0);
+  double r_end(0.0e0);
+  get_rates(rxn_ens_it, window_T.second, f_end, r_end);
+  // neither direction is faster anywhere in the window than at one of
+  // its ends, so the sum of the faster ends bounds the rate of both
+  // directions together, which is what the null events must cover
+  return CH_STD::max(f_start, f_end) + CH_STD::max(r_start, r_end);
+}
+
+// state shared by the threads of a parallel run
+struct kmc::parallel_cycle
+{
+  kmc* self;			// integrator being run
+  thread_team* team;		// threads performing the run
+  double* xi;			// current value of the independent variable
+  double xf;			// value to stop at
+  double tau;			// length of the current cycle (zero if none)
+  bool last;			// does the current cycle end at xf
+  unsigned int sublattice;	// sublattice active in the current cycle
+  bool done;			// has xf been reached
+};
+
+// perform kinetic Monte Carlo steps from XI to XF in several threads
+/* The surface is divided into square domains, colored like a
+ * checkerboard with four colors (sublattices), each at least four
+ * times as wide as the furthest an ensemble reaches from the
+ * environment owning it.  An event changes species no further than
+ * that from its owner and ensembles no further than twice that, while
+ * recreating those ensembles reads species three times that far away,
+ * so events in two domains of the same sublattice can never touch the
+ * same environment.  Each cycle, one sublattice is chosen at random and
+ * its domains perform events with their own rates and generators for
+ * four times the cycle length (each sublattice is chosen a quarter of
+ * the time), after which the changes they made to neighboring domains
+ * and to the species quantities are merged in domain order.
+ * Since nothing depends on which thread ran which domain, the results
+ * are the same for any number of threads.
+ */
+bool
+kmc::parallel_steps(double& xi, double xf)
+  throw (bad_pointer, bad_type, bad_value, bad_request, bad_input)
+{
+  // set up the domains the first time through
+  if (domains.empty() && !create_domains())
+    {
+      // surface is too small to divide, run serially from now on
+      threads = 1U;
+      return false;
+    }
+  thread_team team(threads);
+  parallel_cycle cycle;
+  cycle.self = this;
+  cycle.team = &team;
+  cycle.xi = &xi;
+  cycle.xf = xf;
+  cycle.tau = 0.0e0;
+  cycle.last = false;
+  cycle.sublattice = 0U;
+  cycle.done = false;
+  team.run(&kmc::parallel_work, &cycle);
+  return true;
+}
+
+// divide the surface into domains, return false if it is too small
+bool
+kmc::create_domains()
+  throw (bad_request, bad_pointer)
+{
+  // the generator of each domain must not share state with the others
+  if (icompare(random->get_name(), "rand") == 0)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":kmc::create_domains(): the rand random number "
+			"generator can not be used with more than one "
+			"thread");
+    }
+  unsigned int size(surface.get_size());
+  if (sites < 1U || environments.size() != sites)
+    {
+      return false;
+    }
+  // how far (in rows or columns) an ensemble reaches from its owner
+  unsigned int reach(1U);
+  if (icompare(env_type, "single") == 0)
+    {
+      reach = 0U;
+    }
+  else if (env_radial && max_sites > 1U)
+    {
+      reach = max_sites - 1U;
+    }
+  // domains along each side, an even number so the colors alternate
+  // across the periodic boundary; very small domains would spend more
+  // time merging than performing events
+  unsigned int width(CH_STD::max(4U * reach, 8U));
+  unsigned int cells(size / width);
+  cells -= cells % 2U;
+  if (cells < 2U)
+    {
+      return false;
+    }
+  // assign the environments (created row by row) to domains
+  env_domain.resize(environments.size());
+  sublattices.assign(4U, CH_STD::vector<unsigned int>());
+  for (unsigned int i(0U); i < cells * cells; ++i)
+    {
+      unsigned int row(i / cells);
+      unsigned int col(i % cells);
+      sublattices[(row % 2U) * 2U + col % 2U].push_back(i);
+    }
+  for (environment::seq_citer it(environments.begin());
+       it != environments.end(); ++it)
+    {
+      unsigned int index((*it)->get_index());
+      unsigned int row((index / size) * cells / size);
+      unsigned int col((index % size) * cells / size);
+      env_domain[index] = row * cells + col;
+    }
+  // find the types of each reaction
+  rxn_types.clear();
+  fluid_rxns.clear();
+  for (unsigned int i(0U); i < rxn_order.size(); ++i)
+    {
+      if (rxn_order[i]->second.first == ensemble::npos)
+	{
+	  fluid_rxns.push_back(i);
+	}
+      rxn_types.push_back(rxn_order[i]->second);
+    }
+  unit_rates.assign(rxn_order.size(), CH_STD::make_pair(0.0e0, 0.0e0));
+  // create the domains, each with a stream of numbers of its own
+  for (unsigned int i(0U); i < cells * cells; ++i)
+    {
+      rng* domain_rng(random->new_stream(i));
+      if (domain_rng == 0)
+	{
+	  throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			    ":kmc::create_domains(): unable to create a "
+			    "random number generator of type "
+			    + random->get_name());
+	}
+      domains.push_back(new domain(domain_rng, ensemble_types.size(),
+				   rxn_order.size()));
+    }
+  // move the ensembles into the buckets of the domains owning them
+  for (unsigned int t(0U); t < ensemble_types.size(); ++t)
+    {
+      ensemble_bucket& bucket(buckets[t]);
+      for (unsigned int j(0U); j < bucket.size(); ++j)
+	{
+	  domains[env_domain[bucket[j].second->get_index()]]
+	    ->get_bucket(t).insert(bucket[j].first, bucket[j].second);
+	}
+      // the domains hold them from now on
+      bucket = ensemble_bucket();
+    }
+  rates_current = false;
+  return true;
+}
+
+// what each thread of a parallel run does, DATA is a parallel_cycle
+void
+kmc::parallel_work(void* data, unsigned int rank)
+{
+  parallel_cycle* cycle(static_cast<parallel_cycle*>(data));
+  thread_team* team(cycle->team);
+  // every member goes through the stages of each cycle together
+  for (unsigned int stage(0U); ; stage = (stage + 1U) % 4U)
+    {
+      // a member leaving early would leave the others at the barrier
+      try
+	{
+	  cycle->self->parallel_stage(*cycle, stage, rank, team->get_size());
+	}
+      catch (CH_STD::exception& e)
+	{
+	  team->fail(e.what());
+	}
+      catch (...)
+	{
+	  team->fail("kmc::parallel_work(): unknown exception");
+	}
+      // done is only set in stage zero, and can not change again until
+      // every member is past the next barrier
+      if (!team->barrier() || (stage == 0U && cycle->done))
+	{
+	  break;		// for (stage)
+	}
+    }
+  return;
+}
+
+// perform stage STAGE of a cycle as member RANK of a team of SIZE
+void
+kmc::parallel_stage(parallel_cycle& cycle, unsigned int stage,
+		    unsigned int rank, unsigned int size)
+  throw (bad_pointer, bad_type, bad_value, bad_request, bad_input)
+{
+  switch (stage)
+    {
+    case 0U:			// serial: finish last cycle, start next
+      if (rank == 0U)
+	{
+	  merge_domains(cycle);
+	  if (!(*cycle.xi < cycle.xf))
+	    {
+	      cycle.done = true;
+	    }
+	  else if (update_unit_rates())
+	    {
+	      // every rate in every domain has changed
+	      for (domain::seq_iter it(domains.begin()); it != domains.end();
+		   ++it)
+		{
+		  (*it)->set_stale(true);
+		}
+	    }
+	}
+      break;
+
+    case 1U:			// parallel: recalculate changed domains
+      for (unsigned int d(rank); d < domains.size(); d += size)
+	{
+	  if (domains[d]->is_stale())
+	    {
+	      refresh_domain(d);
+	    }
+	}
+      break;
+
+    case 2U:			// serial: choose length and sublattice
+      if (rank == 0U)
+	{
+	  select_sublattice(cycle);
+	}
+      break;
+
+    case 3U:			// parallel: perform events in the sublattice
+      {
+	const CH_STD::vector<unsigned int>&
+	  active(sublattices[cycle.sublattice]);
+	// each sublattice is active a fraction of the time, so those that
+	// are make up for the others
+	for (unsigned int k(rank); k < active.size(); k += size)
+	  {
+	    domain_steps(active[k], cycle.tau * sublattices.size());
+	  }
+      }
+      break;
+
+    default:
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":kmc::parallel_stage(): unknown stage of a cycle: "
+			+ t_string(stage));
+      break;
+    }
+  return;
+}
+
+// recalculate the rates for a single ensemble, return whether any changed
+bool
+kmc::update_unit_rates()
+  throw (bad_pointer, bad_type, bad_request)
+{
+  double T(state_info->get_reactor()->get_temperature());
+  bool changed_rates(false);
+  for (unsigned int i(0U); i < rxn_order.size(); ++i)
+    {
+      // reactions off the surface are not in the domains
+      if (rxn_types[i].first == ensemble::npos)
+	{
+	  continue;		// for (i)
+	}
+      CH_STD::pair<double,double> unit(0.0e0, 0.0e0);
+      get_rates(rxn_order[i], T, unit.first, unit.second, true);
+      if (unit != unit_rates[i])
+	{
+	  unit_rates[i] = unit;
+	  changed_rates = true;
+	}
+    }
+  return changed_rates;
+}
+
+// recalculate all the rates of domain D
+void
+kmc::refresh_domain(unsigned int d)
+  throw (bad_value)
+{
+  for (unsigned int i(0U); i < rxn_order.size(); ++i)
+    {
+      domains[d]->set_net_rate(i, get_domain_rate(d, i), true);
+    }
+  domains[d]->refresh();
+  domains[d]->set_stale(false);
+  return;
+}
+
+// return the net rate of the reaction at leaf I in domain D
+double
+kmc::get_domain_rate(unsigned int d, unsigned int i) const
+{
+  const domain& dom(*domains[d]);
+  return unit_rates[i].first * dom.size(rxn_types[i].first)
+    - unit_rates[i].second * dom.size(rxn_types[i].second);
+}
+
+// choose the length of the next cycle and the sublattice active in it
+void
+kmc::select_sublattice(parallel_cycle& cycle)
+  throw (bad_pointer, bad_type, bad_request)
+{
+  // the total transition probability of the surface and the fluids
+  double total_rate(0.0e0);
+  for (domain::seq_citer it(domains.begin()); it != domains.end(); ++it)
+    {
+      total_rate += (*it)->total();
+    }
+  for (CH_STD::vector<unsigned int>::const_iterator it(fluid_rxns.begin());
+       it != fluid_rxns.end(); ++it)
+    {
+      total_rate += CH_STD::fabs(get_net_rate(rxn_order[*it]));
+    }
+  // make sure a reaction is possible
+  if (total_rate < precision::get().get_double())
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":kmc::select_sublattice(): sum total of all absolute "
+			"rates is equivalent to zero: "
+			+ t_string(total_rate));
+    }
+  // long enough for the requested number of events in a typical domain
+  // (which runs for a time of sublattices times the cycle length)
+  cycle.tau = sublattice_events * domains.size()
+    / (sublattices.size() * total_rate);
+  cycle.last = !(*cycle.xi + cycle.tau < cycle.xf);
+  if (cycle.last)
+    {
+      cycle.tau = cycle.xf - *cycle.xi;
+    }
+  cycle.sublattice = random->get_random(sublattices.size());
+  return;
+}
+
+// perform events in domain D for TAU
+void
+kmc::domain_steps(unsigned int d, double tau)
+  throw (bad_pointer, bad_value, bad_request, bad_input)
+{
+  domain& dom(*domains[d]);
+  double t(0.0e0);
+  while (dom.total() > 0.0e0)
+    {
+      // stop if the next event would be after the end of the cycle
+      t += dom.get_rng().get_random_exponential() / dom.total();
+      if (t > tau)
+	{
+	  break;		// while
+	}
+      domain::event ev(dom.select());
+      domain_event(d, ev);
+      // the species quantities are changed when the domains are merged
+      dom.get_events().push_back(ev);
+    }
+  return;
+}
+
+// perform event EV in domain D
+void
+kmc::domain_event(unsigned int d, const domain::event& ev)
+  throw (bad_pointer, bad_value, bad_request, bad_input)
+{
+  domain& dom(*domains[d]);
+  model_reaction* rxn(rxn_order[ev.first]->first);
+  // the ensembles to choose from and what to put on them
+  unsigned int type(rxn_types[ev.first].first);
+  const model_species::seq* products(rxn->get_product_seq_ptr());
+  if (ev.second < 0.0e0)
+    {
+      type = rxn_types[ev.first].second;
+      products = rxn->get_reactant_seq_ptr();
+    }
+  if (products == 0)
+    {
+      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":kmc::domain_event(): unable to create reactants "
+		      "or products into a sequence for reaction `" +
+		      rxn->stringify() + "', probably due to "
+		      "non-integral stoichiometric coefficient");
+    }
+  if (dom.size(type) < 1U)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":kmc::domain_event(): a reaction was requested which "
+			"has none of its ensembles in the domain");
+    }
+  // randomly select an environment/ensemble from the bucket of them
+  ensemble_bucket& bucket(dom.get_bucket(type));
+  ensemble_bucket::entry
+    ens_env(bucket[dom.get_rng().get_random(bucket.size())]);
+  // perform the reaction on the surface with the domain's generator
+  ensemble::seq& destroyed_ens(dom.get_destroyed());
+  environment::seq& changed_envs(dom.get_changed());
+  destroyed_ens.clear();
+  changed_envs.clear();
+  (ens_env.second)->change_ensemble(ens_env.first, *products, destroyed_ens,
+				    changed_envs, dom.get_rng(),
+				    dom.get_pool());
+  // remove the ensembles replaced, leaving those of other domains for
+  // the merge
+  for (ensemble::seq_citer it(destroyed_ens.begin());
+       it != destroyed_ens.end(); ++it)
+    {
+      if (env_domain[(*it)->get_owner()->get_index()] == d)
+	{
+	  if (!dom.get_bucket((*it)->get_type()).erase(*it))
+	    {
+	      throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
+				+ ":kmc::domain_event(): an ensemble was "
+				"determined to be in the mechanism, but the "
+				"pointer to it was not entered into its "
+				"bucket; something has been corrupted");
+	    }
+	  dom.get_pool().put(*it);
+	}
+      else
+	{
+	  dom.get_foreign_destroyed().push_back(*it);
+	}
+    }
+  // add the new ensembles
+  for (environment::seq_citer env_it(changed_envs.begin());
+       env_it != changed_envs.end(); ++env_it)
+    {
+      if (env_domain[(*env_it)->get_index()] != d)
+	{
+	  dom.get_foreign_changed().push_back(*env_it);
+	  continue;		// for (env_it)
+	}
+      for (ensemble::seq_citer it((*env_it)->ensembles_seq_begin());
+	   it != (*env_it)->ensembles_seq_end(); ++it)
+	{
+	  if ((*it)->get_handle() == ensemble::npos)
+	    {
+	      dom.get_bucket((*it)->get_type()).insert(*it, *env_it);
+	    }
+	}
+    }
+  // only the rates sharing its species have changed
+  for (CH_STD::vector<unsigned int>::const_iterator
+	 it(rxn_depend[ev.first].begin()); it != rxn_depend[ev.first].end();
+       ++it)
+    {
+      dom.set_net_rate(*it, get_domain_rate(d, *it));
+    }
+  return;
+}
+
+// bring the buckets of the domains and the species quantities up to date
+// with the events of the last cycle
+void
+kmc::merge_domains(parallel_cycle& cycle)
+  throw (bad_pointer, bad_type, bad_value, bad_request, bad_input)
+{
+  // nothing to do before the first cycle
+  if (!(cycle.tau > 0.0e0))
+    {
+      return;
+    }
+  reactor* rctr(state_info->get_reactor());
+  for (unsigned int d(0U); d < domains.size(); ++d)
+    {
+      domain& dom(*domains[d]);
+      // remove the ensembles of other domains this one replaced (some
+      // were created and replaced in the same cycle and are in no bucket)
+      ensemble::seq& foreign_destroyed(dom.get_foreign_destroyed());
+      for (ensemble::seq_citer it(foreign_destroyed.begin());
+	   it != foreign_destroyed.end(); ++it)
+	{
+	  domain& owner(*domains[env_domain[(*it)->get_owner()->get_index()]]);
+	  owner.get_bucket((*it)->get_type()).erase(*it);
+	  owner.get_pool().put(*it);
+	  owner.set_stale(true);
+	}
+      foreign_destroyed.clear();
+      // add the ensembles the environments of other domains have now
+      environment::seq& foreign_changed(dom.get_foreign_changed());
+      CH_STD::sort(foreign_changed.begin(), foreign_changed.end(),
+		   environment::index_less());
+      foreign_changed.erase(CH_STD::unique(foreign_changed.begin(),
+					   foreign_changed.end()),
+			    foreign_changed.end());
+      for (environment::seq_citer env_it(foreign_changed.begin());
+	   env_it != foreign_changed.end(); ++env_it)
+	{
+	  domain& owner(*domains[env_domain[(*env_it)->get_index()]]);
+	  for (ensemble::seq_citer it((*env_it)->ensembles_seq_begin());
+	       it != (*env_it)->ensembles_seq_end(); ++it)
+	    {
+	      if ((*it)->get_handle() == ensemble::npos)
+		{
+		  owner.get_bucket((*it)->get_type()).insert(*it, *env_it);
+		}
+	    }
+	  owner.set_stale(true);
+	}
+      foreign_changed.clear();
+      // update coverages and pressures for the events performed
+      domain::event_seq& events(dom.get_events());
+      for (domain::event_seq::const_iterator it(events.begin());
+	   it != events.end(); ++it)
+	{
+	  model_reaction* rxn(rxn_order[it->first]->first);
+	  const model_species::seq* reactants(rxn->get_reactant_seq_ptr());
+	  const model_species::seq* products(rxn->get_product_seq_ptr());
+	  if (it->second < 0.0e0)
+	    {
+	      CH_STD::swap(reactants, products);
+	    }
+	  // debugging information
+	  if (debug::get().get_level() > 1U)
+	    {
+	      // output the reaction performed and time
+	      debug::get().get_stream() << "kmc step " << steps + 1
+		<< ":x = " << *cycle.xi + cycle.tau << ":domain " << d
+		<< ":reaction " << rxn->stringify() << CH_STD::endl;
+	    }
+	  // increment the counter, if necessary
+	  if (!rxn_count.empty())
+	    {
+	      if (it->second < 0.0e0)
+		{
+		  ++(rxn_count[rxn].second);
+		}
+	      else
+		{
+		  ++(rxn_count[rxn].first);
+		}
+	    }
+	  rctr->kmc_reaction(*reactants, *products, scale);
+	  ++steps;
+	}
+      events.clear();
+    }
+  // the reactions off the surface proceed on their own
+  fluid_steps(cycle.tau);
+  // have the reactor update everything
+  rctr->kmc_step(mech->species_seq_begin(), mech->species_seq_end(),
+		 cycle.tau);
+  // land exactly on the output point
+  *cycle.xi = (cycle.last) ? cycle.xf : *cycle.xi + cycle.tau;
+  cycle.tau = 0.0e0;
+  if (debug::get().get_level() > 2U)
+    {
+      // output surface and quantity information
+      output(*cycle.xi, debug::get().get_stream());
+    }
+  return;
+}
+
+// perform the reactions not involving the surface for TAU
+void
+kmc::fluid_steps(double tau)
+  throw (bad_pointer, bad_type, bad_value, bad_request, bad_input)
+{
+  if (fluid_rxns.empty())
+    {
+      return;
+    }
+  CH_STD::vector<double> fluid_rates(fluid_rxns.size(), 0.0e0);
+  double t(0.0e0);
+  while (true)
+    {
+      // the rates change with every reaction
+      double total_rate(0.0e0);
+      for (unsigned int j(0U); j < fluid_rxns.size(); ++j)
+	{
+	  fluid_rates[j] = get_net_rate(rxn_order[fluid_rxns[j]]);
+	  total_rate += CH_STD::fabs(fluid_rates[j]);
+	}
+      if (!(total_rate > 0.0e0))
+	{
+	  break;		// while
+	}
+      t += random->get_random_exponential() / total_rate;
+      if (t > tau)
+	{
+	  break;		// while
+	}
+      // find the reaction in the cumulative rates
+      double r(random->get_random_open(total_rate));
+      unsigned int j(0U);
+      while (j + 1U < fluid_rxns.size() && !(r < CH_STD::fabs(fluid_rates[j])))
+	{
+	  r -= CH_STD::fabs(fluid_rates[j]);
+	  ++j;
+	}
+      rxn_ensemble_map_iter rxn_for_rev_it(rxn_order[fluid_rxns[j]]);
+      // increment the counter, if necessary
+      if (!rxn_count.empty())
+	{
+	  if (fluid_rates[j] < 0.0e0)
+	    {
+	      ++(rxn_count[rxn_for_rev_it->first].second);
+	    }
+	  else
+	    {
+	      ++(rxn_count[rxn_for_rev_it->first].first);
+	    }
+	}
+      perform_reaction(rxn_for_rev_it, fluid_rates[j]);
+      ++steps;
+    }
+  return;
+}
+
+// state shared by the threads stepping replicas
+struct kmc::replica_cycle
+{
+  kmc* self;			// integrator owning the replicas
+  thread_team* team;		// threads stepping them
+  double xf;			// value to step to
+};
+
+// create and initialize the replicas
+/* Each replica is a copy of this integrator made before anything was
+ * initialized, using its own copy of the mechanism (so it has species
+ * quantities of its own) and a generator seeded from ours.  They must
+ * be initialized one after the other, since the environments are set
+ * up through static variables, but from then on each only uses its
+ * own generator, pool and mechanism, so they can be stepped at the
+ * same time.
+ */
+void
+kmc::create_replicas()
+  throw (bad_pointer, bad_input, bad_value, bad_type, bad_request,
+	 bad_file)
+{
+  // make sure there is something to copy
+  if (mech == 0)
+    {
+      throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":kmc::create_replicas(): asking to create replicas "
+			"but the model mechanism pointer has not been set");
+    }
+  // the generator of each replica must not share state with the others
+  if (icompare(random->get_name(), "rand") == 0)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":kmc::create_replicas(): the rand random number "
+			"generator can not be used with replicas");
+    }
+  for (unsigned int i(0U); i < replicas; ++i)
+    {
+      replica_mechs.push_back(mech->copy());
+      kmc* run(new kmc(*this));
+      replica_runs.push_back(run);
+      // the replicas simulate a single surface and output nothing
+      run->replicas = 1U;
+      run->threads = 1U;
+      run->surface_filename.clear();
+      run->count_filename.clear();
+      // each replica has a stream of numbers of its own
+      delete run->random;
+      run->random = random->new_stream(i);
+      if (run->random == 0)
+	{
+	  throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			    ":kmc::create_replicas(): unable to create a "
+			    "random number generator of type "
+			    + random->get_name());
+	}
+      run->mech = replica_mechs.back();
+      run->initialize();
+      // the replicas count reactions for us
+      if (count_filename.size() > 0U)
+	{
+	  for (model_reaction::seq_citer it(run->mech->reaction_seq_begin());
+	       it != run->mech->reaction_seq_end(); ++it)
+	    {
+	      run->rxn_count.insert(CH_STD::make_pair(*it, counter_pair()));
+	    }
+	}
+    }
+  replica_x.assign(replicas, x0);
+  // the surface of the first replica is the one output
+  if (sites > 0U && surface_filename.size() > 0U)
+    {
+      open_surface();
+    }
+  // the counts are averaged over the replicas
+  initialize_rxn_counter();
+  return;
+}
+
+// step every replica from where it is to XF in several threads
+void
+kmc::replica_steps(double xf)
+  throw (bad_request)
+{
+  // use a thread for each processor unless told otherwise
+  unsigned int size((threads > 1U) ? threads
+		    : thread_team::get_processors());
+  thread_team team(CH_STD::min(size, replicas));
+  replica_cycle cycle;
+  cycle.self = this;
+  cycle.team = &team;
+  cycle.xf = xf;
+  team.run(&kmc::replica_work, &cycle);
+  return;
+}
+
+// what each thread stepping replicas does, DATA is a replica_cycle
+void
+kmc::replica_work(void* data, unsigned int rank)
+{
+  replica_cycle* cycle(static_cast<replica_cycle*>(data));
+  kmc* self(cycle->self);
+  // the replicas are dealt out to the members in turn
+  for (unsigned int i(rank); i < self->replica_runs.size();
+       i += cycle->team->get_size())
+    {
+      // no point in going on if another member failed
+      if (cycle->team->has_failed())
+	{
+	  break;		// for (i)
+	}
+      self->replica_x[i] = self->replica_runs[i]->step(self->replica_x[i],
+							cycle->xf);
+    }
+  return;
+}
+
+// output the mean over the replicas of the current values, followed by
+// their standard errors
+void
+kmc::replica_output(double x, CH_STD::ostream& output_stream)
+  throw (bad_type, bad_request, bad_value, bad_file)
+{
+  unsigned int n(replica_runs.size());
+  CH_STD::vector<double> values(n);
+  // format the row here, so only the writer waits for the disk
+  CH_STD::ostringstream row;
+  row.copyfmt(output_stream);
+  // output the current output point
+  row << x;
+  // get the interesting amount type
+  quantity::type type(model_reaction::get_amount_type());
+  // the species are in the same order in every copy of the mechanism
+  CH_STD::vector<double> errors;
+  for (unsigned int j(0U);
+       mech->species_seq_begin() + j != mech->species_seq_end(); ++j)
+    {
+      for (unsigned int i(0U); i < n; ++i)
+	{
+	  values[i] = (*(replica_runs[i]->mech->species_seq_begin() + j))
+	    ->get_quantity(type);
+	}
+      CH_STD::pair<double,double> me(mean_error(values));
+      row << '\t' << me.first;
+      errors.push_back(me.second);
+    }
+  // see if we should output the flow
+  if (dynamic_cast<flow_reactor*>(state_info->get_reactor()) != 0)
+    {
+      for (unsigned int i(0U); i < n; ++i)
+	{
+	  values[i] = dynamic_cast<flow_reactor*>(replica_runs[i]->state_info
+						  ->get_reactor())->get_flow();
+	}
+      row << '\t' << mean_error(values).first;
+    }
+  // see if we should output the temperature
+  if (CH_STD::fabs(state_info->get_reactor()->get_heating_rate())
+      > precision::get().get_double())
+    {
+      for (unsigned int i(0U); i < n; ++i)
+	{
+	  values[i] = replica_runs[i]->state_info->get_reactor()
+	    ->get_temperature();
+	}
+      row << '\t' << mean_error(values).first;
+    }
+  // output the mean number of kmc steps
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      values[i] = replica_runs[i]->steps;
+    }
+  double mean_steps(mean_error(values).first);
+  row << '\t' << mean_steps;
+  // output the standard errors of the species
+  for (CH_STD::vector<double>::const_iterator it(errors.begin());
+       it != errors.end(); ++it)
+    {
+      row << '\t' << *it;
+    }
+  row << '\n';
+  emit(output_stream, row.str());
+  // output surface, if desired, with the steps taken to reach it
+  output_surface(x, replica_runs.front()->steps,
+		 replica_runs.front()->surface);
+  // see if we need to output the reaction counter information
+  if (count_out.is_open())
+    {
+      // the reactions are in the same order in every copy of the mechanism
+      CH_STD::map<model_reaction*,unsigned int> rxn_index;
+      for (model_reaction::seq_citer it(mech->reaction_seq_begin());
+	   it != mech->reaction_seq_end(); ++it)
+	{
+	  rxn_index.insert(CH_STD::make_pair(*it, rxn_index.size()));
+	}
+      CH_STD::vector<double> reverse(n);
+      CH_STD::ostringstream line;
+      line.copyfmt(count_out);
+      // output where we are in the simulation
+      line << x << '\t' << mean_steps;
+      // output the mean counts, saving the errors for the end
+      CH_STD::vector<CH_STD::pair<double,double> > count_errors;
+      for (rxn_counter_map_citer rc_it(rxn_count.begin());
+	   rc_it != rxn_count.end(); ++rc_it)
+	{
+	  unsigned int j(rxn_index[rc_it->first]);
+	  for (unsigned int i(0U); i < n; ++i)
+	    {
+	      kmc* run(replica_runs[i]);
+	      rxn_counter_map_citer
+		count_it(run->rxn_count.find(*(run->mech->reaction_seq_begin()
+					       + j)));
+	      // reactions never performed have no counts
+	      values[i] = (count_it == run->rxn_count.end()) ? 0.0e0
+		: count_it->second.first.get_count();
+	      reverse[i] = (count_it == run->rxn_count.end()) ? 0.0e0
+		: count_it->second.second.get_count();
+	    }
+	  CH_STD::pair<double,double> me_for(mean_error(values));
+	  CH_STD::pair<double,double> me_rev(mean_error(reverse));
+	  line << '\t' << me_for.first << '/' << me_rev.first;
+	  count_errors.push_back(CH_STD::make_pair(me_for.second,
+						   me_rev.second));
+	}
+      for (CH_STD::vector<CH_STD::pair<double,double> >::const_iterator
+	     it(count_errors.begin()); it != count_errors.end(); ++it)
+	{
+	  line << '\t' << it->first << '/' << it->second;
+	}
+      line << '\n';
+      emit(count_out, line.str());
+    }
+  return;
+}
+
+// return the mean of VALUES and its standard error
+CH_STD::pair<double,double>
+kmc::mean_error(const CH_STD::vector<double>& values)
+{
+  double n(values.size());
+  double mean(0.0e0);
+  for (CH_STD::vector<double>::const_iterator it(values.begin());
+       it != values.end(); ++it)
+    {
+      mean += *it;
+    }
+  mean /= n;
+  // need at least two values to estimate the spread
+  if (values.size() < 2U)
+    {
+      return CH_STD::make_pair(mean, 0.0e0);
+    }
+  double sum_squares(0.0e0);
+  for (CH_STD::vector<double>::const_iterator it(values.begin());
+       it != values.end(); ++it)
+    {
+      sum_squares += (*it - mean) * (*it - mean);
+    }
+  return CH_STD::make_pair(mean, CH_STD::sqrt(sum_squares
+					      / ((n - 1.0e0) * n)));
+}
+
+// write TEXT to STREAM, through the writer if it is one of our files
+void
+kmc::emit(CH_STD::ostream& stream, const CH_STD::string& text)
+  throw (bad_file)
+{
+  if (&stream == out_file || &stream == &surface_out || &stream == &count_out)
+    {
+      writer.put(stream, text);
+    }
+  else
+    {
+      // other streams (debugging) are written in order with everything
+      // else that goes to them
+      stream << text << CH_STD::flush;
+    }
+  return;
+}
+
+// open the surface output file in the requested format
+void
+kmc::open_surface()
+  throw (bad_file, bad_value)
+{
+  if (icompare(surface_format, "binary") == 0)
+    {
+      // the snapshots may hold any surface species of the run whose
+      // surface is output, which has a mechanism of its own if it is
+      // a replica
+      const kmc* shown(replica_runs.empty() ? this : replica_runs.front());
+      delete surface_snapshots;
+      surface_snapshots = 0;
+      surface_snapshots = new snapshot_ofstream(surface_filename,
+						shown->get_surface_species(),
+						surface.get_size());
+    }
+  else
+    {
+      // open the surface file, destroying contents
+      // NOTE: could use safe_ofstream here
+      surface_out.open(surface_filename.c_str());
+    }
+  return;
+}
+
+// output SURFACE at X, after STEPS_ kmc steps, to the surface file,
+// if there is one
+void
+kmc::output_surface(double x, unsigned int steps_, const lattice& surface_)
+  throw (bad_file, bad_request, bad_value)
+{
+  if (surface_snapshots != 0)
+    {
+      // the frame is encoded here and written by the writer
+      CH_STD::string frame;
+      surface_snapshots->encode_frame(x, steps_, surface_, frame);
+      writer.put(*surface_snapshots, &snapshot_ofstream::put_encoded, frame);
+    }
+  else if (surface_out.is_open())
+    {
+      CH_STD::ostringstream picture;
+      picture << "x = " << x << '\n' << surface_.stringify() << '\n';
+      emit(surface_out, picture.str());
+    }
+  return;
+}
+
+// write a checkpoint at X if one is due
+void
+kmc::checkpoint(double x, bool boundary)
+  throw (bad_file, bad_request)
+{
+  // see if checkpoints were asked for
+  if (checkpoint_filename.size() < 1U)
+    {
+      return;
+    }
+  bool due(false);
+  if (checkpoint_steps > 0U)
+    {
+      due = (steps - checkpoint_step >= checkpoint_steps);
+    }
+  // only look at the clock if asked to
+  if (!due && checkpoint_seconds > 0.0e0)
+    {
+      due = (CH_STD::difftime(CH_STD::time(0), checkpoint_time)
+	     >= checkpoint_seconds);
+    }
+  // without an interval, write one at every output point
+  if (!due && boundary && checkpoint_steps < 1U
+      && checkpoint_seconds <= 0.0e0)
+    {
+      due = true;
+    }
+  if (due)
+    {
+      write_checkpoint(x);
+      checkpoint_step = steps;
+      checkpoint_time = CH_STD::time(0);
+    }
+  return;
+}
+
+// write everything needed to continue the run from X to the checkpoint
+// file
+/* The surface is saved as the species on each site rather than as the
+ * events leading to it, and the buckets as the position of each entry
+ * in the ensembles of its environment, since the order of the entries
+ * decides which ensemble a random number selects.  Ensemble types and
+ * species are identified by their position in the mechanism, not by
+ * address.  The file is written under a temporary name and renamed
+ * when complete, so a run killed while writing leaves the previous
+ * checkpoint intact.
+ */
+void
+kmc::write_checkpoint(double x) const
+  throw (bad_file, bad_request)
+{
+  // number the species in the order of the mechanism
+  CH_STD::map<model_species*,unsigned int> species_index;
+  for (model_species::seq_citer it(mech->species_seq_begin());
+       it != mech->species_seq_end(); ++it)
+    {
+      species_index.insert(CH_STD::make_pair(*it, species_index.size()));
+    }
+  CH_STD::string temporary(checkpoint_filename + ".tmp");
+  binary_ofstream out(temporary);
+  out.put_header(checkpoint_magic, checkpoint_version);
+  // where the run is
+  out.put_double(x);
+  out.put_unsigned(steps);
+  // what it is running
+  out.put_unsigned(species_index.size());
+  for (model_species::seq_citer it(mech->species_seq_begin());
+       it != mech->species_seq_end(); ++it)
+    {
+      out.put_string((*it)->get_name());
+    }
+  out.put_unsigned(mech->reaction_seq_end() - mech->reaction_seq_begin());
+  out.put_unsigned(surface.get_size());
+  // the species on each site
+  for (environment::seq_citer env_it(environments.begin());
+       env_it != environments.end(); ++env_it)
+    {
+      CH_STD::pair<model_species*,environment::seq>
+	occupant((*env_it)->get_species());
+      out.put_unsigned(species_index[occupant.first]);
+      out.put_unsigned(occupant.second.size());
+      for (environment::seq_citer it(occupant.second.begin());
+	   it != occupant.second.end(); ++it)
+	{
+	  out.put_unsigned((*it)->get_index());
+	}
+    }
+  // the order of the entries in each bucket which has any
+  unsigned int filled(0U);
+  for (unsigned int t(0U); t < buckets.size(); ++t)
+    {
+      if (!buckets[t].empty())
+	{
+	  ++filled;
+	}
+    }
+  out.put_unsigned(filled);
+  for (unsigned int t(0U); t < buckets.size(); ++t)
+    {
+      const ensemble_bucket& bucket(buckets[t]);
+      if (bucket.empty())
+	{
+	  continue;		// for (t)
+	}
+      // the type of ensemble
+      out.put_unsigned(ensemble_types[t]->get_size());
+      for (model_species::seq_citer it(ensemble_types[t]->begin());
+	   it != ensemble_types[t]->end(); ++it)
+	{
+	  out.put_unsigned(species_index[*it]);
+	}
+      // where each entry is among the ensembles of its environment
+      out.put_unsigned(bucket.size());
+      for (unsigned int i(0U); i < bucket.size(); ++i)
+	{
+	  const environment* env(bucket[i].second);
+	  ensemble::seq_citer ens_it(CH_STD::find(env->ensembles_seq_begin(),
+						  env->ensembles_seq_end(),
+						  bucket[i].first));
+	  if (ens_it == env->ensembles_seq_end())
+	    {
+	      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
+				+ ":kmc::write_checkpoint(): ensemble in "
+				"bucket is not among the ensembles of its "
+				"environment");
+	    }
+	  out.put_unsigned(env->get_index());
+	  out.put_unsigned(ens_it - env->ensembles_seq_begin());
+	}
+    }
+  // the quantities, reactor, and random number generator
+  for (model_species::seq_citer it(mech->species_seq_begin());
+       it != mech->species_seq_end(); ++it)
+    {
+      (*it)->save_quantity(out);
+    }
+  state_info->get_reactor()->save_state(out);
+  out.put_string(random->get_name());
+  random->save_state(out);
+  // the reaction counts (if they are being kept)
+  out.put_unsigned(rxn_count.empty() ? 0U : 1U);
+  if (!rxn_count.empty())
+    {
+      for (model_reaction::seq_citer it(mech->reaction_seq_begin());
+	   it != mech->reaction_seq_end(); ++it)
+	{
+	  rxn_counter_map_citer rc_it(rxn_count.find(*it));
+	  out.put_int(rc_it->second.first.get_count());
+	  out.put_int(rc_it->second.second.get_count());
+	}
+    }
+  out.finish();
+  // replace the previous checkpoint
+  if (CH_STD::rename(temporary.c_str(), checkpoint_filename.c_str()) != 0)
+    {
+      throw bad_file(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		     ":kmc::write_checkpoint(): could not rename " + temporary
+		     + " to " + checkpoint_filename + ": "
+		     + CH_STD::strerror(errno));
+    }
+  // debugging information
+  if (debug::get().get_level() > 1U)
+    {
+      debug::get().get_stream() << "kmc checkpoint:x = " << x << ":steps = "
+				<< steps << ":file " << checkpoint_filename
+				<< CH_STD::endl;
+    }
+  return;
+}
+
+// rebuild the surface from the restart file and restore the state saved
+// with it
+void
+kmc::restart(model_species* empty_site)
+  throw (bad_file, bad_input, bad_request, bad_value, bad_pointer, bad_type)
+{
+  binary_ifstream in(restart_filename);
+  unsigned int version(in.get_header(checkpoint_magic));
+  if (version != checkpoint_version)
+    {
+      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":kmc::restart(): checkpoint " + restart_filename +
+		      " has format version " + t_string(version) +
+		      ", can only read version "
+		      + t_string(checkpoint_version));
+    }
+  double x(in.get_double());
+  unsigned int saved_steps(in.get_unsigned());
+  // make sure it was written by a run of the same model
+  model_species::seq speciess(mech->species_seq_begin(),
+			      mech->species_seq_end());
+  if (in.get_unsigned() != speciess.size())
+    {
+      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":kmc::restart(): checkpoint " + restart_filename +
+		      " has a different number of species than the model");
+    }
+  for (model_species::seq_citer it(speciess.begin()); it != speciess.end();
+       ++it)
+    {
+      CH_STD::string name(in.get_string());
+      if (name != (*it)->get_name())
+	{
+	  throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			  ":kmc::restart(): checkpoint " + restart_filename +
+			  " has species " + name + " where the model has "
+			  + (*it)->get_name());
+	}
+    }
+  model_reaction::seq reactions(mech->reaction_seq_begin(),
+				mech->reaction_seq_end());
+  if (in.get_unsigned() != reactions.size())
+    {
+      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":kmc::restart(): checkpoint " + restart_filename +
+		      " has a different number of reactions than the model");
+    }
+  if (in.get_unsigned() != surface.get_size())
+    {
+      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":kmc::restart(): checkpoint " + restart_filename +
+		      " has a different lattice size than the model");
+    }
+  // the species on each site
+  occupant_seq occupants(sites);
+  for (occupant_seq::iterator it(occupants.begin()); it != occupants.end();
+       ++it)
+    {
+      unsigned int sp(in.get_unsigned());
+      if (sp >= speciess.size())
+	{
+	  throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			  ":kmc::restart(): checkpoint " + restart_filename +
+			  " has a site with an unknown species");
+	}
+      it->first = speciess[sp];
+      it->second.resize(in.get_unsigned());
+      for (CH_STD::vector<unsigned int>::iterator covered(it->second.begin());
+	   covered != it->second.end(); ++covered)
+	{
+	  *covered = in.get_unsigned();
+	}
+    }
+  // build the environments and ensembles on that surface
+  create_environments(empty_site, &occupants);
+  initialize_environments();
+  get_ensembles();
+  // put the entries of the buckets back in the order they were in
+  unsigned int filled(in.get_unsigned());
+  for (unsigned int b(0U); b < filled; ++b)
+    {
+      model_species::seq type(in.get_unsigned());
+      for (model_species::seq_iter it(type.begin()); it != type.end(); ++it)
+	{
+	  unsigned int sp(in.get_unsigned());
+	  if (sp >= speciess.size())
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":kmc::restart(): checkpoint " + restart_filename
+			      + " has an ensemble with an unknown species");
+	    }
+	  *it = speciess[sp];
+	}
+      ensemble_id_map_citer id_it(ensemble_ids.find(ensemble(type)));
+      unsigned int entries(in.get_unsigned());
+      if (id_it == ensemble_ids.end()
+	  || buckets[id_it->second].size() != entries)
+	{
+	  throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			  ":kmc::restart(): ensembles in checkpoint "
+			  + restart_filename + " do not match its surface");
+	}
+      ensemble_bucket bucket;
+      for (unsigned int i(0U); i < entries; ++i)
+	{
+	  unsigned int e(in.get_unsigned());
+	  unsigned int position(in.get_unsigned());
+	  if (e >= environments.size()
+	      || position
+	      >= (unsigned int) (environments[e]->ensembles_seq_end()
+				 - environments[e]->ensembles_seq_begin()))
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":kmc::restart(): ensembles in checkpoint "
+			      + restart_filename + " do not match its "
+			      "surface");
+	    }
+	  bucket.insert(*(environments[e]->ensembles_seq_begin() + position),
+			environments[e]);
+	}
+      buckets[id_it->second] = bucket;
+    }
+  // every other bucket must be empty
+  unsigned int found(0U);
+  for (unsigned int t(0U); t < buckets.size(); ++t)
+    {
+      if (!buckets[t].empty())
+	{
+	  ++found;
+	}
+    }
+  if (found != filled)
+    {
+      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":kmc::restart(): ensembles in checkpoint "
+		      + restart_filename + " do not match its surface");
+    }
+  // these depend only on the model and the shape of the surface
+  calc_rate_scale();
+  index_reactions();
+  create_dependencies();
+  // the quantities, reactor, and random number generator
+  for (model_species::seq_citer it(speciess.begin()); it != speciess.end();
+       ++it)
+    {
+      (*it)->restore_quantity(in);
+    }
+  state_info->get_reactor()->restore_state(in);
+  CH_STD::string rng_name(in.get_string());
+  if (rng_name != random->get_name())
+    {
+      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":kmc::restart(): checkpoint " + restart_filename +
+		      " was written using random number generator "
+		      + rng_name + ", not " + random->get_name());
+    }
+  random->restore_state(in);
+  // the reaction counts, if both runs keep them
+  if (in.get_unsigned() > 0U)
+    {
+      for (model_reaction::seq_citer it(reactions.begin());
+	   it != reactions.end(); ++it)
+	{
+	  int f(in.get_int());
+	  int r(in.get_int());
+	  rxn_counter_map_iter rc_it(rxn_count.find(*it));
+	  if (rc_it != rxn_count.end())
+	    {
+	      rc_it->second = CH_STD::make_pair(counter(f), counter(r));
+	    }
+	}
+    }
+  // continue from where the checkpoint was written
+  steps = saved_steps;
+  checkpoint_step = steps;
+  set_initial(x);
+  rates_current = false;
+  return;
+}
+
+// calculate total probability and select a reaction to be performed
+// return that reaction, its ensembles, and total transition probability
+// the sign of the total transition probability determines the direction
+// of the reaction
+CH_STD::pair<unsigned int,double>
+kmc::select_reaction()
+  throw (bad_pointer, bad_type, bad_request, bad_value)
+{
+  // bring the rates up to date
+  update_rates();
+  // the total transition (reaction) probability
+  double total_rate(rates.total());
+  // make sure a reaction is possible
+  if (total_rate < precision::get().get_double())
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":kmc::select_reaction(): sum total of all absolute "
+			"rates is equivalent to zero: "
+			+ t_string(total_rate));
+    }
+  // get random number in range [0, total_rate) and find its reaction
+  unsigned int i(rates.find(random->get_random_open(total_rate)));
+  // determine sign of rate
+  if (net_rates[i] < 0.0e0)
+    {
+      // reverse reaction
+      total_rate *= -1.0e0;
+      // increment the counter, if necessary
+      if (!rxn_count.empty())
+	{
+	  ++(rxn_count[rxn_order[i]->first].second);
+	}
+    }
+  // forward reaction
+  else if (!rxn_count.empty())
+    {
+      ++(rxn_count[rxn_order[i]->first].first);
+    }
+  // return the pair
+  return CH_STD::make_pair(i, total_rate);
+}
+
+// calculate the net reaction rate of a reaction
+double
+kmc::get_net_rate(rxn_ensemble_map_citer rxn_ens_it) const
+  throw (bad_pointer, bad_type, bad_request)
+{
+  // get the rates at the current temperature
+  double f_rate(0.0e0);
+  double r_rate(0.0e0);
+  get_rates(rxn_ens_it, state_info->get_reactor()->get_temperature(),
+	    f_rate, r_rate);
+  // calculate net rate
+  double net_rate(f_rate - r_rate);
+  // output reaction and its rates
+  if (debug::get().get_level() > 2U)
+    {
+      debug::get().get_stream() << '\t' << rxn_ens_it->first->stringify()
+				<< ":f=" << f_rate << ";r=" << r_rate << ";n="
+				<< net_rate << ";" << CH_STD::endl;
+    }
+  return net_rate;
+}
+
+// calculate the forward and reverse rates of a reaction at temperature T
+void
+kmc::get_rates(rxn_ensemble_map_citer rxn_ens_it, double T,
+	       double& f_rate, double& r_rate, bool per_ensemble) const
+  throw (bad_pointer, bad_type, bad_request)
+{
+  if (sites > 0U)		// lattice is used
+    {
+      // get the rates excluding the surface species
+      f_rate = rxn_ens_it->first->get_fluid_forward_rate(T);
+      r_rate = rxn_ens_it->first->get_fluid_reverse_rate(T);
+    }
+  else				// no lattice
     {
       // get the rates for the reaction
-      f_rate = rxn_ens_it->first->get_forward_rate(state_info->get_reactor()->get_temperature());
-      r_rate = rxn_ens_it->first->get_reverse_rate(state_info->get_reactor()->get_temperature());
+      f_rate = rxn_ens_it->first->get_forward_rate(T);
+      r_rate = rxn_ens_it->first->get_reverse_rate(T);
     }
   // make sure it is ok to perform this reaction
   check_quantities(rxn_ens_it->first, f_rate, r_rate);
   // see if there is a surface ensemble (non gas-phase reaction using lattice)
-  if (rxn_ens_it->second.first != ensembles.end())
+  if (!per_ensemble && rxn_ens_it->second.first != ensemble::npos)
     {
       // find out how many of this reactions ensemble type we have
-      f_rate *= rxn_ens_it->second.first->second.size();
+      f_rate *= buckets[rxn_ens_it->second.first].size();
       // check if reaction is reversible
-      if (rxn_ens_it->second.second != ensembles.end())
+      if (rxn_ens_it->second.second != ensemble::npos)
 	{
 	  // find out how many of this reactions ensemble type we have
-	  r_rate *= rxn_ens_it->second.second->second.size();
+	  r_rate *= buckets[rxn_ens_it->second.second].size();
 	}
     }
   // scale the rates to proper amount and units
@@ -970,16 +3168,7 @@ kmc::get_net_rate(rxn_ensemble_iter_map_citer rxn_ens_it) const
     }
   f_rate *= scale_it->second.first;
   r_rate *= scale_it->second.second;
-  // calculate net rate
-  double net_rate(f_rate - r_rate);
-  // output reaction and its rates
-  if (debug::get().get_level() > 2U)
-    {
-      debug::get().get_stream() << '\t' << rxn_ens_it->first->stringify()
-				<< ":f=" << f_rate << ";r=" << r_rate << ";n="
-				<< net_rate << ";" << CH_STD::endl;
-    }
-  return net_rate;
+  return;
 }
 
 // given the reactor sites and scaling, see if there are enough of
@@ -1017,44 +3206,13 @@ kmc::check_quantities(model_reaction* rxn, double& f_rate, double& r_rate)
   return;
 }
 
-// perform the given reaction, update surface and species quantities
-bool
-kmc::perform_reaction(model_reaction& rxn)
-  throw (bad_request, bad_value, bad_pointer, bad_input, bad_type)
-{
-  // create ensemble for reactants
-  ensemble reactant_ens(rxn.get_reactant_seq());
-  // reactants should just be empty sites, and should be in the map
-  ensemble_map_iter em_it(ensembles.find(reactant_ens));
-  // make sure it found it
-  if (em_it == ensembles.end())
-    {
-      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
-			":kmc::perform_reaction(): empty site ensemble "
-			"required not found in ensemble map, something is "
-			"terribly wrong");
-    }
-  // make sure the map for this ensemble is not empty
-  if (em_it->second.empty())
-    {
-      return false;
-    }
-  // create a rxn_ensemble_iter_map with just this entry
-  rxn_ensemble_iter_map tmp_map;
-  // insert the single entry and save the iterator
-  rxn_ensemble_iter_map_iter tmp_it(tmp_map.insert(CH_STD::make_pair(&rxn, CH_STD::make_pair(em_it, ensembles.end()))).first);
-  // perform the reaction
-  perform_reaction(tmp_it, 1.0e0);
-  return true;
-}
-
 // perform the given reaction, update surface and species quantities
 void
-kmc::perform_reaction(rxn_ensemble_iter_map_iter rxn_for_rev, double rate)
+kmc::perform_reaction(rxn_ensemble_map_iter rxn_for_rev, double rate)
   throw (bad_value, bad_pointer, bad_request, bad_input, bad_type)
 {
-  // iterator to the map entry containing the map of iterators to choose from
-  ensemble_map_iter ens_map_it;
+  // type of the ensembles to choose from
+  unsigned int type(ensemble::npos);
   // lists of reactants and products
   const model_species::seq* reactants(0);
   const model_species::seq* products(0);
@@ -1062,7 +3220,7 @@ kmc::perform_reaction(rxn_ensemble_iter_map_iter rxn_for_rev, double rate)
   if (rate > 0.0e0)
     {
       // forward reaction
-      ens_map_it = rxn_for_rev->second.first;
+      type = rxn_for_rev->second.first;
       // set up lists of reactants and products
       reactants = rxn_for_rev->first->get_reactant_seq_ptr();
       products = rxn_for_rev->first->get_product_seq_ptr();
@@ -1070,7 +3228,7 @@ kmc::perform_reaction(rxn_ensemble_iter_map_iter rxn_for_rev, double rate)
   else if (rate < 0.0e0)
     {
       // reverse reaction
-      ens_map_it = rxn_for_rev->second.second;
+      type = rxn_for_rev->second.second;
       // set up lists of reactants and products
       reactants = rxn_for_rev->first->get_product_seq_ptr();
       products = rxn_for_rev->first->get_reactant_seq_ptr();
@@ -1091,11 +3249,11 @@ kmc::perform_reaction(rxn_ensemble_iter_map_iter rxn_for_rev, double rate)
 		      "non-integral stoichiometric coefficient");
     }
   // see if it is a reaction involving the surface
-  if (ens_map_it != ensembles.end())
+  if (type != ensemble::npos)
     {
-      // get the size of the map of ensembles
-      unsigned int size(ens_map_it->second.size());
-      // make sure there are ensembles in this map
+      // get the number of ensembles of this type
+      unsigned int size(buckets[type].size());
+      // make sure there are ensembles of it
       if (size < 1U)
 	{
 	  throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
@@ -1103,21 +3261,17 @@ kmc::perform_reaction(rxn_ensemble_iter_map_iter rxn_for_rev, double rate)
 			    "requested which has none of its ensembles "
 			    "currently on the surface");
 	}
-      // randomly select an environment/ensemble from the map list of them
-      // NOTE: this may be nondeterministic (relies on how memory is allocated)
-      unsigned int r(random->get_random(size));
-      // get the beginning of the map
-      ens_env_map_iter ens_env_it(ens_map_it->second.begin());
-      // step through the map until we get the one we want
-      for (unsigned int u(0); u < r; ++u) ++ens_env_it;
-      // declare needed variables for call to change_ensemble()
-      ensemble::deq destroyed_ens;
-      environment::group changed;
+      // randomly select an environment/ensemble from the bucket of them
+      ensemble_bucket::entry
+	ens_env(buckets[type][random->get_random(size)]);
+      // reuse the containers filled by change_ensemble()
+      destroyed.clear();
+      changed.clear();
       // call change_ensemble() to perform the reaction on the surface
-      (ens_env_it->second)->change_ensemble(ens_env_it->first, *products,
-					    destroyed_ens, changed);
+      (ens_env.second)->change_ensemble(ens_env.first, *products,
+					destroyed, changed, *random, pool);
       // delete the ensembles that were destroyed
-      delete_ensembles(destroyed_ens);
+      delete_ensembles(destroyed);
       // get the new ensembles
       get_ensembles(changed);
     }
@@ -1127,34 +3281,26 @@ kmc::perform_reaction(rxn_ensemble_iter_map_iter rxn_for_rev, double rate)
   return;
 }
 
-// delete the ensembles in the deque
+// remove the given ensembles and return them to the pool
 void
-kmc::delete_ensembles(ensemble::deq& old_ensembles)
+kmc::delete_ensembles(const ensemble::seq& old_ensembles)
+  throw (bad_pointer)
 {
-  // NOTE: this could be time consuming
-  // loop through the deque of ensembles that were destroyed (by reaction)
-  for (ensemble::deq_iter ens_it(old_ensembles.begin());
+  // loop through the ensembles that were destroyed (by reaction)
+  for (ensemble::seq_citer ens_it(old_ensembles.begin());
        ens_it != old_ensembles.end(); ++ens_it)
     {
-      // find the map entry for this kind of ensemble
-      ensemble_map_iter ens_map_it(ensembles.find(**ens_it));
-      // some ensembles are of no importance, see if this one is
-      if (ens_map_it != ensembles.end())
+      // erase this entry from the bucket of its type, check if it was
+      if (!buckets[(*ens_it)->get_type()].erase(*ens_it))
 	{
-	  // erase this entry from the map of this ensemble, check if it was
-	  if (ens_map_it->second.erase(*ens_it) < 1)
-	    {
-	      throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
-				+ ":kmc::perform_reaction(): an ensemble "
-				"was determined to be in the mechanism, "
-				"but the pointer to is was not entered "
-				"into the deque of ensemble pointers; "
-				"something has been corrupted");
-	    }
+	  throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
+			    + ":kmc::delete_ensembles(): an ensemble was "
+			    "determined to be in the mechanism, but the "
+			    "pointer to it was not entered into its bucket; "
+			    "something has been corrupted");
 	}
-      // delete the ensemble regardless of whether it is in mechanism
-      delete *ens_it;
-      *ens_it = 0;
+      // recycle the ensemble
+      pool.put(*ens_it);
     }
   return;
 }
@@ -1167,6 +3313,15 @@ kmc::output_header()
   integrator::output_header();
   // output header for kmc steps
   *out_file << "\tsteps";
+  // replicas are followed by the standard errors of the species
+  if (!replica_runs.empty())
+    {
+      for (model_species::seq_citer sp_it(mech->species_seq_begin());
+	   sp_it != mech->species_seq_end(); ++sp_it)
+	{
+	  *out_file << "\tse(" << (*sp_it)->get_name() << ')';
+	}
+    }
   // insert a new line and flush the buffer
   *out_file << CH_STD::endl;
   // see if we need to output the reaction counter information
@@ -1178,20 +3333,42 @@ kmc::output_header()
 		<< "# " << u++ << ":x" << CH_STD::endl;
       count_out << "# " << u++ << ":total kmc steps" << CH_STD::endl;
       // output all of the reactions in order
-      for (CH_STD::map<model_reaction*,CH_STD::pair<counter,counter> >::const_iterator rc_it(rxn_count.begin()); rc_it != rxn_count.end(); ++rc_it)
+      for (rxn_counter_map_citer rc_it(rxn_count.begin());
+	   rc_it != rxn_count.end(); ++rc_it)
 	{
 	  // output each of the reactions
 	  count_out << "# " << u++ << ": for/rev steps for "
 		    << rc_it->first->stringify() << CH_STD::endl;
 	}
+      // replicas are followed by the standard errors of the counts
+      if (!replica_runs.empty())
+	{
+	  for (rxn_counter_map_citer rc_it(rxn_count.begin());
+	       rc_it != rxn_count.end(); ++rc_it)
+	    {
+	      count_out << "# " << u++ << ": for/rev standard error for "
+			<< rc_it->first->stringify() << CH_STD::endl;
+	    }
+	}
     }
+  // the rest of the output goes through the writer thread
+  writer.start(output_records);
+  return;
+}
+
+// write all of the output still queued
+void
+kmc::finish()
+  throw (bad_file)
+{
+  writer.finish();
   return;
 }
 
 // method to output progress of integration
 void
 kmc::output(double x)
-  throw (bad_type, bad_request, bad_value)
+  throw (bad_type, bad_request, bad_value, bad_file)
 {
   output(x, *out_file);
   return;
@@ -1200,33 +3377,41 @@ kmc::output(double x)
 // output the current output point and its values to the given stream
 void
 kmc::output(double x, CH_STD::ostream& output_stream)
-  throw (bad_type, bad_request, bad_value)
+  throw (bad_type, bad_request, bad_value, bad_file)
 {
+  // replicas are averaged
+  if (!replica_runs.empty())
+    {
+      replica_output(x, output_stream);
+      return;
+    }
+  // format the row here, so only the writer waits for the disk
+  CH_STD::ostringstream row;
+  row.copyfmt(output_stream);
   // call base class method
-  integrator::output(x, output_stream);
+  integrator::output(x, row);
   // output the number of kmc steps
-  output_stream << '\t' << steps;
-  // insert a new line and flush the buffer
-  output_stream << CH_STD::endl;
+  row << '\t' << steps << '\n';
+  emit(output_stream, row.str());
   // output surface, if desired
-  if (surface_out.is_open())
-    {
-      surface_out << "x = " << x << CH_STD::endl
-		  << surface.stringify() << CH_STD::endl;
-    }
+  output_surface(x, steps, surface);
   // see if we need to output the reaction counter information
   if (count_out.is_open())
     {
+      CH_STD::ostringstream line;
+      line.copyfmt(count_out);
       // output where we are in the simulation
-      count_out << x << '\t' << steps;
+      line << x << '\t' << steps;
       // output all of the reactions in order
-      for (CH_STD::map<model_reaction*,CH_STD::pair<counter,counter> >::const_iterator rc_it(rxn_count.begin()); rc_it != rxn_count.end(); ++rc_it)
+      for (rxn_counter_map_citer rc_it(rxn_count.begin());
+	   rc_it != rxn_count.end(); ++rc_it)
 	{
 	  // output count for each of the reactions
-	  count_out << '\t' << rc_it->second.first.get_count()
-		    << '/' << rc_it->second.second.get_count();
+	  line << '\t' << rc_it->second.first.get_count()
+	       << '/' << rc_it->second.second.get_count();
 	}
-      count_out << CH_STD::endl;
+      line << '\n';
+      emit(count_out, line.str());
     }
   return;
 }
@@ -1295,6 +3480,40 @@ kmc::parse(token_seq_citer& token_it, token_seq_citer end)
 	  ++token_it;
 	  continue;		// while ()
 	}
+      // set number of output records queued for the writer thread
+      else if (icompare(*token_it, "output_queue") == 0)
+	{
+	  // next token is the number of records (zero to write as we go)
+	  int records(CH_STD::atoi((++token_it)->c_str()));
+	  if (records < 0)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":kmc::parse(): invalid output_queue for "
+			      "integrator: can not queue < 0 records: "
+			      + *token_it);
+	    }
+	  output_records = (unsigned int) records;
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set format of surface file
+      else if (icompare(*token_it, "surface_format") == 0)
+	{
+	  // next token is either text or binary
+	  surface_format = *++token_it;
+	  if (icompare(surface_format, "text") != 0
+	      && icompare(surface_format, "binary") != 0)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__)
+			      + ":kmc::parse(): invalid surface_format for "
+			      "integrator: " + surface_format + " (must be "
+			      "text or binary)");
+	    }
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
       // set scaling factor
       else if (icompare(*token_it, "scale") == 0)
 	{
@@ -1329,6 +3548,100 @@ kmc::parse(token_seq_citer& token_it, token_seq_citer end)
 	  ++token_it;
 	  continue;		// while ()
 	}
+      // set how temperature ramps are followed
+      else if (icompare(*token_it, "temperature_ramp") == 0)
+	{
+	  // get the next token
+	  CH_STD::string ramp_type(*++token_it);
+	  // rates only change after each event
+	  if (icompare(ramp_type, "event") == 0)
+	    {
+	      exact_ramp = false;
+	    }
+	  // rates change continuously (null events)
+	  else if (icompare(ramp_type, "exact") == 0)
+	    {
+	      exact_ramp = true;
+	    }
+	  else
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":kmc::parse(): syntax error in input "
+			      "for temperature ramp type, unknown type: "
+			      + *token_it);
+	    }
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set the temperature span of exact ramp windows
+      else if (icompare(*token_it, "ramp_window") == 0)
+	{
+	  // set the window equal to the next argument
+	  ramp_window = CH_STD::atof((++token_it)->c_str());
+	  // make sure the window goes somewhere
+	  if (ramp_window < precision::get().get_double())
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":kmc::parse(): syntax error in input "
+			      "for integrator: ramp window must be positive: "
+			      + *token_it);
+	    }
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set the number of threads to perform events in
+      else if (icompare(*token_it, "threads") == 0)
+	{
+	  // zero means one for each processor
+	  int new_threads(CH_STD::atoi((++token_it)->c_str()));
+	  if (new_threads < 0)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":kmc::parse(): syntax error in input "
+			      "for integrator: can not set threads < 0: "
+			      + *token_it);
+	    }
+	  threads = (new_threads == 0) ? thread_team::get_processors()
+	    : (unsigned int) new_threads;
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set the number of independent copies to average over
+      else if (icompare(*token_it, "replicas") == 0)
+	{
+	  int new_replicas(CH_STD::atoi((++token_it)->c_str()));
+	  if (new_replicas < 1)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":kmc::parse(): syntax error in input "
+			      "for integrator: can not set replicas < 1: "
+			      + *token_it);
+	    }
+	  replicas = (unsigned int) new_replicas;
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set the mean number of events per domain in a parallel cycle
+      else if (icompare(*token_it, "sublattice_events") == 0)
+	{
+	  // set the events equal to the next argument
+	  sublattice_events = CH_STD::atof((++token_it)->c_str());
+	  // make sure cycles go somewhere
+	  if (sublattice_events < precision::get().get_double())
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":kmc::parse(): syntax error in input "
+			      "for integrator: sublattice events must be "
+			      "positive: " + *token_it);
+	    }
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
       // set name of counter file
       else if (icompare(*token_it, "reaction_counter") == 0)
 	{
@@ -1338,6 +3651,55 @@ kmc::parse(token_seq_citer& token_it, token_seq_citer end)
 	  ++token_it;
 	  continue;		// while ()
 	}
+      // set name of checkpoint file
+      else if (icompare(*token_it, "checkpoint") == 0)
+	{
+	  // next token is the name of file to write checkpoints to
+	  checkpoint_filename = *++token_it;
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set the number of steps between checkpoints
+      else if (icompare(*token_it, "checkpoint_steps") == 0)
+	{
+	  int new_steps(CH_STD::atoi((++token_it)->c_str()));
+	  if (new_steps < 0)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":kmc::parse(): syntax error in input "
+			      "for integrator: can not set checkpoint steps "
+			      "< 0: " + *token_it);
+	    }
+	  checkpoint_steps = (unsigned int) new_steps;
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set the wall clock seconds between checkpoints
+      else if (icompare(*token_it, "checkpoint_seconds") == 0)
+	{
+	  checkpoint_seconds = CH_STD::atof((++token_it)->c_str());
+	  if (checkpoint_seconds < 0.0e0)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":kmc::parse(): syntax error in input "
+			      "for integrator: can not set checkpoint seconds "
+			      "< 0: " + *token_it);
+	    }
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set name of checkpoint file to restart from
+      else if (icompare(*token_it, "restart") == 0)
+	{
+	  // next token is the name of the checkpoint file
+	  restart_filename = *++token_it;
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
       // set type of neighbor model
       else if (icompare(*token_it, "neighbor") == 0)
 	{
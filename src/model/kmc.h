@@ -22,6 +22,7 @@
 #ifndef CH_MODEL_KMC_H
 #define CH_MODEL_KMC_H 1
 
+#include <ctime>
 #include <fstream>
 #include <map>
 #include <set>
@@ -29,12 +30,19 @@
 #include <utility>
 #include <vector>
 #include "counter.h"
+#include "domain.h"
 #include "except.h"
 #include "ensemble.h"
 #include "environment.h"
 #include "integrate.h"
 #include "lattice.h"
+#include "matcher.h"
+#include "placement.h"
+#include "profile.h"
+#include "rate_tree.h"
 #include "rng.h"
+#include "snapshot.h"
+#include "writer.h"
 #include "token.h"
 
 // set namespace to avoid possible clashes
@@ -44,41 +52,111 @@ CH_BEGIN_NAMESPACE
 class kmc : public integrator
 {
   // typedef
-  typedef CH_STD::map<ensemble*,environment*> ens_env_map;
-  typedef ens_env_map::iterator ens_env_map_iter;
-  typedef ens_env_map::const_iterator ens_env_map_citer;
-  typedef CH_STD::map<ensemble,ens_env_map> ensemble_map;
-  typedef ensemble_map::iterator ensemble_map_iter;
-  typedef ensemble_map::const_iterator ensemble_map_citer;
-  typedef CH_STD::pair<ensemble_map_iter,ensemble_map_iter>
-    ensemble_map_iter_pair;
-  typedef CH_STD::map<model_reaction*,ensemble_map_iter_pair>
-    rxn_ensemble_iter_map;
-  typedef rxn_ensemble_iter_map::iterator rxn_ensemble_iter_map_iter;
-  typedef rxn_ensemble_iter_map::const_iterator rxn_ensemble_iter_map_citer;
+  // number of each type of ensemble, given out as they are first needed
+  typedef CH_STD::map<ensemble,unsigned int> ensemble_id_map;
+  typedef ensemble_id_map::iterator ensemble_id_map_iter;
+  typedef ensemble_id_map::const_iterator ensemble_id_map_citer;
+  // forward and reverse ensemble types of a reaction (or ensemble::npos)
+  typedef CH_STD::pair<unsigned int,unsigned int> ensemble_id_pair;
+  typedef CH_STD::map<model_reaction*,ensemble_id_pair> rxn_ensemble_map;
+  typedef rxn_ensemble_map::iterator rxn_ensemble_map_iter;
+  typedef rxn_ensemble_map::const_iterator rxn_ensemble_map_citer;
+  typedef CH_STD::vector<rxn_ensemble_map_iter> rxn_ensemble_seq;
+  // forward and reverse counts of each reaction
+  typedef CH_STD::pair<counter,counter> counter_pair;
+  typedef CH_STD::map<model_reaction*,counter_pair> rxn_counter_map;
+  typedef rxn_counter_map::iterator rxn_counter_map_iter;
+  typedef rxn_counter_map::const_iterator rxn_counter_map_citer;
+  // species on each environment and the environments (by index) it
+  // covers if it is on more than one
+  typedef CH_STD::vector<CH_STD::pair<model_species*,
+				      CH_STD::vector<unsigned int> > >
+    occupant_seq;
+  // state shared by the threads of a parallel run (defined in kmc.cc)
+  struct parallel_cycle;
+  // state shared by the threads stepping replicas (defined in kmc.cc)
+  struct replica_cycle;
+  // state shared by the threads setting up environments (defined in kmc.cc)
+  struct setup_cycle;
 
 private:
   rng* random;			// random number generator
   unsigned int sites;		// total number of surface sites
   lattice surface;		// catalyst surface
+  ensemble_pool pool;		// recycled ensembles for the environments
   environment::seq environments; // the environments for all the lattice points
-  ensemble_map ensembles;	// map of what ensembles are available
-  rxn_ensemble_iter_map rxn_ens; // forward/reverse ensembles for a reaction
+  stencil pattern;		// groups of sites around the lattice points
+  ensemble_matcher matcher;	// recognizes ensembles on the surface
+  placement_table placements;	// where products can go on the groups
+  ensemble_id_map ensemble_ids;	// number of each type of ensemble needed
+  // species of each type of ensemble (the keys of ensemble_ids)
+  CH_STD::vector<const ensemble*> ensemble_types;
+  // ensembles of each type currently on the surface
+  CH_STD::vector<ensemble_bucket> buckets;
+  rxn_ensemble_map rxn_ens;	// forward/reverse ensembles for a reaction
+  rxn_ensemble_seq rxn_order;	// reactions in the order of the rate leaves
+  CH_STD::vector<double> net_rates; // current net rate of each reaction
+  rate_tree rates;		// absolute net rates of the reactions
+  // reactions whose rates must be recalculated after each reaction
+  CH_STD::vector<CH_STD::vector<unsigned int> > rxn_depend;
+  model_species::seq fluids;	// non-surface species reactor may change
+  CH_STD::vector<double> fluid_amounts; // fluid quantities rates were for
+  // reactions whose rates depend on each fluid species
+  CH_STD::vector<CH_STD::vector<unsigned int> > fluid_depend;
+  CH_STD::vector<unsigned int> stale_rates; // rates needing recalculation
+  CH_STD::vector<bool> stale;	// is the rate of reaction in stale_rates
+  bool rates_current;		// are the rates (other than stale) valid
+  double rate_temperature;	// temperature rates were calculated at
+  bool exact_ramp;		// follow temperature ramps with null events?
+  double ramp_window;		// temperature span the rate bounds cover
+  // temperatures at the start and end of the current rate bound window
+  CH_STD::pair<double,double> window_T;
+  ensemble::seq destroyed;	// ensembles replaced by the last reaction
+  environment::seq changed;	// environments changed by the last reaction
   unsigned int max_coordination; // highest coordination of a surface species
   unsigned int max_sites;	// maximum number of sites needed in reactions
   CH_STD::string surface_filename; // file to output surface snapshots to
   CH_STD::ofstream surface_out;	// stream to output surface snapshots to
+  CH_STD::string surface_format; // text pictures or binary snapshots
+  snapshot_ofstream* surface_snapshots; // binary snapshot file (or 0)
+  unsigned int output_records;	// records the writer thread may queue
+  output_writer writer;		// writes the output files in the background
   unsigned int steps;		// how many kmc steps have been taken
   bool event_rate;		// are rate constants event based?
   double scale;			// scale-up factor for reactors
   // rate scale factor for coverages and unit conversion
   CH_STD::map<model_reaction*,CH_STD::pair<double,double> > rate_scale;
   // times each rxn performed
-  CH_STD::map<model_reaction*,CH_STD::pair<counter,counter> > rxn_count;
+  rxn_counter_map rxn_count;
   CH_STD::string count_filename; // name of file to output count into
   CH_STD::ofstream count_out;	// file to output rxn counter
   CH_STD::string env_type;	// input for environment type
   bool env_radial;		// environment site creation scheme
+  unsigned int threads;		// number of threads to perform events in
+  double sublattice_events;	// mean events per domain in each cycle
+  domain::seq domains;		// blocks of the surface for parallel runs
+  // domains of each of the four sublattices (active at the same time)
+  CH_STD::vector<CH_STD::vector<unsigned int> > sublattices;
+  CH_STD::vector<unsigned int> env_domain; // domain of each environment
+  // forward and reverse ensemble types of each reaction (or npos)
+  CH_STD::vector<CH_STD::pair<unsigned int,unsigned int> > rxn_types;
+  // forward and reverse rate of each reaction for a single ensemble
+  CH_STD::vector<CH_STD::pair<double,double> > unit_rates;
+  CH_STD::vector<unsigned int> fluid_rxns; // reactions off the surface
+  unsigned int replicas;	// number of independent copies to average
+  CH_STD::vector<kmc*> replica_runs; // the copies (if replicas > 1)
+  CH_STD::vector<model_mechanism*> replica_mechs; // their mechanisms
+  CH_STD::vector<double> replica_x; // independent variable of each copy
+  CH_STD::string checkpoint_filename; // file to write checkpoints to
+  unsigned int checkpoint_steps; // steps between checkpoints (0 for none)
+  double checkpoint_seconds;	// wall seconds between checkpoints (0 for none)
+  unsigned int checkpoint_step;	// steps taken at the last checkpoint
+  CH_STD::time_t checkpoint_time; // wall time of the last checkpoint
+  CH_STD::string restart_filename; // checkpoint to restart the run from
+  profile setup_times;		// how long each phase of setting up took
+  static const char* const checkpoint_magic; // start of checkpoint files
+  static const unsigned int checkpoint_version; // their format version
+  static const char* const setup_phases[]; // stages of setting up surface
 
 private:
   // prevent assignment
@@ -93,33 +171,64 @@ private:
   ul_int set_rng_seed(ul_int seed);
   // set everything up
   virtual void initialize()
-    throw (bad_pointer, bad_input, bad_value, bad_type, bad_request); // this,
+    throw (bad_pointer, bad_input, bad_value, bad_type, bad_request,
+	   bad_file); // this,
 				// lattice::initialize(), initial_coverage(),
 				// create_environments(), create_ensembles(),
 				// model_reaction::set_amount_type(),
 				// integrator::initialize(),
 				// reactor::kmc_initialize(),
-				// calc_rate_scale()
+				// calc_rate_scale(), restart()
   // calculate the maximum surface coordination of all species in model,
   // return max_coordination
   unsigned int calc_max_coordination();
+  // return the species which occupy surface sites, in mechanism order
+  model_species::seq get_surface_species() const;
   // loop through the reactions and insert the surface reactants into ensembles
   void create_ensembles(model_species* empty_site)
     throw (bad_input); // this, model_reaction::get_reactant_seq(),
                        // model_reaction::get_product_seq()
+  // return the number of the type of ensemble ENS, numbering it (with
+  // an empty bucket) if it is new
+  unsigned int intern_ensemble(const ensemble& ens);
   // setup rxn counter, if we need to
   void initialize_rxn_counter();
-  // create and initialize the environments, fill ensembles
-  void create_environments(model_species* empty_site)
+  // create and connect the environments and find their groups of
+  // sites; if OCCUPANTS is given, put its species on the environments
+  void create_environments(model_species* empty_site,
+			   const occupant_seq* occupants = 0)
     throw (bad_request, bad_value, bad_pointer, bad_input); // this,
-				// lattice::get_point(),
+				// stencil::create(),
+				// environment::restore_species(),
+				// thread_team::run()
+  // number the types of ensemble and have the matcher recognize them
+  void create_matcher()
+    throw (bad_pointer);	// ensemble_matcher::insert()
+  // list the ways the products of the reactions covering more than one
+  // site can be put on the groups of sites of the surface
+  void create_placements()
+    throw (bad_request);	// placement_table::insert()
+  // create the ensembles of the environments for the species on them
+  void initialize_environments()
+    throw (bad_request, bad_pointer); // create_matcher(),
+				// create_placements(), thread_team::run()
+  // what each thread setting up environments does, DATA is a setup_cycle
+  static void setup_work(void* data, unsigned int rank);
+  // perform stage STAGE of setting up the environments as member RANK
+  // of a team of SIZE
+  void setup_stage(setup_cycle& cycle, unsigned int stage,
+		   unsigned int rank, unsigned int size)
+    throw (bad_value, bad_pointer, bad_request);
 				// environment::set_neighbors(),
 				// environment::initialize()
+  // write how long each phase of setting up took to the debugging
+  // stream, if debugging
+  void report_setup() const;
   // get all the ensembles from the environments, inserting those we are
   // interested in
   void get_ensembles();
   // get the ensembles from the given environments
-  void get_ensembles(environment::group& changed_environments);
+  void get_ensembles(const environment::seq& changed_environments);
   // factor to scale surface rates by to account for coverage ``units''
   // and reactor units
   void calc_rate_scale()
@@ -130,14 +239,14 @@ private:
   void count_sites(CH_STD::vector<counter>& site_count) const
     throw (bad_value);	// this
   // return the inverse of the total possible sites available for this rxn
-  double site_scale(rxn_ensemble_iter_map_iter rxn_ens_it,
+  double site_scale(rxn_ensemble_map_iter rxn_ens_it,
 		    const CH_STD::vector<counter>& site_count) const
     throw (bad_value);	// get_site_count()
   // return the current count of sites having the same size as reaction's
   int get_site_count(const CH_STD::vector<counter>& site_count, int size) const
     throw (bad_value);		// this
   // scaling correction for reactions with multisite species
-  void multisite_scale(rxn_ensemble_iter_map_iter rxn_ens_it,
+  void multisite_scale(rxn_ensemble_map_iter rxn_ens_it,
 		       const CH_STD::vector<counter>& site_count,
 		       double& f_scale, double& r_scale) const
     throw (bad_value);		// multisite_scale()
@@ -150,25 +259,177 @@ private:
     const;
   // go through the reacting species and determine the maximum rate
   double coverage_scale(const stoich_map& reactants) const;
-  // initialize the surface to the appropriate coverages
+  // initialize the surface to the appropriate coverages, putting the
+  // species on randomly chosen empty sites before the environments
+  // create their ensembles
   void initial_coverage(model_species* empty_site)
-    throw (bad_input, bad_request, bad_value, bad_pointer, bad_type); // this,
-				// perform_reaction(),
+    throw (bad_input, bad_request, bad_value, bad_pointer, bad_type,
+	   bad_file); // this,
+				// environment::restore_species(),
+				// reactor::kmc_reaction(),
 				// model_species::set_quantity(),
 				// model_species::get_quantity()
+  // put each group of COORD empty sites on the surface once, one after
+  // another, in MEMBERS and where each of them ends in ENDS
+  void empty_places(model_species* empty_site, unsigned int coord,
+		    environment::seq& members,
+		    CH_STD::vector<unsigned int>& ends) const;
   // method to handle a kinetic Monte Carlo integration
   virtual double step(double ti, double tf)
-    throw (bad_pointer, bad_type, bad_value, bad_request, bad_input);
+    throw (bad_pointer, bad_type, bad_value, bad_request, bad_input,
+	   bad_file);
 				// select_reaction(), perform_reaction(),
-				// reactor::kmc_step()
+				// reactor::kmc_step(), checkpoint()
+  // put the reactions in order for selection and size the rate tree
+  void index_reactions();
+  // determine which reaction rates depend on each reaction and fluid
+  void create_dependencies();
+  // flag the rate of the reaction at leaf I for recalculation
+  void mark_stale(unsigned int i);
+  // flag the reactions affected by performing the reaction at leaf I
+  void mark_dependents(unsigned int i);
+  // flag the reactions affected by changes the reactor made in a step
+  void check_reactor()
+    throw (bad_type); // check_fluids()
+  // flag the reactions affected by fluid quantities the reactor changed
+  void check_fluids()
+    throw (bad_type); // model_species::get_quantity()
+  // recalculate the stale rates and update the rate tree
+  void update_rates()
+    throw (bad_pointer, bad_type, bad_request, bad_value); // get_net_rate(),
+				// rate_tree::assign(), rate_tree::set()
+  // perform kinetic Monte Carlo steps from XI to XF following the rates
+  // exactly as they change during a temperature ramp
+  void ramp_steps(double& xi, double xf)
+    throw (bad_pointer, bad_type, bad_value, bad_request, bad_input);
+				// update_bounds(), get_net_rate(),
+				// perform_reaction(), reactor::kmc_step()
+  // recalculate the stale rate bounds and update the rate tree
+  void update_bounds()
+    throw (bad_pointer, bad_type, bad_request, bad_value); // get_rate_bound(),
+				// rate_tree::assign(), rate_tree::set()
+  // return a bound on the forward plus reverse rate of a reaction in the
+  // current window
+  double get_rate_bound(rxn_ensemble_map_citer rxn_ens_it) const
+    throw (bad_pointer, bad_type, bad_request); // get_rates()
+  // perform kinetic Monte Carlo steps from XI to XF in several threads
+  // using synchronous sublattices, return false if the surface can not
+  // be divided
+  bool parallel_steps(double& xi, double xf)
+    throw (bad_pointer, bad_type, bad_value, bad_request, bad_input);
+				// create_domains(), thread_team::run()
+  // divide the surface into domains, return false if it is too small
+  bool create_domains()
+    throw (bad_request, bad_pointer); // this, domain::domain()
+  // what each thread of a parallel run does, DATA is a parallel_cycle
+  static void parallel_work(void* data, unsigned int rank);
+  // perform stage STAGE of a cycle as member RANK of a team of SIZE
+  void parallel_stage(parallel_cycle& cycle, unsigned int stage,
+		      unsigned int rank, unsigned int size)
+    throw (bad_pointer, bad_type, bad_value, bad_request, bad_input);
+				// merge_domains(), update_unit_rates(),
+				// refresh_domain(), select_sublattice(),
+				// domain_steps()
+  // recalculate the rates for a single ensemble, return whether any
+  // changed
+  bool update_unit_rates()
+    throw (bad_pointer, bad_type, bad_request); // get_rates()
+  // recalculate all the rates of domain D
+  void refresh_domain(unsigned int d)
+    throw (bad_value); // domain::set_net_rate()
+  // return the net rate of the reaction at leaf I in domain D
+  double get_domain_rate(unsigned int d, unsigned int i) const;
+  // choose the length of the next cycle and the sublattice active in it
+  void select_sublattice(parallel_cycle& cycle)
+    throw (bad_pointer, bad_type, bad_request); // get_net_rate()
+  // perform events in domain D for TAU
+  void domain_steps(unsigned int d, double tau)
+    throw (bad_pointer, bad_value, bad_request, bad_input); // domain_event()
+  // perform event EV in domain D
+  void domain_event(unsigned int d, const domain::event& ev)
+    throw (bad_pointer, bad_value, bad_request, bad_input); // this,
+				// environment::change_ensemble(),
+				// domain::set_net_rate()
+  // bring the buckets of the domains and the species quantities up to
+  // date with the events of the last cycle
+  void merge_domains(parallel_cycle& cycle)
+    throw (bad_pointer, bad_type, bad_value, bad_request, bad_input);
+				// this, reactor::kmc_reaction(),
+				// fluid_steps(), reactor::kmc_step()
+  // perform the reactions not involving the surface for TAU
+  void fluid_steps(double tau)
+    throw (bad_pointer, bad_type, bad_value, bad_request, bad_input);
+				// get_net_rate(), perform_reaction()
+  // create and initialize the replicas, each with its own mechanism and
+  // random number generator seeded from ours
+  void create_replicas()
+    throw (bad_pointer, bad_input, bad_value, bad_type, bad_request,
+	   bad_file);
+				// this, model_mechanism::copy(), kmc(),
+				// initialize()
+  // step every replica from where it is to XF in several threads
+  void replica_steps(double xf)
+    throw (bad_request); // thread_team::run()
+  // what each thread stepping replicas does, DATA is a replica_cycle
+  static void replica_work(void* data, unsigned int rank);
+  // output the mean over the replicas of the current values, followed by
+  // their standard errors
+  void replica_output(double x, CH_STD::ostream& output_stream)
+    throw (bad_type, bad_request, bad_value, bad_file);
+				// model_species::get_quantity(),
+				// output_surface()
+  // return the mean of VALUES and its standard error
+  static CH_STD::pair<double,double>
+    mean_error(const CH_STD::vector<double>& values);
+  // write TEXT to STREAM, through the writer if it is one of our files
+  void emit(CH_STD::ostream& stream, const CH_STD::string& text)
+    throw (bad_file); // output_writer::put()
+  // open the surface output file in the requested format
+  void open_surface()
+    throw (bad_file, bad_value); // snapshot_ofstream()
+  // output SURFACE at X, after STEPS_ kmc steps, to the surface file,
+  // if there is one
+  void output_surface(double x, unsigned int steps_,
+		      const lattice& surface_)
+    throw (bad_file, bad_request, bad_value); // lattice::stringify(),
+				// snapshot_ofstream::encode_frame(), emit(),
+				// output_writer::put()
+  // write a checkpoint at X if enough steps or wall time have passed
+  // since the last one or, if no interval was given, at every output
+  // point (BOUNDARY)
+  void checkpoint(double x, bool boundary = false)
+    throw (bad_file, bad_request); // write_checkpoint()
+  // write everything needed to continue the run from X to the
+  // checkpoint file
+  void write_checkpoint(double x) const
+    throw (bad_file, bad_request); // this, binary_ofstream::put_header(),
+				// model_species::save_quantity(),
+				// reactor::save_state(), rng::save_state()
+  // rebuild the surface from the restart file, putting its ensembles in
+  // the order they were in, and restore the quantities, reactor, random
+  // number generator, and counts saved with it
+  void restart(model_species* empty_site)
+    throw (bad_file, bad_input, bad_request, bad_value, bad_pointer,
+	   bad_type); // this, create_environments(),
+				// binary_ifstream::get_header(),
+				// model_species::restore_quantity(),
+				// reactor::restore_state(),
+				// rng::restore_state()
   // calculate total probability and select a reaction to be performed
-  // return that reaction, its ensembles, and total transition probability
+  // return the leaf of that reaction and total transition probability
   // the sign of the total transition probability determines the direction
   // of the reaction
-  CH_STD::pair<rxn_ensemble_iter_map_iter,double> select_reaction()
-    throw (bad_pointer, bad_type, bad_request); // this, get_net_rate()
+  CH_STD::pair<unsigned int,double> select_reaction()
+    throw (bad_pointer, bad_type, bad_request, bad_value); // this,
+				// update_rates(), rate_tree::find()
   // calculate the net reaction rate of a reaction
-  double get_net_rate(rxn_ensemble_iter_map_citer rxn_ens_it) const
+  double get_net_rate(rxn_ensemble_map_citer rxn_ens_it) const
+    throw (bad_pointer, bad_type, bad_request); // get_rates()
+  // calculate the forward and reverse rates of a reaction at temperature
+  // T, for all its ensembles or, if PER_ENSEMBLE, for a single one
+  void get_rates(rxn_ensemble_map_citer rxn_ens_it, double T,
+		 double& f_rate, double& r_rate,
+		 bool per_ensemble = false) const
     throw (bad_pointer, bad_type, bad_request); // this,
 				// model_reaction::get_fluid_forward_rate(),
 				// model_reaction::get_fluid_reverse_rate(),
@@ -180,32 +441,32 @@ private:
     const
     throw (bad_type);		// check_quantities()
   // perform the given reaction, update surface and species quantities
-  bool perform_reaction(model_reaction& rxn)
-    throw (bad_request, bad_value, bad_pointer, bad_input, bad_type); // this
-				// perform_reaction(),
-				// model_reaction::get_reactant_seq()
-  void perform_reaction(rxn_ensemble_iter_map_iter rxn_for_rev, double rate)
+  void perform_reaction(rxn_ensemble_map_iter rxn_for_rev, double rate)
     throw (bad_value, bad_pointer, bad_request, bad_input, bad_type); // this,
 				// environment::change_ensemble(),
 				// model_reaction::get_reactant_seq(),
 				// model_reaction::get_product_seq(),
 				// model_species::add_to_quantity(),
 				// reactor::kmc_eqn()
-  // delete the ensembles in the deque
-  void delete_ensembles(ensemble::deq& old_ensembles);
-  // output first row of file
+  // remove the given ensembles and return them to the pool
+  void delete_ensembles(const ensemble::seq& old_ensembles)
+    throw (bad_pointer); // this
+  // output first row of file, then start the writer thread
   virtual void output_header();
   // method to output progress of integration
   virtual void output(double x)
-    throw (bad_type, bad_request, bad_value); // output()
+    throw (bad_type, bad_request, bad_value, bad_file); // output()
   // output the current output point and its values to the given stream
   virtual void output(double x, CH_STD::ostream& output_stream)
-    throw (bad_type, bad_request, bad_value); // integrate::output(),
-				// lattice::stringify()
+    throw (bad_type, bad_request, bad_value, bad_file);
+				// integrate::output(), output_surface()
+  // write all of the output still queued
+  virtual void finish()
+    throw (bad_file); // output_writer::finish()
 public:
   // ctor: (default) set size to default and create default rng
   kmc();
-  // dtor: delete the rng pointer and environments
+  // dtor: delete the rng pointer, environments, domains, and replicas
   virtual ~kmc();
 
   // parse integrator input
@@ -22,6 +22,7 @@
 #include <config.h>
 #endif
 
+#include <cstring>		// for memcpy()
 #include "lattice.h"
 #include "t_string.h"
 
@@ -32,46 +33,48 @@ CH_BEGIN_NAMESPACE
 // ctor: optional lattice size
 // ctor: default size_ = 0U
 lattice::lattice(unsigned int size_)
-  : size(size_), points(), initialized(false)
+  : size(size_), points(), species(), initialized(false)
 {}
 
 // ctor: copy
 lattice::lattice(const lattice& original)
-  : size(original.size), points(), initialized(false)
+  : size(original.size), points(), species(), initialized(false)
 {}
 
-// dtor: delete the lattice_points
+// dtor: do nothing
 lattice::~lattice()
-{
-  // loop through and delete the pointers
-  for (lattice_point::seq_iter it(points.begin()); it != points.end(); ++it)
-    {
-      delete *it;
-      *it = 0;
-    }
-}
+{}
 
-// lattice class private methods
-// create the surface, using size, fill points with empty site
-void
-lattice::make_surface(model_species* empty_site)
+// lattice class public methods
+// return the id of SPECIES_
+lattice::id
+lattice::get_id(model_species* species_) const
+  throw (bad_pointer)
 {
-  // reserve the space we need for the ``surface''
-  points.reserve(size * size);
-  // we have to do this double loop structure to set the row and column
-  // values in the lattice_point's
-  for (unsigned int i(0U); i < size; ++i)
+  // there are only a few surface species
+  for (id i(0U); i < species.size(); ++i)
     {
-      for (unsigned int j(0U); j < size; ++j)
+      if (species[i] == species_)
 	{
-	  // create and insert lattice_point
-	  points.push_back(new lattice_point(empty_site, i, j));
+	  return i;
 	}
     }
-  return;
+  throw bad_pointer(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		    ":lattice::get_id(): species "
+		    + ((species_ == 0) ? CH_STD::string("(null)")
+		       : species_->get_name()) + " can not be put on the "
+		    "surface");
+  // shouldn't get here
+  return 0U;
+}
+
+// return how many species (and so ids) the surface may hold
+unsigned int
+lattice::get_id_count() const
+{
+  return species.size();
 }
 
-// lattice class public methods
 // return the size of one side of the lattice
 unsigned int
 lattice::get_size() const
@@ -97,8 +100,9 @@ lattice::set_size(unsigned int size_)
 
 // create the surface and initilize it, if necessary
 void
-lattice::initialize(model_species* empty_site)
-  throw (bad_pointer)
+lattice::initialize(model_species* empty_site,
+		    const model_species::seq& species_)
+  throw (bad_pointer, bad_value)
 {
   // see if we need to set up a surface
   if (size > 0U)
@@ -111,16 +115,33 @@ lattice::initialize(model_species* empty_site)
 			    "number of sites, but an empty site was not "
 			    "included in the model");
 	}
+      // the empty site has id zero
+      species.clear();
+      species.push_back(empty_site);
+      for (model_species::seq_citer it(species_.begin());
+	   it != species_.end(); ++it)
+	{
+	  if (*it != empty_site)
+	    {
+	      species.push_back(*it);
+	    }
+	}
+      if (species.size() > 0xffffU)
+	{
+	  throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			  ":lattice::initialize(): too many surface species ("
+			  + t_string(species.size()) + ") for the lattice");
+	}
       // create a surface of empty sites
-      make_surface(empty_site);
+      points.assign(size * size, 0U);
     }
   // initialization complete
   initialized = true;
   return;
 }
 
-// return pointer to species at the given point
-lattice_point*
+// return the index of the point at ROW and COLUMN
+unsigned int
 lattice::get_point(unsigned int row, unsigned int column) const
   throw (bad_request, bad_value)
 {
@@ -144,8 +165,24 @@ lattice::get_point(unsigned int row, unsigned int column) const
 		      "column (" + t_string(row) + ") greater than the total "
 		      "number of columns (" + t_string(size) + ")");
     }
-  // get the appropriate lattice_point
-  return points[row * size + column];
+  return row * size + column;
+}
+
+// return the row and column of the point at INDEX
+CH_STD::pair<unsigned int,unsigned int>
+lattice::get_position(unsigned int index) const
+{
+  return CH_STD::make_pair(index / size, index % size);
+}
+
+// change the species at the point at INDEX, return old
+model_species*
+lattice::set_species(unsigned int index, model_species* species_)
+  throw (bad_pointer)
+{
+  model_species* old(species[points[index]]);
+  points[index] = get_id(species_);
+  return old;
 }
 
 // create string representation of a picture of the surface
@@ -154,18 +191,24 @@ CH_STD::string
 lattice::stringify(unsigned int width) const
   throw (bad_request, bad_value)
 {
+  // pad each name to the proper width using spaces, once
+  CH_STD::vector<CH_STD::string> names;
+  names.reserve(species.size());
+  for (model_species::seq_citer it(species.begin()); it != species.end();
+       ++it)
+    {
+      names.push_back((*it)->get_name());
+      names.back().resize(width, ' ');
+    }
   CH_STD::string surface_string;
+  surface_string.reserve(size * (size * width + 1U));
   // double loop through the list of points
   for (unsigned int i(0U); i < size; ++i)
     {
       for (unsigned int j(0U); j < size; ++j)
 	{
-	  // get the species name
-	  CH_STD::string name(get_point(i, j)->get_species()->get_name());
-	  // resize the name to the proper width using spaces
-	  name.resize(width, ' ');
 	  // add species name to the string (and blank space)
-	  surface_string.append(name);
+	  surface_string.append(names[points[get_point(i, j)]]);
 	}
       // add new line after each row
       // NOTE: would like to push_back(char) here, but it is not implemented
@@ -174,6 +217,57 @@ lattice::stringify(unsigned int width) const
   return surface_string;
 }
 
+// write the id in IDS of the species at each point, row by row, into
+// SITES using WIDTH (1 or 2) bytes per point
+void
+lattice::encode(const CH_STD::map<model_species*,unsigned int>& ids,
+		unsigned int width, unsigned char* sites) const
+  throw (bad_request, bad_value)
+{
+  if (!initialized)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":lattice::encode(): lattice has not been initialized "
+			"so it can not be encoded");
+    }
+  // translate our ids into theirs (npos if they have none)
+  const unsigned int npos(~0U);
+  CH_STD::vector<unsigned int> translate(species.size(), npos);
+  for (unsigned int i(0U); i < species.size(); ++i)
+    {
+      CH_STD::map<model_species*,unsigned int>::const_iterator
+	id_it(ids.find(species[i]));
+      if (id_it != ids.end())
+	{
+	  translate[i] = id_it->second;
+	}
+    }
+  for (CH_STD::vector<id>::const_iterator it(points.begin());
+       it != points.end(); ++it)
+    {
+      unsigned int their_id(translate[*it]);
+      if (their_id == npos)
+	{
+	  throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			  ":lattice::encode(): species "
+			  + species[*it]->get_name() + " on the surface has "
+			  "no id");
+	}
+      if (width == 1U)
+	{
+	  *sites++ = static_cast<unsigned char>(their_id);
+	}
+      else
+	{
+	  // ids wider than a byte are in the byte order of the machine
+	  unsigned short wide(static_cast<unsigned short>(their_id));
+	  CH_STD::memcpy(sites, &wide, sizeof(wide));
+	  sites += sizeof(wide);
+	}
+    }
+  return;
+}
+
 CH_END_NAMESPACE
 
 /* $Id: lattice.cc,v 1.1.1.1 2004/11/25 20:24:08 banjo Exp $ */
@@ -22,32 +22,44 @@
 #ifndef CH_MODEL_LATTICE_H
 #define CH_MODEL_LATTICE_H 1
 
+#include <map>
+#include <string>
+#include <utility>
 #include <vector>
 #include "except.h"
 #include "mechanism.h"
-#include "point.h"
+#include "species.h"
 
 // set namespace to avoid possible clashes
 CH_BEGIN_NAMESPACE
 
 // kinetic Monte Carlo lattice class
+/* The surface is stored as one array with a small species id for each
+ * point, row by row, so point (row, column) is at row * size + column.
+ * The species a surface may hold are given when it is initialized; their
+ * ids do not change afterwards, so points may be changed from several
+ * threads at once (as long as they are different points).
+ */
 class lattice
 {
+public:
+  typedef unsigned short id;	// species id stored for each point
+
+private:
   unsigned int size;		// square root of the number of lattice points
-  lattice_point::seq points;	// sequence of pointers to lattice points
+  CH_STD::vector<id> points;	// species id of each point, row by row
+  model_species::seq species;	// species with each id
   bool initialized;		// whether surface has been initialized
 
 private:
   // prevent assignment
   lattice& operator=(const lattice&);
-  // create the surface, using size, fill points with empty site
-  void make_surface(model_species* empty_site);
 public:
   // ctor: (default) optional size
   explicit lattice(unsigned int size_ = 0U);
   // ctor: copy
   explicit lattice(const lattice& original);
-  // dtor: delete the lattice_points
+  // dtor: do nothing
   ~lattice();
 
   // return the size of one side of the lattice
@@ -55,17 +67,54 @@ public:
   // change the size of the lattice, return old value
   unsigned int set_size(unsigned int size_)
     throw (bad_request); // this
-  // initialize the surface, if necessary
-  void initialize(model_species* empty_site)
-    throw (bad_pointer); // this
-  // return pointer to species at the given point
-  lattice_point* get_point(unsigned int row, unsigned int column) const
+  // initialize the surface, if necessary, filling it with EMPTY_SITE;
+  // SPECIES_ are all the other species that may be put on it
+  void initialize(model_species* empty_site,
+		  const model_species::seq& species_)
+    throw (bad_pointer, bad_value); // this
+  // return the index of the point at ROW and COLUMN
+  unsigned int get_point(unsigned int row, unsigned int column) const
     throw (bad_request, bad_value); // this
+  // return the row and column of the point at INDEX
+  CH_STD::pair<unsigned int,unsigned int> get_position(unsigned int index)
+    const;
+  // return the species at the point at INDEX
+  model_species* get_species(unsigned int index) const;
+  // return the id of the species at the point at INDEX
+  id get_species_id(unsigned int index) const;
+  // return the id of SPECIES_
+  id get_id(model_species* species_) const
+    throw (bad_pointer); // this
+  // return how many species (and so ids) the surface may hold
+  unsigned int get_id_count() const;
+  // change the species at the point at INDEX, return old
+  model_species* set_species(unsigned int index, model_species* species_)
+    throw (bad_pointer); // get_id()
   // create string representation of a picture of the surface
   CH_STD::string stringify(unsigned int width = 8U) const
     throw (bad_request, bad_value); // get_point()
+  // write the id in IDS of the species at each point, row by row, into
+  // SITES using WIDTH (1 or 2) bytes per point
+  void encode(const CH_STD::map<model_species*,unsigned int>& ids,
+	      unsigned int width, unsigned char* sites) const
+    throw (bad_request, bad_value); // this
 }; // end class lattice
 
+// inline functions
+// return the species at the point at INDEX
+inline model_species*
+lattice::get_species(unsigned int index) const
+{
+  return species[points[index]];
+}
+
+// return the id of the species at the point at INDEX
+inline lattice::id
+lattice::get_species_id(unsigned int index) const
+{
+  return points[index];
+}
+
 CH_END_NAMESPACE
 
 #endif // not CH_MODEL_LATTICE_H
@@ -0,0 +1,165 @@
+// Methods to recognize the ensembles of a mechanism on the surface.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "matcher.h"
+#include <algorithm>
+#include <limits>
+#include "environment.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// ensemble_matcher methods
+// ctor: set the surface the species ids are for
+ensemble_matcher::ensemble_matcher(const lattice* surface_)
+  : surface(surface_), bits(0U), max_size(0U), packed(false), keys(),
+    patterns()
+{}
+
+// dtor: do nothing
+ensemble_matcher::~ensemble_matcher()
+{}
+
+// ensemble_matcher public methods
+// forget all of the ensembles
+void
+ensemble_matcher::clear()
+{
+  keys.clear();
+  patterns.clear();
+  max_size = 0U;
+  packed = false;
+  // each point is stored as its id plus one, so groups of different
+  // sizes never have the same key
+  bits = 0U;
+  while ((1UL << bits) <= surface->get_id_count())
+    {
+      ++bits;
+    }
+  return;
+}
+
+// recognize ENS as the ensemble of type TYPE
+void
+ensemble_matcher::insert(const ensemble& ens, unsigned int type)
+  throw (bad_pointer)
+{
+  // put in the id of each species once for every point it covers
+  pattern ids;
+  for (model_species::seq_citer it(ens.begin()); it != ens.end(); ++it)
+    {
+      ids.insert(ids.end(), (*it)->get_surface_coordination(),
+		 surface->get_id(*it));
+    }
+  CH_STD::sort(ids.begin(), ids.end());
+  patterns.insert(CH_STD::make_pair(ids, type));
+  max_size = CH_STD::max(max_size, (unsigned int) ids.size());
+  return;
+}
+
+// pack the ensembles into keys, if they fit
+void
+ensemble_matcher::finish()
+{
+  keys.clear();
+  packed = (bits * max_size <= (unsigned int)
+	    CH_STD::numeric_limits<key>::digits);
+  if (!packed)
+    {
+      return;
+    }
+  for (CH_STD::map<pattern,unsigned int>::const_iterator
+	 it(patterns.begin()); it != patterns.end(); ++it)
+    {
+      key k(0UL);
+      for (pattern::const_iterator pit(it->first.begin());
+	   pit != it->first.end(); ++pit)
+	{
+	  k = (k << bits) | (*pit + 1UL);
+	}
+      keys.push_back(CH_STD::make_pair(k, it->second));
+    }
+  CH_STD::sort(keys.begin(), keys.end());
+  return;
+}
+
+// return the type of ensemble the species on the points of the
+// environments from BEGIN to END make, or ensemble::npos
+/* This is done for every group of sites around every point changed by
+ * an event, and most groups make none of the ensembles of the
+ * mechanism, so it works on the ids in place: they are read into an
+ * array, put in order by insertion (groups are small), and packed.
+ */
+unsigned int
+ensemble_matcher::find(CH_STD::vector<environment*>::const_iterator begin,
+		       CH_STD::vector<environment*>::const_iterator end) const
+{
+  unsigned int size(end - begin);
+  if (size > max_size)
+    {
+      return ensemble::npos;
+    }
+  if (!packed)
+    {
+      // compare the sequence of ids
+      pattern ids;
+      ids.reserve(size);
+      for (; begin != end; ++begin)
+	{
+	  ids.push_back(surface->get_species_id((*begin)->get_index()));
+	}
+      CH_STD::sort(ids.begin(), ids.end());
+      CH_STD::map<pattern,unsigned int>::const_iterator it(patterns.find(ids));
+      return (it == patterns.end()) ? ensemble::npos : it->second;
+    }
+  // else the group is no larger than the largest ensemble, so it fits
+  lattice::id ids[CH_STD::numeric_limits<key>::digits];
+  for (unsigned int i(0U); i < size; ++i, ++begin)
+    {
+      lattice::id id(surface->get_species_id((*begin)->get_index()));
+      unsigned int j(i);
+      for (; j > 0U && ids[j - 1U] > id; --j)
+	{
+	  ids[j] = ids[j - 1U];
+	}
+      ids[j] = id;
+    }
+  key k(0UL);
+  for (unsigned int i(0U); i < size; ++i)
+    {
+      k = (k << bits) | (ids[i] + 1UL);
+    }
+  CH_STD::vector<CH_STD::pair<key,unsigned int> >::const_iterator
+    it(CH_STD::lower_bound(keys.begin(), keys.end(),
+			   CH_STD::make_pair(k, 0U)));
+  if (it == keys.end() || it->first != k)
+    {
+      return ensemble::npos;
+    }
+  return it->second;
+}
+
+CH_END_NAMESPACE
+
+/* $Id$ */
@@ -0,0 +1,92 @@
+// -*- C++ -*-
+// Class to recognize the ensembles of a mechanism on the surface.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_MODEL_MATCHER_H
+#define CH_MODEL_MATCHER_H 1
+
+#include <map>
+#include <utility>
+#include <vector>
+#include "ensemble.h"
+#include "except.h"
+#include "lattice.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// defined in environment.h
+class environment;
+
+// the ensembles the reactions of a mechanism need, as the species ids
+// their points hold on a surface
+//
+// An ensemble is recognized by the lattice ids of the species on each
+// point of a group of sites (a species covering several points counts
+// once for each), sorted and packed into one integer key, so a group
+// is tested by reading its ids and comparing integers rather than by
+// building and comparing sequences of species.  Should a mechanism have
+// too many species, or too large ensembles, for that, the sorted ids
+// are compared as sequences instead.
+class ensemble_matcher
+{
+public:
+  // set up typedef's
+  typedef unsigned long int key; // packed ids of the points of a group
+  typedef CH_STD::vector<lattice::id> pattern; // sorted ids of the points
+
+private:
+  const lattice* surface;	// surface the ids are for
+  unsigned int bits;		// bits each point takes in a key
+  unsigned int max_size;	// most points any ensemble covers
+  bool packed;			// do the patterns all fit in keys
+  // key of each ensemble and its type, in order of key
+  CH_STD::vector<CH_STD::pair<key,unsigned int> > keys;
+  CH_STD::map<pattern,unsigned int> patterns; // type of each ensemble
+
+private:
+  // prevent copy construction and assignment
+  ensemble_matcher(const ensemble_matcher&);
+  ensemble_matcher& operator=(const ensemble_matcher&);
+public:
+  // ctor: set the surface the species ids are for
+  explicit ensemble_matcher(const lattice* surface_);
+  // dtor: do nothing
+  ~ensemble_matcher();
+
+  // forget all of the ensembles (done before inserting them again)
+  void clear();
+  // recognize ENS as the ensemble of type TYPE, call finish() after
+  void insert(const ensemble& ens, unsigned int type)
+    throw (bad_pointer);	// lattice::get_id()
+  // pack the ensembles into keys, if they fit, after inserting them
+  void finish();
+  // return the type of ensemble the species on the points of the
+  // environments from BEGIN to END make (each point once, a species
+  // covering several all of them) or ensemble::npos if none
+  unsigned int find(CH_STD::vector<environment*>::const_iterator begin,
+		    CH_STD::vector<environment*>::const_iterator end) const;
+}; // end class ensemble_matcher
+
+CH_END_NAMESPACE
+
+#endif // not CH_MODEL_MATCHER_H
+
+/* $Id$ */
@@ -0,0 +1,860 @@
+// Methods for the mean-field integration of the reactor equations.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "ode.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "compare.h"
+#include "debug.h"
+#include "precision.h"
+#include "quantity.h"
+#include "reaction.h"
+#include "reactor.h"
+#include "t_string.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// static instance variables
+const unsigned int ode::order_limit = 5U;
+const double ode::sums[] = { 1.0e0, 3.0e0 / 2.0e0, 11.0e0 / 6.0e0,
+			     25.0e0 / 12.0e0, 137.0e0 / 60.0e0 };
+const unsigned int ode::newton_iterations = 4U;
+
+// ode methods
+// ctor: (default) set the default tolerances
+ode::ode()
+  : integrator(), relative_tolerance(1.0e-6), absolute_tolerance(1.0e-10),
+    initial_step(0.0e0), max_step(0.0e0), max_order(order_limit), species(),
+    started(false), x(0.0e0), y(), T0(0.0e0), ramp_x(0.0e0), h(0.0e0),
+    h_last(0.0e0), k(1U), constant_steps(0U), differences(), weights(),
+    error(0.0e0), rates(), jacobian(), jacobian_current(false), iteration(),
+    matrix(), factored(0.0e0), rate(0.0e0), have_rate(false), steps(0U),
+    failed_steps(0U), evaluations(0U), jacobians(0U), factorizations(0U)
+{}
+
+// ctor: copy the tolerances (the solution is set up by initialize())
+ode::ode(const ode& o)
+  throw (bad_pointer)
+  : integrator(o), relative_tolerance(o.relative_tolerance),
+    absolute_tolerance(o.absolute_tolerance), initial_step(o.initial_step),
+    max_step(o.max_step), max_order(o.max_order), species(), started(false),
+    x(0.0e0), y(), T0(0.0e0), ramp_x(0.0e0), h(0.0e0), h_last(0.0e0), k(1U),
+    constant_steps(0U), differences(), weights(), error(0.0e0), rates(),
+    jacobian(), jacobian_current(false), iteration(), matrix(), factored(0.0e0),
+    rate(0.0e0), have_rate(false), steps(0U), failed_steps(0U),
+    evaluations(0U), jacobians(0U), factorizations(0U)
+{}
+
+// dtor: do nothing
+ode::~ode()
+{}
+
+// ode private methods
+// set up the variables and tolerances
+void
+ode::initialize()
+  throw (bad_pointer, bad_input, bad_value, bad_type, bad_request,
+	 bad_file)
+{
+  // call the base class initializer
+  integrator::initialize();
+  reactor* rctr(state_info->get_reactor());
+  // only the batch reactor has its design equations
+  if (dynamic_cast<flow_reactor*>(rctr) != 0)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":ode::initialize(): the ode integrator can only "
+			"integrate the equations of a batch reactor");
+    }
+  // every species of the mechanism is a variable
+  species.assign(mech->species_seq_begin(), mech->species_seq_end());
+  unsigned int n(species.size());
+  // the sites not covered by the initial coverages are empty (the
+  // quantity of a surface species is its coverage, whatever the type)
+  model_species* empty(mech->get_species("@"));
+  if (empty != 0 && !state_info->get_previous_values())
+    {
+      double covered(0.0e0);
+      for (model_species::seq_citer it(species.begin());
+	   it != species.end(); ++it)
+	{
+	  if (*it != empty)
+	    {
+	      covered += (*it)->get_surface_coordination()
+		* (*it)->get_quantity(quantity::Econcentration);
+	    }
+	}
+      empty->set_quantity(quantity::Econcentration,
+			  CH_STD::max(1.0e0 - covered, 0.0e0));
+    }
+  y.resize(n);
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      // surface species ignore the type and give their coverage
+      y[i] = species[i]->get_quantity(rctr->get_fluid_type());
+    }
+  x = x0;
+  // a ramp starts from the temperature the reactor was given
+  T0 = rctr->get_temperature();
+  ramp_x = x0;
+  started = false;
+  k = 1U;
+  constant_steps = 0U;
+  differences.assign(max_order + 2U, CH_STD::vector<double>(n, 0.0e0));
+  weights.assign(n, 1.0e0);
+  error = 0.0e0;
+  // the patterns of the jacobian and its factors are found once
+  rates.analyze(species, mech->reaction_seq_begin(), mech->reaction_seq_end());
+  iteration.analyze(rates.get_row_start(), rates.get_columns());
+  jacobian.assign(rates.get_columns().size(), 0.0e0);
+  jacobian_current = false;
+  matrix.assign(jacobian.size(), 0.0e0);
+  factored = 0.0e0;
+  have_rate = false;
+  steps = 0U;
+  failed_steps = 0U;
+  evaluations = 0U;
+  jacobians = 0U;
+  factorizations = 0U;
+  return;
+}
+
+// step from XI until the output point XF, interpolate to it, return XF
+double
+ode::step(double /* xi */, double xf)
+  throw (bad_pointer, bad_value, bad_type)
+{
+  if (!started)
+    {
+      // find the derivatives and jacobian at the start
+      CH_STD::vector<double> slopes(y.size());
+      derivatives(x, y, slopes);
+      find_jacobian();
+      // take the first step to the output point, unless the
+      // derivatives say the quantities change much faster
+      double threshold(absolute_tolerance / relative_tolerance);
+      h = xf - x;
+      if (max_step > 0.0e0)
+	{
+	  h = CH_STD::min(h, max_step);
+	}
+      if (initial_step > 0.0e0)
+	{
+	  h = CH_STD::min(h, initial_step);
+	}
+      else
+	{
+	  double change(0.0e0);
+	  for (unsigned int i(0U); i < y.size(); ++i)
+	    {
+	      double size(CH_STD::max(CH_STD::fabs(y[i]), threshold));
+	      change = CH_STD::max(change, CH_STD::fabs(slopes[i]) / size);
+	    }
+	  change *= 1.25e0 / CH_STD::sqrt(relative_tolerance);
+	  if (h * change > 1.0e0)
+	    {
+	      h = 1.0e0 / change;
+	    }
+	}
+      h = CH_STD::max(h, 16.0e0 * CH_STD::numeric_limits<double>::epsilon()
+		      * CH_STD::fabs(x));
+      h_last = h;
+      k = 1U;
+      for (unsigned int i(0U); i < y.size(); ++i)
+	{
+	  differences[0][i] = h * slopes[i];
+	}
+      started = true;
+    }
+  // step past the output point
+  while (x < xf)
+    {
+      advance();
+    }
+  // and put the solution there into the species
+  CH_STD::vector<double> values;
+  interpolate(xf, values);
+  set_values(xf, values);
+  return xf;
+}
+
+// output the column headings, followed by that of the steps
+void
+ode::output_header()
+{
+  // call base class method
+  integrator::output_header();
+  // output header for the steps
+  *out_file << "\tsteps" << CH_STD::endl;
+  return;
+}
+
+// output the current output point and its values to *out_file
+void
+ode::output(double x_)
+  throw (bad_type, bad_request, bad_value, bad_file)
+{
+  output(x_, *out_file);
+  return;
+}
+
+// output the current output point, its values and the steps taken
+void
+ode::output(double x_, CH_STD::ostream& output_stream)
+  throw (bad_type, bad_request, bad_value, bad_file)
+{
+  // call base class method
+  integrator::output(x_, output_stream);
+  // output the number of steps
+  output_stream << '\t' << steps << '\n';
+  return;
+}
+
+// report the work done, if debugging
+void
+ode::finish()
+  throw (bad_file)
+{
+  if (debug::get().get_level() > 0U)
+    {
+      debug::get().get_stream() << "ode: " << steps << " steps ("
+				<< failed_steps << " failed), " << evaluations
+				<< " evaluations, " << jacobians
+				<< " jacobians, " << factorizations
+				<< " factorizations (" << jacobian.size()
+				<< " nonzeros, "
+				<< iteration.get_factor_nonzeros()
+				<< " in the factors)" << CH_STD::endl;
+    }
+  return;
+}
+
+// put the quantities VALUES at X_ into the species and reactor
+/* An iterate may stray a little past the range a quantity can have (a
+ * coverage just below zero, say), so each is kept in range; the
+ * solution itself is not changed.
+ */
+void
+ode::set_values(double x_, const CH_STD::vector<double>& values)
+  throw (bad_value, bad_type)
+{
+  reactor* rctr(state_info->get_reactor());
+  if (CH_STD::fabs(rctr->get_heating_rate()) > precision::get().get_double())
+    {
+      rctr->ramp_temperature(T0, x_ - ramp_x);
+    }
+  quantity::type type(rctr->get_fluid_type());
+  for (unsigned int i(0U); i < species.size(); ++i)
+    {
+      double value(CH_STD::max(values[i], 0.0e0));
+      if (species[i]->get_surface_coordination() > 0U)
+	{
+	  value = CH_STD::min(value, 1.0e0);
+	}
+      species[i]->set_quantity(type, value);
+    }
+  return;
+}
+
+// put the derivatives of the quantities VALUES at X_ into SLOPES
+void
+ode::derivatives(double x_, const CH_STD::vector<double>& values,
+		 CH_STD::vector<double>& slopes)
+  throw (bad_pointer, bad_value, bad_type)
+{
+  ++evaluations;
+  set_values(x_, values);
+  // add up the rates of the reactions of each species
+  reactor* rctr(state_info->get_reactor());
+  mech->get_kernel().rate_derivatives(rctr->get_temperature());
+  // and put them in the units of the reactor
+  for (unsigned int i(0U); i < species.size(); ++i)
+    {
+      slopes[i] = rctr->reactor_eqn(species[i]);
+    }
+  return;
+}
+
+// find the jacobian at the current point
+/* The design equations scale the rate of change of each species and
+ * may add a term in its quantity, so each row of the jacobian of the
+ * rates is scaled and its diagonal added to.
+ */
+void
+ode::find_jacobian()
+  throw (bad_pointer, bad_value, bad_type)
+{
+  ++jacobians;
+  // put the quantities and temperature at the current point
+  set_values(x, y);
+  reactor* rctr(state_info->get_reactor());
+  rates.evaluate(rctr->get_temperature());
+  const rate_jacobian::index_seq& row_start(rates.get_row_start());
+  const rate_jacobian::index_seq& diagonal(rates.get_diagonal());
+  const CH_STD::vector<double>& values(rates.get_values());
+  for (unsigned int i(0U); i < species.size(); ++i)
+    {
+      double quantity_slope(0.0e0);
+      double slope(rctr->reactor_eqn_slope(species[i], quantity_slope));
+      for (unsigned int p(row_start[i]); p < row_start[i + 1U]; ++p)
+	{
+	  jacobian[p] = slope * values[p];
+	}
+      jacobian[diagonal[i]] += quantity_slope;
+    }
+  jacobian_current = true;
+  // the iteration matrix must be made again
+  factored = 0.0e0;
+  return;
+}
+
+// factor the iteration matrix, return false if it is singular
+bool
+ode::factor()
+{
+  ++factorizations;
+  double hg(h / sums[k - 1U]);
+  for (unsigned int p(0U); p < jacobian.size(); ++p)
+    {
+      matrix[p] = - hg * jacobian[p];
+    }
+  const rate_jacobian::index_seq& diagonal(rates.get_diagonal());
+  for (unsigned int i(0U); i < diagonal.size(); ++i)
+    {
+      matrix[diagonal[i]] += 1.0e0;
+    }
+  if (!iteration.factor(matrix))
+    {
+      factored = 0.0e0;
+      return false;
+    }
+  factored = hg;
+  // the convergence rate was for the old matrix
+  have_rate = false;
+  return true;
+}
+
+// return the largest of the magnitudes of VALUES times the weights
+double
+ode::norm(const CH_STD::vector<double>& values) const
+{
+  double largest(0.0e0);
+  for (unsigned int i(0U); i < values.size(); ++i)
+    {
+      largest = CH_STD::max(largest, CH_STD::fabs(values[i] * weights[i]));
+    }
+  return largest;
+}
+
+// change the differences from step size h_last to h
+/* The differences at the new step size are those of the polynomial
+ * through the old ones, D' = D R U, where R_ij is the product over m up
+ * to i of (m - 1 - j h / h_last) / m and U_ij is (-1)^i times the
+ * binomial coefficient (j i) (i and j counted from one).
+ */
+void
+ode::rescale()
+{
+  double ratio(h / h_last);
+  double ru[order_limit][order_limit];
+  for (unsigned int i(0U); i < k; ++i)
+    {
+      for (unsigned int j(0U); j < k; ++j)
+	{
+	  ru[i][j] = 0.0e0;
+	  // (j + 1 choose l + 1), starting from l = 0
+	  double binomial(j + 1.0e0);
+	  for (unsigned int l(0U); l <= j; ++l)
+	    {
+	      double r(1.0e0);
+	      for (unsigned int m(1U); m <= i + 1U; ++m)
+		{
+		  r *= (m - 1.0e0 - (l + 1.0e0) * ratio) / m;
+		}
+	      ru[i][j] += r * ((l % 2U == 0U) ? -binomial : binomial);
+	      // next binomial coefficient along the row
+	      binomial *= (j - l) / (l + 2.0e0);
+	    }
+	}
+    }
+  unsigned int n(y.size());
+  CH_STD::vector<double> old(k);
+  for (unsigned int e(0U); e < n; ++e)
+    {
+      for (unsigned int i(0U); i < k; ++i)
+	{
+	  old[i] = differences[i][e];
+	}
+      for (unsigned int j(0U); j < k; ++j)
+	{
+	  double sum(0.0e0);
+	  for (unsigned int i(0U); i < k; ++i)
+	    {
+	      sum += old[i] * ru[i][j];
+	    }
+	  differences[j][e] = sum;
+	}
+    }
+  h_last = h;
+  constant_steps = 0U;
+  return;
+}
+
+// choose the size and order of the next step after the last one
+/* The step size each of the orders next to the last one could take is
+ * estimated from its error, favoring the current order, and the order
+ * allowing the largest step chosen, but only after enough steps at the
+ * current size and order for the estimates to be good.
+ */
+void
+ode::adapt()
+{
+  constant_steps = CH_STD::min(constant_steps + 1U, max_order + 2U);
+  if (constant_steps >= k + 2U)
+    {
+      double temp(1.2e0 * CH_STD::pow(error / relative_tolerance,
+				      1.0e0 / (k + 1.0e0)));
+      double h_best((temp > 0.1e0) ? h / temp : 10.0e0 * h);
+      unsigned int k_best(k);
+      if (k > 1U)
+	{
+	  double lower_error(norm(differences[k - 1U]) / k);
+	  temp = 1.3e0 * CH_STD::pow(lower_error / relative_tolerance,
+				     1.0e0 / k);
+	  double h_lower((temp > 0.1e0) ? h / temp : 10.0e0 * h);
+	  if (h_lower > h_best)
+	    {
+	      // do not increase the step size while lowering the order
+	      h_best = CH_STD::min(h, h_lower);
+	      k_best = k - 1U;
+	    }
+	}
+      if (k < max_order)
+	{
+	  double higher_error(norm(differences[k + 1U]) / (k + 2.0e0));
+	  temp = 1.4e0 * CH_STD::pow(higher_error / relative_tolerance,
+				     1.0e0 / (k + 2.0e0));
+	  double h_higher((temp > 0.1e0) ? h / temp : 10.0e0 * h);
+	  if (h_higher > h_best)
+	    {
+	      h_best = h_higher;
+	      k_best = k + 1U;
+	    }
+	}
+      if (h_best > h)
+	{
+	  h = h_best;
+	  k = k_best;
+	}
+    }
+  if (max_step > 0.0e0)
+    {
+      h = CH_STD::min(h, max_step);
+    }
+  if (h != h_last)
+    {
+      rescale();
+    }
+  return;
+}
+
+// take one step, retrying at smaller sizes until one is accepted
+void
+ode::advance()
+  throw (bad_pointer, bad_value, bad_type)
+{
+  // the last step decides this one
+  if (steps > 0U)
+    {
+      adapt();
+    }
+  unsigned int n(y.size());
+  double threshold(absolute_tolerance / relative_tolerance);
+  double epsilon(CH_STD::numeric_limits<double>::epsilon());
+  double h_min(16.0e0 * epsilon * CH_STD::fabs(x));
+  CH_STD::vector<double> predicted(n);
+  CH_STD::vector<double> psi(n);
+  CH_STD::vector<double> correction(n);
+  CH_STD::vector<double> values(n);
+  CH_STD::vector<double> slopes(n);
+  CH_STD::vector<double> change(n);
+  unsigned int failures(0U);
+  while (true)
+    {
+      double hg(h / sums[k - 1U]);
+      if (factored != hg && !factor())
+	{
+	  // the matrix tends to the identity as the step shrinks
+	  if (h <= h_min)
+	    {
+	      throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":ode::advance(): the iteration matrix is "
+			      "singular at the smallest step size at x = "
+			      + t_string(x));
+	    }
+	  ++failed_steps;
+	  h = CH_STD::max(0.3e0 * h, h_min);
+	  rescale();
+	  continue;		// while (true)
+	}
+      double x_new(x + h);
+      // predict the solution from the differences
+      for (unsigned int i(0U); i < n; ++i)
+	{
+	  predicted[i] = y[i];
+	  psi[i] = 0.0e0;
+	  for (unsigned int j(0U); j < k; ++j)
+	    {
+	      predicted[i] += differences[j][i];
+	      psi[i] += differences[j][i] * sums[j];
+	    }
+	  psi[i] /= sums[k - 1U];
+	  double size(CH_STD::max(CH_STD::fabs(y[i]),
+				  CH_STD::fabs(predicted[i])));
+	  weights[i] = 1.0e0 / CH_STD::max(size, threshold);
+	  correction[i] = 0.0e0;
+	  values[i] = predicted[i];
+	}
+      double min_norm(100.0e0 * epsilon * norm(predicted));
+      // correct it by newton iterations
+      bool converged(false);
+      double old_norm(0.0e0);
+      for (unsigned int iter(0U); iter < newton_iterations; ++iter)
+	{
+	  derivatives(x_new, values, slopes);
+	  for (unsigned int i(0U); i < n; ++i)
+	    {
+	      change[i] = hg * slopes[i] - (psi[i] + correction[i]);
+	    }
+	  iteration.solve(change);
+	  double new_norm(norm(change));
+	  for (unsigned int i(0U); i < n; ++i)
+	    {
+	      correction[i] += change[i];
+	      values[i] = predicted[i] + correction[i];
+	    }
+	  if (new_norm <= min_norm)
+	    {
+	      converged = true;
+	      break;		// for (iter)
+	    }
+	  else if (iter == 0U)
+	    {
+	      if (have_rate)
+		{
+		  // stricter when using the rate of an earlier step
+		  if (new_norm * rate / (1.0e0 - rate)
+		      <= 0.05e0 * relative_tolerance)
+		    {
+		      converged = true;
+		      break;	// for (iter)
+		    }
+		}
+	      else
+		{
+		  rate = 0.0e0;
+		}
+	    }
+	  else if (new_norm > 0.9e0 * old_norm)
+	    {
+	      break;		// for (iter), too slow
+	    }
+	  else
+	    {
+	      rate = CH_STD::max(0.9e0 * rate, new_norm / old_norm);
+	      have_rate = true;
+	      double left(new_norm * rate / (1.0e0 - rate));
+	      if (left <= 0.5e0 * relative_tolerance)
+		{
+		  converged = true;
+		  break;	// for (iter)
+		}
+	      else if (0.5e0 * relative_tolerance
+		       < left * CH_STD::pow(rate, (double)
+					    (newton_iterations - 1U - iter)))
+		{
+		  break;	// for (iter), will not converge in time
+		}
+	    }
+	  old_norm = new_norm;
+	}
+      if (!converged)
+	{
+	  // try again with a new jacobian, then with a smaller step
+	  if (!jacobian_current)
+	    {
+	      find_jacobian();
+	      continue;		// while (true)
+	    }
+	  if (h <= h_min)
+	    {
+	      throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":ode::advance(): the newton iterations do "
+			      "not converge at the smallest step size at x = "
+			      + t_string(x));
+	    }
+	  ++failed_steps;
+	  h = CH_STD::max(0.3e0 * h, h_min);
+	  rescale();
+	  continue;		// while (true)
+	}
+      // estimate the error
+      for (unsigned int i(0U); i < n; ++i)
+	{
+	  weights[i] = 1.0e0 / CH_STD::max(CH_STD::max(CH_STD::fabs(y[i]),
+						       CH_STD::fabs(values[i])),
+					   threshold);
+	}
+      error = norm(correction) / (k + 1.0e0);
+      if (error > relative_tolerance)
+	{
+	  if (h <= h_min)
+	    {
+	      throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":ode::advance(): the error is too large at the "
+			      "smallest step size at x = " + t_string(x));
+	    }
+	  ++failed_steps;
+	  ++failures;
+	  if (failures == 1U)
+	    {
+	      double shrink(0.833e0 * CH_STD::pow(relative_tolerance / error,
+						  1.0e0 / (k + 1.0e0)));
+	      double h_new(CH_STD::max(h_min,
+				       h * CH_STD::max(0.1e0, shrink)));
+	      if (k > 1U)
+		{
+		  // see if a lower order would do better
+		  for (unsigned int i(0U); i < n; ++i)
+		    {
+		      change[i] = differences[k - 1U][i] + correction[i];
+		    }
+		  double lower_error(norm(change) / k);
+		  double lower_shrink(0.769e0
+				      * CH_STD::pow(relative_tolerance
+						    / lower_error, 1.0e0 / k));
+		  double h_lower(CH_STD::max(h_min,
+					     h * CH_STD::max(0.1e0,
+							     lower_shrink)));
+		  if (h_lower > h_new)
+		    {
+		      h_new = CH_STD::min(h, h_lower);
+		      --k;
+		    }
+		}
+	      h = h_new;
+	    }
+	  else
+	    {
+	      h = CH_STD::max(h_min, 0.5e0 * h);
+	    }
+	  rescale();
+	  continue;		// while (true)
+	}
+      // accept the step and update the differences
+      ++steps;
+      for (unsigned int i(0U); i < n; ++i)
+	{
+	  differences[k + 1U][i] = correction[i] - differences[k][i];
+	  differences[k][i] = correction[i];
+	  for (unsigned int j(k); j-- > 0U;)
+	    {
+	      differences[j][i] += differences[j + 1U][i];
+	    }
+	}
+      x = x_new;
+      y.swap(values);
+      jacobian_current = false;
+      return;
+    }
+}
+
+// put the quantities interpolated to X_ into VALUES
+/* The differences of the last step give the polynomial through its
+ * solution and those before, y + sum of D_j times the product over m up
+ * to j of (s + m - 1) / m, s being the distance back in steps.
+ */
+void
+ode::interpolate(double x_, CH_STD::vector<double>& values) const
+{
+  values = y;
+  double s((x_ - x) / h);
+  double product(1.0e0);
+  for (unsigned int j(0U); j < k; ++j)
+    {
+      product *= (s + j) / (j + 1.0e0);
+      for (unsigned int i(0U); i < values.size(); ++i)
+	{
+	  values[i] += differences[j][i] * product;
+	}
+    }
+  return;
+}
+
+// ode public methods
+// parse integrator input
+void
+ode::parse(token_seq_citer& token_it, token_seq_citer end)
+  throw (bad_input, bad_request, bad_value, bad_type, bad_pointer)
+{
+  // loop through input
+  while (token_it != end)
+    {
+      if (icompare(*token_it, "begin") == 0)
+	{
+	  ++token_it;		// next token
+	  if (icompare(*token_it, "state") == 0)
+	    {
+	      // call the state parser
+	      state_info->parse(++token_it, end);
+	      continue;		// while ()
+	    }
+	  else
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":ode::parse(): syntax error in input "
+			      "for integrator: do not know how to begin "
+			      + *token_it);
+	    }
+	}
+      // set the relative error allowed each step
+      else if (icompare(*token_it, "relative_tolerance") == 0)
+	{
+	  relative_tolerance = CH_STD::atof((++token_it)->c_str());
+	  if (!(relative_tolerance > 0.0e0))
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":ode::parse(): syntax error in input "
+			      "for integrator: relative tolerance must be "
+			      "positive: " + *token_it);
+	    }
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set the error allowed for quantities near zero
+      else if (icompare(*token_it, "absolute_tolerance") == 0)
+	{
+	  absolute_tolerance = CH_STD::atof((++token_it)->c_str());
+	  if (!(absolute_tolerance > 0.0e0))
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":ode::parse(): syntax error in input "
+			      "for integrator: absolute tolerance must be "
+			      "positive: " + *token_it);
+	    }
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set the size of the first step
+      else if (icompare(*token_it, "initial_step") == 0)
+	{
+	  initial_step = CH_STD::atof((++token_it)->c_str());
+	  if (initial_step < 0.0e0)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":ode::parse(): syntax error in input "
+			      "for integrator: initial step can not be "
+			      "negative: " + *token_it);
+	    }
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set the largest step size
+      else if (icompare(*token_it, "max_step") == 0)
+	{
+	  max_step = CH_STD::atof((++token_it)->c_str());
+	  if (max_step < 0.0e0)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":ode::parse(): syntax error in input "
+			      "for integrator: maximum step can not be "
+			      "negative: " + *token_it);
+	    }
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set the highest order of formula
+      else if (icompare(*token_it, "max_order") == 0)
+	{
+	  int order(CH_STD::atoi((++token_it)->c_str()));
+	  if (order < 1 || order > (int) order_limit)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":ode::parse(): syntax error in input "
+			      "for integrator: maximum order must be from 1 "
+			      "to " + t_string(order_limit) + ": " + *token_it);
+	    }
+	  max_order = (unsigned int) order;
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      else if (icompare(*token_it, "end") == 0)
+	{
+	  // make sure it is the end of integrator input
+	  if (icompare(*++token_it, "integrator") != 0)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":ode::parse(): syntax error in input "
+			      "for integrator: corresponding end token does "
+			      "not end an integrator: " + *token_it);
+	    }
+	  // increment one further
+	  ++token_it;
+	  // return to caller
+	  return;
+	}
+      else
+	{
+	  throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			  ":ode::parse(): syntax error in input "
+			  "for integrator: unrecognized token: "
+			  + *token_it);
+	}
+    }
+  // end of file reached
+  throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		  "ode::parse(): syntax error in input for integrator: "
+		  "end of file reached while parsing input");
+  // shouldn't get here
+  return;
+}
+
+// create a copy of this ode integrator, return pointer to it
+integrator*
+ode::copy() const
+  throw (bad_pointer)
+{
+  return new ode(*this);
+}
+
+CH_END_NAMESPACE
+
+/* $Id$ */
@@ -0,0 +1,166 @@
+// -*- C++ -*-
+// Mean-field integration of the reactor equations of a mechanism.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_MODEL_ODE_H
+#define CH_MODEL_ODE_H 1
+
+#include <vector>
+#include "except.h"
+#include "integrate.h"
+#include "jacobian.h"
+#include "sparse.h"
+#include "species.h"
+#include "token.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// class for the integration of the mean-field rate equations
+//
+// The quantity of every species changes as the sum of the net rates of
+// its reactions, put in the units of the reactor by its design
+// equations.  Surface chemistry is stiff (adsorption and desorption are
+// many orders of magnitude faster than the surface reactions), so the
+// equations are integrated by the backward differentiation formulas of
+// orders one to five, choosing the order and step size to keep the
+// error estimate within the tolerances.  The formulas are kept as the
+// backward differences of the solution at a constant step size, changed
+// by interpolation when the step size changes (Shampine and Reichelt,
+// ``The MATLAB ODE suite,'' SIAM J. Sci. Comput. 18, 1 (1997)), and the
+// output points are interpolated rather than stepped to.  The newton
+// iterations use the jacobian found from the stoichiometry (see
+// rate_jacobian), kept sparse, as are the factors of their matrix.
+class ode : public integrator
+{
+  double relative_tolerance;	// error allowed relative to each quantity
+  double absolute_tolerance;	// error allowed for quantities near zero
+  double initial_step;		// first step size (0 to choose one)
+  double max_step;		// largest step size (0 for no limit)
+  unsigned int max_order;	// highest order formula used
+  model_species::seq species;	// species whose quantities are integrated
+  bool started;			// has the first step size been chosen
+  double x;			// independent variable the solution is at
+  CH_STD::vector<double> y;	// quantities at x
+  double T0;			// temperature at the start of a ramp
+  double ramp_x;		// independent variable at the start of a ramp
+  double h;			// size of the last (or next) step
+  double h_last;		// size the differences are for
+  unsigned int k;		// order of the last (or next) step
+  unsigned int constant_steps;	// steps taken at the current h and k
+  // backward differences of the solution (times the step size)
+  CH_STD::vector<CH_STD::vector<double> > differences;
+  CH_STD::vector<double> weights; // inverse error weights of the last step
+  double error;			// scaled error estimate of the last step
+  rate_jacobian rates;		// jacobian of the rates of the reactions
+  CH_STD::vector<double> jacobian; // of the equations, in the rates pattern
+  bool jacobian_current;	// was the jacobian found at the current x
+  sparse_lu iteration;		// LU factors of I - h / G_k J
+  CH_STD::vector<double> matrix; // I - h / G_k J, in the rates pattern
+  double factored;		// h / G_k the matrix is for (0 if none)
+  double rate;			// rate the newton iterations converge at
+  bool have_rate;		// has the rate been found for this matrix
+  unsigned int steps;		// steps taken
+  unsigned int failed_steps;	// steps rejected
+  unsigned int evaluations;	// times the derivatives were found
+  unsigned int jacobians;	// times the jacobian was found
+  unsigned int factorizations;	// times the iteration matrix was factored
+  static const unsigned int order_limit; // highest order of the formulas
+  static const double sums[];	// G_k, the sum of 1 / j for j up to k
+  static const unsigned int newton_iterations; // most iterations per step
+
+private:
+  // prevent assignment
+  ode& operator=(const ode&);
+  // ctor: copy
+  explicit ode(const ode& original)
+    throw (bad_pointer); // integrator::integrator()
+  // set up the variables and tolerances
+  virtual void initialize()
+    throw (bad_pointer, bad_input, bad_value, bad_type, bad_request,
+	   bad_file); // this, integrator::initialize()
+  // step from XI until the output point XF, interpolate to it, and
+  // return XF
+  virtual double step(double xi, double xf)
+    throw (bad_pointer, bad_value, bad_type); // this, advance(),
+				// derivatives(), set_values()
+  // output the column headings, followed by that of the steps
+  virtual void output_header();
+  // output the current output point and its values to *out_file
+  virtual void output(double x_)
+    throw (bad_type, bad_request, bad_value, bad_file); // output()
+  // output the current output point, its values and the steps taken to
+  // the stream
+  virtual void output(double x_, CH_STD::ostream& output_stream)
+    throw (bad_type, bad_request, bad_value, bad_file);
+				// integrator::output()
+  // report the work done, if debugging
+  virtual void finish()
+    throw (bad_file);
+  // put the quantities VALUES at X into the species and reactor
+  void set_values(double x_, const CH_STD::vector<double>& values)
+    throw (bad_value, bad_type); // reactor::ramp_temperature(),
+				// model_species::set_quantity()
+  // put the derivatives of the quantities VALUES at X_ into SLOPES
+  void derivatives(double x_, const CH_STD::vector<double>& values,
+		   CH_STD::vector<double>& slopes)
+    throw (bad_pointer, bad_value, bad_type); // set_values(),
+				// rate_kernel::rate_derivatives(),
+				// reactor::reactor_eqn()
+  // find the jacobian at the current point
+  void find_jacobian()
+    throw (bad_pointer, bad_value, bad_type); // set_values(),
+				// rate_jacobian::evaluate(),
+				// reactor::reactor_eqn_slope()
+  // factor the iteration matrix for the current step size and order,
+  // return false if it is singular
+  bool factor();
+  // return the largest of the magnitudes of VALUES times the weights
+  double norm(const CH_STD::vector<double>& values) const;
+  // change the differences from step size h_last to h
+  void rescale();
+  // choose the size and order of the next step after the last one
+  void adapt();
+  // take one step, retrying at smaller sizes until one is accepted
+  void advance()
+    throw (bad_pointer, bad_value, bad_type); // this, derivatives(),
+				// find_jacobian()
+  // put the quantities interpolated to X_ into VALUES
+  void interpolate(double x_, CH_STD::vector<double>& values) const;
+public:
+  // ctor: (default) set the default tolerances
+  ode();
+  // dtor: do nothing
+  virtual ~ode();
+
+  // parse integrator input
+  virtual void parse(token_seq_citer& token_it, token_seq_citer end)
+    throw (bad_input, bad_request, bad_value, bad_type, bad_pointer); // this,
+				// state::parse()
+  // create a copy of this ode integrator, return pointer to it
+  virtual integrator* copy() const
+    throw (bad_pointer); // ode()
+}; // end class ode
+
+CH_END_NAMESPACE
+
+#endif // not CH_MODEL_ODE_H
+
+/* $Id$ */
@@ -0,0 +1,261 @@
+// Methods to list the ways reaction products can be put on a group of sites.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "placement.h"
+#include <algorithm>
+#include "ensemble.h"
+#include "environment.h"
+#include "t_string.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// static instance variables
+const unsigned int placement_table::npos = ~0U;
+
+// placement_table::name_less methods
+// return true if LEFT has a name before that of RIGHT
+bool
+placement_table::name_less::operator()(const model_species* left,
+				       const model_species* right) const
+{
+  return left->get_name() < right->get_name();
+}
+
+// placement_table methods
+// ctor: (default) create an empty table
+placement_table::placement_table()
+  : shapes()
+{}
+
+// dtor: do nothing
+placement_table::~placement_table()
+{}
+
+// placement_table private methods
+// add the placements of the species left on the free positions
+/* The first free position must be covered by one of the species left,
+ * so each kind of species is tried on each set of positions next to
+ * each other containing it; taking the positions in order this way
+ * lists every placement once, however many of a species there are.
+ */
+void
+placement_table::enumerate(const adjacency& adjacent, kinds& left,
+			   CH_STD::vector<unsigned int>& block,
+			   model_species::seq& block_species, seq& placed)
+{
+  // find the first free position
+  unsigned int first(0U);
+  while (first < block.size() && block[first] != npos)
+    {
+      ++first;
+    }
+  if (first == block.size())
+    {
+      // every position is covered, so save the placement
+      placement done;
+      done.species.reserve(block.size());
+      done.others.resize(block.size());
+      for (unsigned int i(0U); i < block.size(); ++i)
+	{
+	  done.species.push_back(block_species[block[i]]);
+	  for (unsigned int j(0U); j < block.size(); ++j)
+	    {
+	      if (j != i && block[j] == block[i])
+		{
+		  done.others[i].push_back(j);
+		}
+	    }
+	}
+      placed.push_back(done);
+      return;
+    }
+  // try each kind of species left on it
+  for (kinds::iterator it(left.begin()); it != left.end(); ++it)
+    {
+      if (it->second == 0U)
+	{
+	  continue;		// for (it)
+	}
+      // find the positions it could cover
+      CH_STD::set<CH_STD::vector<unsigned int> > found;
+      CH_STD::vector<unsigned int> connected(1U, first);
+      grow(adjacent, block, it->first->get_surface_coordination(),
+	   connected, found);
+      // put one of this species on each of them in turn
+      --(it->second);
+      block_species.push_back(it->first);
+      for (CH_STD::set<CH_STD::vector<unsigned int> >::const_iterator
+	     fit(found.begin()); fit != found.end(); ++fit)
+	{
+	  for (unsigned int i(0U); i < fit->size(); ++i)
+	    {
+	      block[(*fit)[i]] = block_species.size() - 1U;
+	    }
+	  enumerate(adjacent, left, block, block_species, placed);
+	  for (unsigned int i(0U); i < fit->size(); ++i)
+	    {
+	      block[(*fit)[i]] = npos;
+	    }
+	}
+      block_species.pop_back();
+      ++(it->second);
+    }
+  return;
+}
+
+// add each set of free positions next to each other containing those
+// in CONNECTED
+void
+placement_table::grow(const adjacency& adjacent,
+		      const CH_STD::vector<unsigned int>& block,
+		      unsigned int coord, CH_STD::vector<unsigned int>& connected,
+		      CH_STD::set<CH_STD::vector<unsigned int> >& found)
+{
+  if (connected.size() == coord)
+    {
+      // the same set may be grown in different orders
+      CH_STD::vector<unsigned int> positions(connected);
+      CH_STD::sort(positions.begin(), positions.end());
+      found.insert(positions);
+      return;
+    }
+  // add each free position next to one already in the set
+  for (unsigned int i(0U); i < block.size(); ++i)
+    {
+      if (block[i] != npos
+	  || CH_STD::find(connected.begin(), connected.end(), i)
+	  != connected.end())
+	{
+	  continue;		// for (i)
+	}
+      for (unsigned int j(0U); j < connected.size(); ++j)
+	{
+	  if (adjacent[connected[j]][i])
+	    {
+	      connected.push_back(i);
+	      grow(adjacent, block, coord, connected, found);
+	      connected.pop_back();
+	      break;		// for (j)
+	    }
+	}
+    }
+  return;
+}
+
+// placement_table public methods
+// forget all of the placements
+void
+placement_table::clear()
+{
+  shapes.clear();
+  return;
+}
+
+// list the placements of PRODUCTS on the group of sites ENVS
+void
+placement_table::insert(unsigned int shape_index,
+			const CH_STD::vector<environment*>& envs,
+			const model_species::seq& products)
+  throw (bad_request)
+{
+  // the surface species, sorted as in an ensemble, identify the products
+  ensemble prods(products);
+  if (prods.get_coordination() != envs.size())
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":placement_table::insert(): the products cover " +
+			t_string(prods.get_coordination()) + " sites, but "
+			"the group has " + t_string(envs.size()));
+    }
+  if (shapes.size() <= shape_index)
+    {
+      shapes.resize(shape_index + 1U);
+    }
+  // only list each set of products once
+  model_species::seq key(prods.begin(), prods.end());
+  for (CH_STD::vector<entry>::const_iterator it(shapes[shape_index].begin());
+       it != shapes[shape_index].end(); ++it)
+    {
+      if (it->first == key)
+	{
+	  return;
+	}
+    }
+  // count each species, in order of name
+  model_species::seq named(key);
+  CH_STD::sort(named.begin(), named.end(), name_less());
+  kinds left;
+  for (model_species::seq_citer it(named.begin()); it != named.end(); ++it)
+    {
+      if (left.empty() || left.back().first != *it)
+	{
+	  left.push_back(CH_STD::make_pair(*it, 0U));
+	}
+      ++(left.back().second);
+    }
+  // find which positions of the group are next to each other
+  adjacency adjacent(envs.size(), CH_STD::vector<bool>(envs.size(), false));
+  for (unsigned int i(0U); i < envs.size(); ++i)
+    {
+      for (unsigned int j(0U); j < envs.size(); ++j)
+	{
+	  adjacent[i][j] = envs[i]->is_neighbor(envs[j]);
+	}
+    }
+  // list the placements
+  shapes[shape_index].push_back(entry(key, seq()));
+  CH_STD::vector<unsigned int> block(envs.size(), npos);
+  model_species::seq block_species;
+  enumerate(adjacent, left, block, block_species,
+	    shapes[shape_index].back().second);
+  return;
+}
+
+// return the placements of the surface species from BEGIN to END
+const placement_table::seq*
+placement_table::find(unsigned int shape_index,
+		      model_species::seq_citer begin,
+		      model_species::seq_citer end) const
+{
+  if (shape_index >= shapes.size())
+    {
+      return 0;
+    }
+  unsigned int size(end - begin);
+  for (CH_STD::vector<entry>::const_iterator it(shapes[shape_index].begin());
+       it != shapes[shape_index].end(); ++it)
+    {
+      if (it->first.size() == size
+	  && CH_STD::equal(begin, end, it->first.begin()))
+	{
+	  return &it->second;
+	}
+    }
+  return 0;
+}
+
+CH_END_NAMESPACE
+
+/* $Id$ */
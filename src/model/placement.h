@@ -0,0 +1,117 @@
+// -*- C++ -*-
+// Class listing the ways reaction products can be put on a group of sites.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_MODEL_PLACEMENT_H
+#define CH_MODEL_PLACEMENT_H 1
+
+#include <set>
+#include <utility>
+#include <vector>
+#include "except.h"
+#include "species.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// defined in environment.h
+class environment;
+
+// the ways the products of the reactions of a mechanism can be put on
+// the groups of sites of a surface
+//
+// A species covering more than one site must go on sites next to each
+// other, which takes a search through the groups of sites the reacting
+// sites make.  The groups of every point of a surface have the same
+// shapes (see stencil), so every way of putting each set of products on
+// each shape is listed once, as positions in the group, and an event
+// only has to pick one of them.
+class placement_table
+{
+public:
+  // the species put on each position of a group and the other
+  // positions the species on each covers
+  struct placement
+  {
+    model_species::seq species;	// species on each position
+    // other positions covered by the species on each position
+    CH_STD::vector<CH_STD::vector<unsigned int> > others;
+  };
+  // set up typedef's
+  typedef CH_STD::vector<placement> seq;
+
+private:
+  // order species by name so placements do not depend on addresses
+  struct name_less
+  {
+    bool operator()(const model_species* left,
+		    const model_species* right) const;
+  };
+  // products (surface species, sorted as in an ensemble) and their
+  // placements on one shape
+  typedef CH_STD::pair<model_species::seq,seq> entry;
+  typedef CH_STD::vector<CH_STD::vector<bool> > adjacency;
+  typedef CH_STD::vector<CH_STD::pair<model_species*,unsigned int> > kinds;
+
+  CH_STD::vector<CH_STD::vector<entry> > shapes; // products of each shape
+  static const unsigned int npos; // block of a position not yet covered
+
+private:
+  // prevent copy construction and assignment
+  placement_table(const placement_table&);
+  placement_table& operator=(const placement_table&);
+  // add the placements of the species left in LEFT on the free
+  // positions (those in no block) of BLOCK, the blocks put so far
+  // holding the species in BLOCK_SPECIES, to PLACED
+  static void enumerate(const adjacency& adjacent, kinds& left,
+			CH_STD::vector<unsigned int>& block,
+			model_species::seq& block_species, seq& placed);
+  // add each set of COORD free positions of BLOCK next to each other
+  // which contains those in CONNECTED to FOUND
+  static void grow(const adjacency& adjacent,
+		   const CH_STD::vector<unsigned int>& block,
+		   unsigned int coord, CH_STD::vector<unsigned int>& connected,
+		   CH_STD::set<CH_STD::vector<unsigned int> >& found);
+public:
+  // ctor: (default) create an empty table
+  placement_table();
+  // dtor: do nothing
+  ~placement_table();
+
+  // forget all of the placements
+  void clear();
+  // list the placements of PRODUCTS on the group of sites ENVS, which
+  // is of shape SHAPE_INDEX (species not on the surface are ignored)
+  void insert(unsigned int shape_index,
+	      const CH_STD::vector<environment*>& envs,
+	      const model_species::seq& products)
+    throw (bad_request);	// this
+  // return the placements of the surface species from BEGIN to END
+  // (sorted as in an ensemble) on shape SHAPE_INDEX, or 0 if they were
+  // not listed
+  const seq* find(unsigned int shape_index, model_species::seq_citer begin,
+		  model_species::seq_citer end) const;
+}; // end class placement_table
+
+CH_END_NAMESPACE
+
+#endif // not CH_MODEL_PLACEMENT_H
+
+/* $Id$ */
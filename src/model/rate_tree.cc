@@ -0,0 +1,170 @@
+// Methods to maintain and search the kinetic Monte Carlo rate tree.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "rate_tree.h"
+#include "t_string.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// rate_tree methods
+// ctor: (default) create a tree with SIZE zero rates
+// ctor: default size = 0U
+rate_tree::rate_tree(unsigned int size)
+  : leaves(0U), base(1U), node()
+{
+  resize(size);
+}
+
+// ctor: copy
+rate_tree::rate_tree(const rate_tree& original)
+  : leaves(original.leaves), base(original.base), node(original.node)
+{}
+
+// dtor: do nothing
+rate_tree::~rate_tree()
+{}
+
+// rate_tree public methods
+// discard all rates and make room for SIZE zero rates
+void
+rate_tree::resize(unsigned int size)
+{
+  leaves = size;
+  // the leaves start at the first power of two that holds them all
+  for (base = 1U; base < leaves; base *= 2U);
+  // all nodes (and therefore all sums) start at zero
+  node.assign(2U * base, 0.0e0);
+  return;
+}
+
+// return the number of rates in the tree
+unsigned int
+rate_tree::size() const
+{
+  return leaves;
+}
+
+// return the rate of leaf I
+double
+rate_tree::get(unsigned int i) const
+{
+  return node[base + i];
+}
+
+// change the rate of leaf I and update its ancestors, return old
+double
+rate_tree::set(unsigned int i, double rate)
+  throw (bad_value)
+{
+  double old(get(i));
+  // change the leaf
+  assign(i, rate);
+  // recalculate each ancestor from its children (rather than adding the
+  // difference) so round off can not accumulate in the sums
+  for (unsigned int n((base + i) / 2U); n > 0U; n /= 2U)
+    {
+      node[n] = node[2U * n] + node[2U * n + 1U];
+    }
+  return old;
+}
+
+// change the rate of leaf I without updating ancestors
+void
+rate_tree::assign(unsigned int i, double rate)
+  throw (bad_value)
+{
+  // make sure leaf is in the tree
+  if (i >= leaves)
+    {
+      throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":rate_tree::assign(): leaf index (" + t_string(i) +
+		      ") is not less than the number of leaves (" +
+		      t_string(leaves) + ")");
+    }
+  // sums of negative rates make no sense
+  if (rate < 0.0e0)
+    {
+      throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":rate_tree::assign(): can not insert negative rate ("
+		      + t_string(rate) + ") into the tree");
+    }
+  node[base + i] = rate;
+  return;
+}
+
+// recalculate all the interior sums from the leaves
+void
+rate_tree::refresh()
+{
+  // work up from the last interior node to the root
+  for (unsigned int n(base - 1U); n > 0U; --n)
+    {
+      node[n] = node[2U * n] + node[2U * n + 1U];
+    }
+  return;
+}
+
+// return the sum of all the rates
+double
+rate_tree::total() const
+{
+  return node[1];
+}
+
+// return the leaf whose cumulative rate interval contains R
+unsigned int
+rate_tree::find(double r) const
+  throw (bad_value)
+{
+  // make sure there is something to find
+  if (!(total() > 0.0e0))
+    {
+      throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":rate_tree::find(): can not select from a tree "
+		      "whose total rate is not positive");
+    }
+  // descend from the root
+  unsigned int n(1U);
+  while (n < base)
+    {
+      unsigned int left(2U * n);
+      // go right only if R is past the left sum and there is something
+      // there (R can equal the total because of round off)
+      if (r < node[left] || !(node[left + 1U] > 0.0e0))
+	{
+	  n = left;
+	}
+      else
+	{
+	  r -= node[left];
+	  n = left + 1U;
+	}
+    }
+  return n - base;
+}
+
+CH_END_NAMESPACE
+
+/* $Id: rate_tree.cc,v 1.1.1.1 2004/11/25 20:24:08 banjo Exp $ */
@@ -0,0 +1,77 @@
+// -*- C++ -*-
+// Binary sum tree used to select kinetic Monte Carlo events.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_MODEL_RATE_TREE_H
+#define CH_MODEL_RATE_TREE_H 1
+
+#include <vector>
+#include "except.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// complete binary tree whose leaves hold nonnegative rates and whose
+// interior nodes hold the sum of their children; the root is the
+// total rate and a cumulative rate can be located in O(log n)
+class rate_tree
+{
+  unsigned int leaves;		// number of rates in the tree
+  unsigned int base;		// index of first leaf (power of two)
+  CH_STD::vector<double> node;	// node[1] is root, node[base + i] is leaf i
+
+private:
+  // prevent assignment
+  rate_tree& operator=(const rate_tree&);
+public:
+  // ctor: (default) create a tree with SIZE zero rates
+  explicit rate_tree(unsigned int size = 0U);
+  // ctor: copy
+  rate_tree(const rate_tree& original);
+  // dtor: do nothing
+  ~rate_tree();
+
+  // discard all rates and make room for SIZE zero rates
+  void resize(unsigned int size);
+  // return the number of rates in the tree
+  unsigned int size() const;
+  // return the rate of leaf I
+  double get(unsigned int i) const;
+  // change the rate of leaf I and update its ancestors, return old
+  double set(unsigned int i, double rate)
+    throw (bad_value); // this
+  // change the rate of leaf I without updating ancestors (see refresh())
+  void assign(unsigned int i, double rate)
+    throw (bad_value); // this
+  // recalculate all the interior sums from the leaves
+  void refresh();
+  // return the sum of all the rates
+  double total() const;
+  // return the leaf whose cumulative rate interval contains R, where
+  // 0 <= R < total()
+  unsigned int find(double r) const
+    throw (bad_value); // this
+}; // end class rate_tree
+
+CH_END_NAMESPACE
+
+#endif // not CH_MODEL_RATE_TREE_H
+
+/* $Id: rate_tree.h,v 1.1.1.1 2004/11/25 20:24:08 banjo Exp $ */
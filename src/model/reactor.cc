@@ -314,6 +314,123 @@ reactor::kmc_reaction(model_species* msp) const
   return 0.0e0;
 }
 
+// return the rate of change of MSP from its reactions in the units of
+// its quantity
+double
+reactor::design_rate(model_species* msp) const
+  throw (bad_type)
+{
+  // set up variables to reduce function calls
+  double rate(msp->get_derivative());
+  double yprime(0.0e0);
+
+  // surface species equations
+  if (msp->get_surface_coordination() > 0U)
+    {
+      if (amount_type == Emoles)
+	{
+	  // multiply rate by Avogadro's number
+	  // think of coverage as molecules/site (N_i/Ns)
+	  rate *= constant::avogadro;
+	}
+      switch (size_type)
+	{
+	case Evolume:
+	  // y_i' = r_i * V / Ns
+	  yprime = rate * get_volume() / get_sites();
+	  break;
+
+	case Eweight:
+	  // y_i' = r_i * W / Ns
+	  yprime = rate * get_weight() / get_sites();
+	  break;
+
+	case Esites:
+	  // no modifications: y_i' = r_i
+	  yprime = rate;
+	  break;
+
+	default:		// throw an exception
+	  throw bad_type(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			 ":reactor::design_rate(): the denominator of "
+			 "the rate expression has invalid units");
+	  break;
+	}
+    }
+  // pressure equations
+  else if (fluid_type == quantity::Epressure)
+    {
+      if (amount_type == Emolecules)
+	{
+	  // divide rate by Avogadro's number
+	  rate /= constant::avogadro;
+	}
+      switch (size_type)
+	{
+	case Evolume:
+	  // y_i' = r_i * RT
+	  yprime = rate * constant::r * get_temperature();
+	  break;
+
+	case Eweight:
+	  // y_i' = r_i * RTW/V
+	  yprime = rate * constant::r * get_temperature() * get_weight()
+	    / get_volume();
+	  break;
+
+	case Esites:
+	  // y_i' = r_i * RTNs/V
+	  yprime = rate * constant::r * get_temperature() * get_sites()
+	    / get_volume();
+	  break;
+
+	default:		// throw an exception
+	  throw bad_type(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			 ":reactor::design_rate(): the denominator of "
+			 "the rate expression has invalid units");
+	  break;
+	}
+    }
+  // concentration equations
+  else if (fluid_type == quantity::Econcentration)
+    {
+      if (amount_type == Emolecules)
+	{
+	  // divide rate by Avogadro's number
+	  rate /= constant::avogadro;
+	}
+      switch (size_type)
+	{
+	case Evolume:
+	  // no modifications for Evolume: y_i' = r_i
+	  yprime = rate;
+	  break;
+
+	case Eweight:
+	  // y_i' = r_i * (W / V)
+	  yprime = rate * get_weight() / get_volume();
+	  break;
+
+	case Esites:
+	  // y_i' = r_i * (Ns / V)
+	  yprime = rate * get_sites() / get_volume();
+	  break;
+
+	default:		// throw an exception
+	  throw bad_type(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			 ":reactor::design_rate(): the denominator of "
+			 "the rate expression has invalid units");
+	}
+    }
+  else				// throw an exception
+    {
+      throw bad_type(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		     ":reactor::design_rate(): the units of the "
+		     "derivative are invalid for reactor");
+    }
+  return yprime;
+}
+
 // reactor public methods
 // parse reactor input
 void
@@ -494,6 +611,14 @@ reactor::get_heating_rate() const
   return heating_rate;
 }
 
+// set the temperature DX into a ramp from T0, return old
+double
+reactor::ramp_temperature(double T0, double dx)
+  throw (bad_value)
+{
+  return set_temperature(T0 + get_heating_rate() * dx);
+}
+
 // return the pressure
 double
 reactor::get_pressure() const
@@ -557,6 +682,44 @@ reactor::reactor_eqn(const model_species::seq& species_list)
   return;
 }
 
+// return the change in the reactor equation of MSP per unit of its rate
+/* The design equations are linear in the rate, so the change is the
+ * difference of the equation at a rate of one and at zero.
+ */
+double
+reactor::reactor_eqn_slope(model_species* msp, double& quantity_slope)
+  throw (bad_type)
+{
+  double rate(msp->get_derivative());
+  msp->set_derivative(1.0e0);
+  double slope(reactor_eqn(msp));
+  msp->set_derivative(0.0e0);
+  slope -= reactor_eqn(msp);
+  // put the rate back
+  msp->set_derivative(rate);
+  quantity_slope = 0.0e0;
+  return slope;
+}
+
+// return the fraction of the total change of the fluids that flows out
+// with MSP (none)
+double
+reactor::outflow_fraction(model_species* /* msp */,
+			  double& quantity_slope) const
+{
+  quantity_slope = 0.0e0;
+  return 0.0e0;
+}
+
+// set the flows out for the total change of the fluids (nothing to do)
+void
+reactor::set_outflow(const model_species::seq& /* species_list */,
+		     double /* total_change */)
+  throw (bad_type, bad_value)
+{
+  return;
+}
+
 // adjust rate according to units used in reactor to 1/time
 // (actually more like molecule/time)
 // default original_rate = 1.0e0
@@ -668,6 +831,29 @@ reactor::kmc_step(const model_species::seq_citer species_begin,
     }
   return;
 }
+
+// write the values which change during a run to OUT
+void
+reactor::save_state(binary_ofstream& out) const
+  throw (bad_file)
+{
+  out.put_double(temperature);
+  out.put_double(pressure);
+  out.put_double(volume);
+  return;
+}
+
+// read the values written by save_state() from IN
+void
+reactor::restore_state(binary_ifstream& in)
+  throw (bad_file)
+{
+  // assign directly, the values were checked when they were set
+  temperature = in.get_double();
+  pressure = in.get_double();
+  volume = in.get_double();
+  return;
+}
 
 // flow_reactor methods
 // ctor: (default) call reactor ctor and set flow to zero
@@ -831,6 +1017,26 @@ flow_reactor::add_to_flow(double increment)
   return flow += increment;
 }
 
+// write the values which change during a run to OUT
+void
+flow_reactor::save_state(binary_ofstream& out) const
+  throw (bad_file)
+{
+  reactor::save_state(out);
+  out.put_double(flow);
+  return;
+}
+
+// read the values written by save_state() from IN
+void
+flow_reactor::restore_state(binary_ifstream& in)
+  throw (bad_file)
+{
+  reactor::restore_state(in);
+  flow = in.get_double();
+  return;
+}
+
 CH_END_NAMESPACE
 
 /* $Id: reactor.cc,v 1.1.1.1 2004/11/25 20:24:08 banjo Exp $ */
@@ -26,6 +26,7 @@
 #include <string>
 #include <vector>
 #include "except.h"
+#include "file.h"
 #include "quantity.h"
 #include "reaction.h"
 #include "species.h"
@@ -89,6 +90,11 @@ protected:
   // individual species kmc equation, return relative change in quantity
   // molecules is how many molecules are reacting
   double kmc_reaction(model_species* msp) const;
+  // return the rate of change of MSP from its reactions (its derivative)
+  // in the units of its quantity, the part of the design equations all
+  // reactors share
+  double design_rate(model_species* msp) const
+    throw (bad_type); // this
 public:
   // ctor: (default) set variables to ``typical'' values
   reactor();
@@ -118,6 +124,9 @@ public:
   double get_temperature() const;
   // return the heating rate (temperature/time), return old
   double get_heating_rate() const;
+  // set the temperature DX into a ramp from T0, return old
+  double ramp_temperature(double T0, double dx)
+    throw (bad_value); // set_temperature()
   // return the pressure
   double get_pressure() const;
   // return the volume of the reactor
@@ -133,6 +142,22 @@ public:
     throw (bad_type); // batch_reactor::reactor_eqn(), cstr::reactor_eqn()
   // modify species derivatives using reactor design equations
   virtual double reactor_eqn(model_species* msp) = 0;
+  // return the change in the reactor equation of MSP per unit of its
+  // rate, and put that per unit of its quantity into QUANTITY_SLOPE
+  // (zero unless overridden)
+  virtual double reactor_eqn_slope(model_species* msp,
+				   double& quantity_slope)
+    throw (bad_type); // reactor_eqn()
+  // return the fraction of the total change of the fluids that flows
+  // out with MSP, and put its change per unit of the quantity of MSP
+  // into QUANTITY_SLOPE (zero, no outflow, unless overridden)
+  virtual double outflow_fraction(model_species* msp,
+				  double& quantity_slope) const;
+  // set the flows out for the total change of the fluids TOTAL_CHANGE
+  // (nothing unless overridden)
+  virtual void set_outflow(const model_species::seq& species_list,
+			   double total_change)
+    throw (bad_type, bad_value); // this
   // adjust rate according to units used in reactor
   double kmc_rate(double original_rate = 1.0e0)
     throw (bad_type); // this
@@ -155,6 +180,12 @@ public:
   // update an individual gas-phase species
   virtual void kmc_step(model_species* msp, double dx, double T0,
 			double T1) = 0;
+  // write the values which change during a run to OUT
+  virtual void save_state(binary_ofstream& out) const
+    throw (bad_file); // binary_ofstream::put_double()
+  // read the values written by save_state() from IN
+  virtual void restore_state(binary_ifstream& in)
+    throw (bad_file); // binary_ifstream::get_double()
 }; // end class reactor
 
 // abstract class for flow reactors
@@ -189,6 +220,12 @@ public:
   double set_flow(double flow_);
   // add INCREMENT to total molar FLOW, return new total
   double add_to_flow(double increment);
+  // write the values which change during a run to OUT
+  virtual void save_state(binary_ofstream& out) const
+    throw (bad_file); // reactor::save_state()
+  // read the values written by save_state() from IN
+  virtual void restore_state(binary_ifstream& in)
+    throw (bad_file); // reactor::restore_state()
 }; // end class flow_reactor
 
 CH_END_NAMESPACE
@@ -23,6 +23,9 @@
 #endif // HAVE_CONFIG_H
 
 #include "rng.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
 #include "compare.h"
 #include "t_string.h"
 
@@ -30,25 +33,140 @@
 CH_BEGIN_NAMESPACE
 
 // static instance variables
+const int rng::block_length;
 const int rng_mt::period = 397; // a period parameter
 const ul_int rng_mt::magic = 0x9908b0dfUL; // a magic constant
+const ul_int rng_philox::multiplier[2] = { 0xd2511f53UL, 0xcd9e8d57UL };
+const ul_int rng_philox::weyl[2] = { 0x9e3779b9UL, 0xbb67ae85UL };
 
 // rng methods
-// ctor: intialize seed and name
+// ctor: intialize name, largest number, and seed
 // ctor: default seed_ = 1
-rng::rng(const CH_STD::string& name_, ul_int seed_)
-  : name(name_), seed(seed_)
+rng::rng(const CH_STD::string& name_, ul_int max_, ul_int seed_)
+  : name(name_), seed(seed_), max(max_), open_scale(1.0e0 / (max_ + 1.0e0)),
+    open_open_scale(1.0e0 / (max_ + 2.0e0)), numbers_left(0),
+    exponentials_left(0)
 {}
 
 // ctor: copy (protected)
 rng::rng(const rng& original)
-  : name(original.name), seed(original.seed)
-{}
+  : name(original.name), seed(original.seed), max(original.max),
+    open_scale(original.open_scale),
+    open_open_scale(original.open_open_scale),
+    numbers_left(original.numbers_left),
+    exponentials_left(original.exponentials_left)
+{
+  CH_STD::copy(original.numbers, original.numbers + block_length, numbers);
+  CH_STD::copy(original.exponentials, original.exponentials + block_length,
+	       exponentials);
+}
 
 // dtor: do nothing
 rng::~rng()
 {}
 
+// rng private methods
+// make the next block of numbers
+void
+rng::fill_numbers()
+{
+  generate(numbers, block_length);
+  numbers_left = block_length;
+  return;
+}
+
+// make the next block of exponential variates
+void
+rng::fill_exponentials()
+{
+  // numbers of their own, so the ones returned by get_random() are
+  // not taken in blocks
+  ul_int made[block_length];
+  generate(made, block_length);
+  for (int i(0); i < block_length; ++i)
+    {
+      exponentials[i] = -CH_STD::log((made[i] + 1.0e0) * open_open_scale);
+    }
+  exponentials_left = block_length;
+  return;
+}
+
+// rng protected methods
+// forget the numbers made ahead
+void
+rng::discard()
+{
+  numbers_left = 0;
+  exponentials_left = 0;
+  return;
+}
+
+// skip up to N numbers made ahead, return how many more to skip
+ul_int
+rng::skip(ul_int n)
+{
+  if (n < (ul_int) numbers_left)
+    {
+      numbers_left -= n;
+      return 0UL;
+    }
+  n -= numbers_left;
+  numbers_left = 0;
+  return n;
+}
+
+// write the numbers made ahead to OUT
+void
+rng::save_blocks(binary_ofstream& out) const
+  throw (bad_file)
+{
+  // every number holds at most 32 bits
+  out.put_int(numbers_left);
+  for (int i(block_length - numbers_left); i < block_length; ++i)
+    {
+      out.put_unsigned(numbers[i]);
+    }
+  out.put_int(exponentials_left);
+  for (int i(block_length - exponentials_left); i < block_length; ++i)
+    {
+      out.put_double(exponentials[i]);
+    }
+  return;
+}
+
+// read the numbers written by save_blocks() from IN
+void
+rng::restore_blocks(binary_ifstream& in)
+  throw (bad_request, bad_file)
+{
+  int numbers_left_(in.get_int());
+  if (numbers_left_ < 0 || numbers_left_ > block_length)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":rng::restore_blocks(): number of numbers made "
+			"ahead read from " + in.get_path() + " is not valid");
+    }
+  for (int i(block_length - numbers_left_); i < block_length; ++i)
+    {
+      numbers[i] = in.get_unsigned();
+    }
+  numbers_left = numbers_left_;
+  int exponentials_left_(in.get_int());
+  if (exponentials_left_ < 0 || exponentials_left_ > block_length)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":rng::restore_blocks(): number of exponential "
+			"variates made ahead read from " + in.get_path() +
+			" is not valid");
+    }
+  for (int i(block_length - exponentials_left_); i < block_length; ++i)
+    {
+      exponentials[i] = in.get_double();
+    }
+  exponentials_left = exponentials_left_;
+  return;
+}
+
 // rng public methods
 // create a new random number generator of the given type, return
 // pointer or zero if type is invalid
@@ -65,10 +183,27 @@ rng::new_rng(const CH_STD::string& type)
     {
       return new rng_mt();
     }
+  else if (icompare(type, "philox") == 0)
+    {
+      return new rng_philox();
+    }
   // else				// unknown rng
   return 0;
 }
 
+// return a new generator of the same type for the STREAM-th of several
+// independent uses of this one, seeded from this one
+rng*
+rng::new_stream(ul_int)
+{
+  rng* other(new_rng(name));
+  if (other != 0)
+    {
+      other->set_seed(get_random());
+    }
+  return other;
+}
+
 // parse rng input
 void
 rng::parse(token_seq_citer& token_it, token_seq_citer end)
@@ -85,6 +220,24 @@ rng::parse(token_seq_citer& token_it, token_seq_citer end)
 	  ++token_it;
 	  continue;		// while ()
 	}
+      else if (icompare(*token_it, "stream") == 0)
+	{
+	  // use the stream given by the next token
+	  ul_int stream(CH_STD::strtoul((++token_it)->c_str(), (char **)0, 0));
+	  try
+	    {
+	      set_stream(stream);
+	    }
+	  catch (bad_request& e)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":rng::parse(): random number generator " +
+			      name + " does not have streams");
+	    }
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
       else if (icompare(*token_it, "end") == 0)
 	{
 	  // make sure it is the end of rng input
@@ -136,14 +289,58 @@ rng::set_seed(ul_int seed_)
 {
   ul_int old(seed);
   seed = seed_;
+  // the numbers made ahead came from the old seed
+  discard();
   return old;
 }
+
+// change the stream of numbers given for the seed, generators without
+// streams throw
+ul_int
+rng::set_stream(ul_int)
+  throw (bad_request)
+{
+  throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		    ":rng::set_stream(): random number generator " + name +
+		    " does not have streams");
+}
+
+// skip the next N numbers, generators which can not jump ahead throw
+void
+rng::jump(ul_int)
+  throw (bad_request)
+{
+  throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		    ":rng::jump(): random number generator " + name +
+		    " can not jump ahead");
+}
+
+// write the state of the generator to OUT, generators which can not
+// get at their state throw
+void
+rng::save_state(binary_ofstream&) const
+  throw (bad_request, bad_file)
+{
+  throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		    ":rng::save_state(): the state of random number "
+		    "generator " + name + " can not be saved");
+}
+
+// read the state written by save_state() from IN
+void
+rng::restore_state(binary_ifstream&)
+  throw (bad_request, bad_file)
+{
+  throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		    ":rng::restore_state(): the state of random number "
+		    "generator " + name + " can not be restored");
+}
 
 // rng_rand methods
 // ctor: seed the rng with optional seed
 // ctor: default seed_ = 1
 rng_rand::rng_rand(ul_int seed_)
-  : rng("rand", seed_)
+  : rng("rand", RAND_MAX, seed_)
 {
   srand(get_seed());
 }
@@ -151,7 +348,23 @@ rng_rand::rng_rand(ul_int seed_)
 // ctor: copy
 rng_rand::rng_rand(const rng_rand& original)
   : rng(original)
-{}				// don't call srand because seed is global
+{
+  // don't call srand because seed is global, but do not give the
+  // numbers the original made ahead a second time
+  discard();
+}
+
+// rng_rand protected methods
+// fill the N numbers from BEGIN with rand()
+void
+rng_rand::generate(ul_int* begin, int n)
+{
+  for (int i(0); i < n; ++i)
+    {
+      begin[i] = rand();
+    }
+  return;
+}
 
 // dtor: do nothing
 rng_rand::~rng_rand()
@@ -177,7 +390,7 @@ rng_rand::set_seed(ul_int seed_)
 // ctor: (default) optional seed (should be odd in the range [0-2^32))
 // ctor: default seed_ = 4357UL
 rng_mt::rng_mt(ul_int seed_)
-  : rng("mt", seed_)
+  : rng("mt", 0xffffffffUL, seed_) // 0xffffffff = 2^32 - 1
 {
   seed_state();
 }
@@ -186,7 +399,9 @@ rng_mt::rng_mt(ul_int seed_)
 rng_mt::rng_mt(const rng_mt& original)
   : rng(original)
 {
+  // the copy starts over from the seed
   seed_state();
+  discard();
 }
 
 // dtor: do nothing
@@ -206,8 +421,8 @@ rng_mt::seed_state()
       *s++ = (x *= 69069UL) & 0xffffffffUL);
 }
 
-// reload the random number generator
-ul_int
+// make the next state vector
+void
 rng_mt::reload()
 {
   register ul_int* p0 = state;
@@ -220,8 +435,8 @@ rng_mt::reload()
   // if(left < -1)
   //  seed_state();
 
-  left = length - 1;
-  next = state + 1;
+  left = length;
+  next = state;
 
   for(s0 = state[0], s1 = state[1], j = length - period + 1; --j;
       s0 = s1, s1 = *p2++)
@@ -232,10 +447,38 @@ rng_mt::reload()
 
   s1=state[0];
   *p0 = *pp ^ (mixBits(s0, s1) >> 1) ^ (loBit(s1) ? magic : 0UL);
-  s1 ^= (s1 >> 11);
-  s1 ^= (s1 <<  7) & 0x9d2c5680UL;
-  s1 ^= (s1 << 15) & 0xefc60000UL;
-  return s1 ^ (s1 >> 18);
+}
+
+// rng_mt protected methods
+// fill the N numbers from BEGIN with the next tempered elements of the
+// state vector
+/* The tempering of each element is independent of the others, so the
+ * inner loop is left simple enough for the compiler to vectorize.
+ */
+void
+rng_mt::generate(ul_int* begin, int n)
+{
+  while (n > 0)
+    {
+      if (left == 0)
+	{
+	  reload();
+	}
+      int m((n < left) ? n : left);
+      for (int i(0); i < m; ++i)
+	{
+	  ul_int y(next[i]);
+	  y ^= (y >> 11);
+	  y ^= (y <<  7) & 0x9d2c5680UL;
+	  y ^= (y << 15) & 0xefc60000UL;
+	  begin[i] = y ^ (y >> 18);
+	}
+      next += m;
+      left -= m;
+      begin += m;
+      n -= m;
+    }
+  return;
 }
 
 // rng_mt public methods
@@ -257,6 +500,335 @@ rng_mt::set_seed(ul_int seed_)
   return old;
 }
 
+// write the seed and state vector to OUT
+void
+rng_mt::save_state(binary_ofstream& out) const
+  throw (bad_request, bad_file)
+{
+  out.put_unsigned(get_seed());
+  out.put_int(left);
+  // next is not set until the first reload()
+  out.put_int((left > 0) ? next - state : 0);
+  // every element holds at most 32 bits
+  for (int i(0); i < length; ++i)
+    {
+      out.put_unsigned(state[i]);
+    }
+  save_blocks(out);
+  return;
+}
+
+// read the seed and state vector written by save_state() from IN
+void
+rng_mt::restore_state(binary_ifstream& in)
+  throw (bad_request, bad_file)
+{
+  // do not let set_seed() fill the state vector
+  rng::set_seed(in.get_unsigned());
+  int left_(in.get_int());
+  int offset(in.get_int());
+  if (left_ < 0 || left_ > length || offset < 0 || offset + left_ > length)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":rng_mt::restore_state(): state read from "
+			+ in.get_path() + " is not valid");
+    }
+  for (int i(0); i < length; ++i)
+    {
+      state[i] = in.get_unsigned();
+    }
+  left = left_;
+  next = state + offset;
+  restore_blocks(in);
+  return;
+}
+
+// rng_philox class methods
+// ctor: (default) optional seed and stream
+// ctor: default seed_ = 4357UL, stream_ = 0UL
+rng_philox::rng_philox(ul_int seed_, ul_int stream_)
+  : rng("philox", 0xffffffffUL, seed_), left(0)
+{
+  // the high word is empty if an unsigned long has only 32 bits
+  key[0] = seed_ & 0xffffffffUL;
+  key[1] = ((seed_ >> 16) >> 16) & 0xffffffffUL;
+  counter[0] = 0UL;
+  counter[1] = 0UL;
+  counter[2] = stream_ & 0xffffffffUL;
+  counter[3] = ((stream_ >> 16) >> 16) & 0xffffffffUL;
+  for (int i(0); i < 4; ++i)
+    {
+      block[i] = 0UL;
+    }
+}
+
+// ctor: copy (the stream and position as well)
+rng_philox::rng_philox(const rng_philox& original)
+  : rng(original), left(original.left)
+{
+  key[0] = original.key[0];
+  key[1] = original.key[1];
+  for (int i(0); i < 4; ++i)
+    {
+      counter[i] = original.counter[i];
+      block[i] = original.block[i];
+    }
+}
+
+// dtor: do nothing
+rng_philox::~rng_philox()
+{}
+
+// rng_philox private methods
+// set HIGH and LOW to the high and low 32 bits of the product of A and B
+/* Done in 16 bit pieces if an unsigned long has only 32 bits. */
+void
+rng_philox::multiply(ul_int a, ul_int b, ul_int& high, ul_int& low)
+{
+#if ULONG_MAX > 0xffffffffUL
+  ul_int product(a * b);
+  low = product & 0xffffffffUL;
+  high = product >> 32;
+#else // ULONG_MAX is 0xffffffffUL
+  ul_int a_low(a & 0xffffUL);
+  ul_int a_high(a >> 16);
+  ul_int b_low(b & 0xffffUL);
+  ul_int b_high(b >> 16);
+  ul_int low_low(a_low * b_low);
+  ul_int low_high(a_low * b_high);
+  ul_int high_low(a_high * b_low);
+  // the middle 16 bits and what they carry
+  ul_int middle((low_low >> 16) + (low_high & 0xffffUL)
+		+ (high_low & 0xffffUL));
+  low = ((middle << 16) | (low_low & 0xffffUL)) & 0xffffffffUL;
+  high = (a_high * b_high + (low_high >> 16) + (high_low >> 16)
+	  + (middle >> 16)) & 0xffffffffUL;
+#endif // ULONG_MAX
+  return;
+}
+
+// scramble the counters of the next N blocks into the 4 N numbers from
+// OUT and move counter on past them
+/* Each round is done to all of the blocks before the next, so the
+ * blocks, which are independent of each other, can be worked on
+ * together.
+ */
+void
+rng_philox::encrypt(ul_int* out, int n)
+{
+  for (int b(0); b < n; ++b)
+    {
+      out[4 * b] = counter[0];
+      out[4 * b + 1] = counter[1];
+      out[4 * b + 2] = counter[2];
+      out[4 * b + 3] = counter[3];
+      advance(1UL);
+    }
+  ul_int k0(key[0]);
+  ul_int k1(key[1]);
+  for (int round(0); round < 10; ++round)
+    {
+      if (round > 0)
+	{
+	  // bump the key
+	  k0 = (k0 + weyl[0]) & 0xffffffffUL;
+	  k1 = (k1 + weyl[1]) & 0xffffffffUL;
+	}
+      for (ul_int* x(out); x != out + 4 * n; x += 4)
+	{
+	  ul_int high0;
+	  ul_int low0;
+	  ul_int high1;
+	  ul_int low1;
+	  multiply(multiplier[0], x[0], high0, low0);
+	  multiply(multiplier[1], x[2], high1, low1);
+	  x[0] = high1 ^ x[1] ^ k0;
+	  x[1] = low1;
+	  x[2] = high0 ^ x[3] ^ k1;
+	  x[3] = low0;
+	}
+    }
+  return;
+}
+
+// move counter on by N blocks
+void
+rng_philox::advance(ul_int n)
+{
+  ul_int add(n & 0xffffffffUL);
+  counter[0] = (counter[0] + add) & 0xffffffffUL;
+  // the low word wrapped around if it is now less than what was added
+  ul_int carry((counter[0] < add) ? 1UL : 0UL);
+  counter[1] = (counter[1] + ((n >> 16) >> 16) + carry) & 0xffffffffUL;
+  return;
+}
+
+// rng_philox protected methods
+// fill the N numbers from BEGIN with the next ones of the stream
+void
+rng_philox::generate(ul_int* begin, int n)
+{
+  int i(0);
+  // use up the current block first
+  for (; i < n && left > 0; ++i)
+    {
+      begin[i] = block[4 - left--];
+    }
+  // make whole blocks in place
+  int whole((n - i) / 4);
+  encrypt(begin + i, whole);
+  i += 4 * whole;
+  // and keep what is left of the last one
+  if (i < n)
+    {
+      encrypt(block, 1);
+      left = 4;
+      for (; i < n; ++i)
+	{
+	  begin[i] = block[4 - left--];
+	}
+    }
+  return;
+}
+
+// rng_philox public methods
+// copy current rng_philox, return pointer to it
+rng*
+rng_philox::copy()
+{
+  return new rng_philox(*this);
+}
+
+// return a generator of the same seed whose stream is made from this
+// one's and STREAM
+/* The low word of the stream of this generator becomes the high word of
+ * the new one and STREAM + 1 its low word, so the streams of the
+ * threads of a run never meet each other or the one of the run, nor do
+ * those of runs on streams with different low words.
+ */
+rng*
+rng_philox::new_stream(ul_int stream)
+{
+  rng_philox* other(new rng_philox(get_seed()));
+  other->counter[2] = (stream + 1UL) & 0xffffffffUL;
+  other->counter[3] = counter[2];
+  return other;
+}
+
+// change the seed, starting at the beginning of the stream, return old
+ul_int
+rng_philox::set_seed(ul_int seed_)
+{
+  ul_int old(rng::set_seed(seed_));
+  key[0] = seed_ & 0xffffffffUL;
+  key[1] = ((seed_ >> 16) >> 16) & 0xffffffffUL;
+  counter[0] = 0UL;
+  counter[1] = 0UL;
+  left = 0;
+  return old;
+}
+
+// change the stream, starting at its beginning, return old one
+ul_int
+rng_philox::set_stream(ul_int stream)
+  throw (bad_request)
+{
+  ul_int old(get_stream());
+  counter[0] = 0UL;
+  counter[1] = 0UL;
+  counter[2] = stream & 0xffffffffUL;
+  counter[3] = ((stream >> 16) >> 16) & 0xffffffffUL;
+  left = 0;
+  discard();
+  return old;
+}
+
+// return the stream
+ul_int
+rng_philox::get_stream() const
+{
+  return counter[2] | ((counter[3] << 16) << 16);
+}
+
+// skip the next N numbers (without making them)
+void
+rng_philox::jump(ul_int n)
+  throw (bad_request)
+{
+  // use up the numbers made ahead and the current block first
+  n = skip(n);
+  if (n < (ul_int) left)
+    {
+      left -= n;
+      return;
+    }
+  n -= left;
+  left = 0;
+  // skip whole blocks, then start the one N is in
+  advance(n / 4UL);
+  if (n % 4UL != 0UL)
+    {
+      encrypt(block, 1);
+      left = 4 - n % 4UL;
+    }
+  return;
+}
+
+// write the seed, counter, and current block to OUT
+void
+rng_philox::save_state(binary_ofstream& out) const
+  throw (bad_request, bad_file)
+{
+  // every word holds at most 32 bits
+  out.put_unsigned(key[0]);
+  out.put_unsigned(key[1]);
+  for (int i(0); i < 4; ++i)
+    {
+      out.put_unsigned(counter[i]);
+    }
+  out.put_int(left);
+  for (int i(0); i < 4; ++i)
+    {
+      out.put_unsigned(block[i]);
+    }
+  save_blocks(out);
+  return;
+}
+
+// read the state written by save_state() from IN
+void
+rng_philox::restore_state(binary_ifstream& in)
+  throw (bad_request, bad_file)
+{
+  ul_int key_[2];
+  key_[0] = in.get_unsigned();
+  key_[1] = in.get_unsigned();
+  ul_int counter_[4];
+  for (int i(0); i < 4; ++i)
+    {
+      counter_[i] = in.get_unsigned();
+    }
+  int left_(in.get_int());
+  if (left_ < 0 || left_ > 4)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":rng_philox::restore_state(): state read from "
+			+ in.get_path() + " is not valid");
+    }
+  // do not let set_seed() start the stream over
+  rng::set_seed(key_[0] | ((key_[1] << 16) << 16));
+  key[0] = key_[0];
+  key[1] = key_[1];
+  for (int i(0); i < 4; ++i)
+    {
+      counter[i] = counter_[i];
+      block[i] = in.get_unsigned();
+    }
+  left = left_;
+  restore_blocks(in);
+  return;
+}
+
 CH_END_NAMESPACE
 
 /* $Id: rng.cc,v 1.1.1.1 2004/11/25 20:24:08 banjo Exp $ */
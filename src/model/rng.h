@@ -25,6 +25,7 @@
 #include <cstdlib>
 #include <string>
 #include "except.h"
+#include "file.h"
 #include "token.h"
 
 // set namespace to avoid possible clashes
@@ -34,20 +35,55 @@ CH_BEGIN_NAMESPACE
 typedef unsigned long int ul_int; // must be at least 32 bits
 
 // random number generator class
+//
+// Numbers are made a block at a time by generate() and handed out from
+// the block, so drawing one costs a test and a load rather than a call
+// through the virtual table, and the loops making them can be unrolled
+// and vectorized.  The exponential variates needed for time steps are
+// made a block at a time as well, from numbers of their own, so the
+// logarithms are taken together.
 class rng
 {
+public:
+  static const int block_length = 256; // numbers made at a time
+
+private:
   CH_STD::string name;		// name of generator
   ul_int seed;			// random number generator seed
+  ul_int max;			// largest number the generator makes
+  double open_scale;		// 1 / (max + 1)
+  double open_open_scale;	// 1 / (max + 2)
+  ul_int numbers[block_length];	// numbers made ahead
+  int numbers_left;		// numbers of the block not yet returned
+  double exponentials[block_length]; // exponential variates made ahead
+  int exponentials_left;	// variates of the block not yet returned
 
 private:
   // prevent assignment
   rng& operator=(const rng&);
+  // make the next block of numbers
+  void fill_numbers();
+  // make the next block of exponential variates
+  void fill_exponentials();
 protected:
-  // ctor: copy
+  // ctor: copy (the numbers made ahead as well)
   explicit rng(const rng& original);
+  // fill the N numbers from BEGIN with the next ones of the generator
+  virtual void generate(ul_int* begin, int n) = 0;
+  // forget the numbers made ahead (the state of the generator changed)
+  void discard();
+  // skip up to N numbers made ahead, return how many more to skip
+  ul_int skip(ul_int n);
+  // write the numbers made ahead to OUT (for save_state())
+  void save_blocks(binary_ofstream& out) const
+    throw (bad_file);		// binary_ofstream::put_unsigned()
+  // read the numbers written by save_blocks() from IN
+  void restore_blocks(binary_ifstream& in)
+    throw (bad_request, bad_file); // this
 public:
-  // ctor: initialize seed and name
-  rng(const CH_STD::string& name_, ul_int seed_ = 1);
+  // ctor: initialize name, largest number made (which must be one less
+  // than a power of two), and seed
+  rng(const CH_STD::string& name_, ul_int max_, ul_int seed_ = 1);
   // dtor: do nothing
   virtual ~rng();
 
@@ -55,6 +91,10 @@ public:
   virtual rng* copy() = 0;
   // create a new random number generator of the given type, return pointer
   static rng* new_rng(const CH_STD::string& type = "mt");
+  // return a new generator of the same type for the STREAM-th of several
+  // independent uses of this one (such as threads), or 0 if it can not
+  // be made; by default it is seeded from this one
+  virtual rng* new_stream(ul_int stream);
   // parse rng input
   void parse(token_seq_citer& token_it, token_seq_citer end)
     throw (bad_input); // this
@@ -62,24 +102,39 @@ public:
   virtual ul_int set_seed(ul_int seed_);
   // return seed
   ul_int get_seed() const;
+  // change the stream of numbers given for the seed, starting at its
+  // beginning, return the old one; generators without streams throw
+  virtual ul_int set_stream(ul_int stream)
+    throw (bad_request);	// this
+  // skip the next N numbers get_random() would return; generators
+  // which can not jump ahead throw
+  virtual void jump(ul_int n)
+    throw (bad_request);	// this
   // return name of generator
   CH_STD::string get_name() const;
-  // return random int
-  virtual ul_int get_random() = 0;
-  // return a random int in range [0, N)
-  ul_int get_random(ul_int n)
-    { return get_random() % n; }
+  // write the state of the generator to OUT
+  virtual void save_state(binary_ofstream& out) const
+    throw (bad_request, bad_file); // this
+  // read the state written by save_state() from IN
+  virtual void restore_state(binary_ifstream& in)
+    throw (bad_request, bad_file); // this
+  // return random int in range [0, get_max()]
+  ul_int get_random();
+  // return a random int in range [0, N), N at least one and no more
+  // than get_max() + 1 (zero if N is zero)
+  ul_int get_random(ul_int n);
   // return the maximum integer reaturned by get_random()
-  virtual ul_int get_max() = 0;
+  ul_int get_max() const;
   // return random double in the range [0, MAX)
-  double get_random_open(double max = 1.0e0)
-    { return (max * get_random()) / (get_max() + 1.0e0); }
+  double get_random_open(double max_ = 1.0e0);
   // return random double in the range (0, MAX)
-  double get_random_open_open(double max = 1.0e0)
-    { return (max * (get_random() + 1.0e0)) / (get_max() + 2.0e0); }
+  double get_random_open_open(double max_ = 1.0e0);
   // return random double in the range [0, MAX]
-  double get_random_closed(double max = 1.0e0)
-    { return (max * get_random()) / get_max(); }
+  double get_random_closed(double max_ = 1.0e0)
+    { return (max_ * get_random()) / max; }
+  // return a random double from the exponential distribution of mean
+  // one, -log(u) for u in (0, 1)
+  double get_random_exponential();
   // function operator which return random int [0, N)
   int operator()(ul_int n)
     { return get_random(n); }
@@ -88,6 +143,9 @@ public:
 // C library rand() - linear congruential rng
 class rng_rand : public rng
 {
+protected:
+  // fill the N numbers from BEGIN with rand()
+  virtual void generate(ul_int* begin, int n);
 public:
   // ctor: seed the rng with optional seed
   explicit rng_rand(ul_int seed_ = 1);
@@ -100,12 +158,6 @@ public:
   virtual rng* copy();
   // change the seed, return old one
   virtual ul_int set_seed(ul_int seed_);
-  // return random int in the range [0-RAND_MAX]
-  virtual ul_int get_random()
-    { return rand(); }
-  // return the maximum integer reaturned by get_random()
-  virtual ul_int get_max()
-    { return RAND_MAX; }
 }; // end class rng_rand
 
 // the Mersenne Twister of Nishimura (recoded into ISO C++ by dd)
@@ -209,8 +261,8 @@ class rng_mt : public rng
 private:
   // check seed and fill the state vector, set next and left
   void seed_state();
-  // reload the random number generator
-  ul_int reload();
+  // make the next state vector, set next and left
+  void reload();
   // in class inlines
   // mask all but the highest bit of u
   ul_int hiBit(ul_int u)
@@ -224,6 +276,10 @@ private:
   // move hi bit of u to hi bit of v
   ul_int mixBits(ul_int u, ul_int v)
     { return hiBit(u)|loBits(v); }
+protected:
+  // fill the N numbers from BEGIN with the next tempered elements of the
+  // state vector
+  virtual void generate(ul_int* begin, int n);
 public:
   // ctor: (default) optional seed (should be odd in the range [0-2^32))
   explicit rng_mt(ul_int seed_ = 4357UL);
@@ -236,28 +292,149 @@ public:
   virtual rng* copy();
   // change the seed, return old one
   virtual ul_int set_seed(ul_int seed_);
-  // return random int in range [0, 2^32)
-  ul_int get_random();
-  // return maximum int returned by rng_mt
-  virtual ul_int get_max()
-    { return 0xffffffffUL; } // 0xffffffff = 2^32 - 1
+  // write the seed and state vector to OUT
+  virtual void save_state(binary_ofstream& out) const
+    throw (bad_request, bad_file); // binary_ofstream::put_unsigned()
+  // read the seed and state vector written by save_state() from IN
+  virtual void restore_state(binary_ifstream& in)
+    throw (bad_request, bad_file); // this
 }; // end class rng_mt
 
+// the counter based generator Philox4x32-10 of Salmon, Moraes, Dror,
+// and Shaw, ``Parallel random numbers: as easy as 1, 2, 3,'' SC11
+// (2011).
+//
+// Each block of four numbers is a counter scrambled by ten rounds of
+// multiplying and mixing in a key made from the seed.  The counter holds
+// the number of the block and of the stream it is in, so every stream
+// of a seed is independent of the others, any number in a stream may be
+// found without those before it, and a generator is only a few words of
+// state rather than a table to be shared or copied.
+class rng_philox : public rng
+{
+  static const ul_int multiplier[2]; // round multipliers
+  static const ul_int weyl[2];	// added to the key after each round
+  ul_int key[2];		// the seed, 32 bits in each word
+  ul_int counter[4];		// next block (low, high), stream (low, high)
+  ul_int block[4];		// numbers of the current block
+  int left;			// numbers of the block not yet returned
+
+private:
+  // set HIGH and LOW to the high and low 32 bits of the product of A
+  // and B (each of 32 bits)
+  static void multiply(ul_int a, ul_int b, ul_int& high, ul_int& low);
+  // scramble the counters of the next N blocks into the 4 N numbers
+  // from OUT and move counter on past them
+  void encrypt(ul_int* out, int n);
+  // move counter on by N blocks
+  void advance(ul_int n);
+protected:
+  // fill the N numbers from BEGIN with the next ones of the stream
+  virtual void generate(ul_int* begin, int n);
+public:
+  // ctor: (default) optional seed and stream
+  explicit rng_philox(ul_int seed_ = 4357UL, ul_int stream_ = 0UL);
+  // ctor: copy (the stream and position as well)
+  explicit rng_philox(const rng_philox& original);
+  // dtor: do nothing
+  ~rng_philox();
+
+  // copy current rng_philox, return pointer to it
+  virtual rng* copy();
+  // return a generator of the same seed whose stream is made from this
+  // one's and STREAM (so two levels of streams are kept apart)
+  virtual rng* new_stream(ul_int stream);
+  // change the seed, starting at the beginning of the stream, return
+  // old one
+  virtual ul_int set_seed(ul_int seed_);
+  // change the stream, starting at its beginning, return old one
+  virtual ul_int set_stream(ul_int stream)
+    throw (bad_request);
+  // return the stream
+  ul_int get_stream() const;
+  // skip the next N numbers (without making them)
+  virtual void jump(ul_int n)
+    throw (bad_request);
+  // write the seed, counter, and current block to OUT
+  virtual void save_state(binary_ofstream& out) const
+    throw (bad_request, bad_file); // binary_ofstream::put_unsigned()
+  // read the state written by save_state() from IN
+  virtual void restore_state(binary_ifstream& in)
+    throw (bad_request, bad_file); // this
+}; // end class rng_philox
+
 // inline functions
-// return random int in range [0-2^32)
+// return random int in range [0, get_max()]
+inline ul_int
+rng::get_random()
+{
+  if (numbers_left == 0)
+    {
+      fill_numbers();
+    }
+  return numbers[block_length - numbers_left--];
+}
+
+// return a random int in range [0, N)
+/* The bits of a number below the highest one N - 1 needs are masked
+ * off, and numbers still N or more thrown away.  This never biases the
+ * result the way taking the remainder does, and takes fewer than two
+ * numbers on average.  N of zero would reject every number for ever,
+ * so it gives zero without drawing one.
+ */
+inline ul_int
+rng::get_random(ul_int n)
+{
+  if (n == 0UL)
+    {
+      return 0UL;
+    }
+  ul_int mask(n - 1UL);
+  mask |= mask >> 1;
+  mask |= mask >> 2;
+  mask |= mask >> 4;
+  mask |= mask >> 8;
+  mask |= mask >> 16;
+  // an unsigned long may have more than 32 bits
+  mask |= (mask >> 16) >> 16;
+  ul_int r(get_random() & mask);
+  while (r >= n)
+    {
+      r = get_random() & mask;
+    }
+  return r;
+}
+
+// return the maximum integer reaturned by get_random()
 inline ul_int
-rng_mt::get_random()
+rng::get_max() const
 {
-  ul_int y;
+  return max;
+}
 
-  if(--left < 0)
-    return reload();
+// return random double in the range [0, MAX)
+inline double
+rng::get_random_open(double max_)
+{
+  return max_ * (get_random() * open_scale);
+}
 
-  y = *next++;
-  y ^= (y >> 11);
-  y ^= (y <<  7) & 0x9d2c5680UL;
-  y ^= (y << 15) & 0xefc60000UL;
-  return y ^ (y >> 18);
+// return random double in the range (0, MAX)
+inline double
+rng::get_random_open_open(double max_)
+{
+  return max_ * ((get_random() + 1.0e0) * open_open_scale);
+}
+
+// return a random double from the exponential distribution of mean one
+inline double
+rng::get_random_exponential()
+{
+  if (exponentials_left == 0)
+    {
+      fill_exponentials();
+    }
+  return exponentials[block_length - exponentials_left--];
 }
 
 CH_END_NAMESPACE
@@ -0,0 +1,177 @@
+// Methods to write compact binary snapshots of the surface.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cstring>		// for memcpy()
+#include "snapshot.h"
+#include "t_string.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// static instance variables
+const char* const snapshot_ofstream::magic = "CHIMPSRF";
+const unsigned int snapshot_ofstream::version = 1U;
+const unsigned int snapshot_ofstream::frames_offset = 36U;
+
+// snapshot_ofstream methods
+// ctor: open PATH and write the header for a lattice with SIZE sites
+// on a side that may hold any of SPECIES
+snapshot_ofstream::snapshot_ofstream(const CH_STD::string& path_,
+				     const model_species::seq& species,
+				     unsigned int size)
+  throw (bad_file, bad_value)
+  : binary_ofstream(path_), frames(0U), encoded(0U), width(1U), header_bytes(0U),
+    frame_bytes(0U), ids(), sites()
+{
+  // one byte is enough for most mechanisms
+  if (species.size() > 0xffffU)
+    {
+      throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		      ":snapshot_ofstream::snapshot_ofstream(): too many "
+		      "surface species (" + t_string(species.size()) + ") "
+		      "for a snapshot file");
+    }
+  if (species.size() > 0x100U)
+    {
+      if (sizeof(unsigned short) != 2U)
+	{
+	  throw bad_file(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			 ":snapshot_ofstream::snapshot_ofstream(): two byte "
+			 "species ids are not supported on this machine");
+	}
+      width = 2U;
+    }
+  // the dictionary is a length and the characters of each name
+  unsigned int names(0U);
+  for (unsigned int i(0U); i < species.size(); ++i)
+    {
+      ids.insert(CH_STD::make_pair(species[i], i));
+      names += 4U + species[i]->get_name().size();
+    }
+  header_bytes = (frames_offset + 12U + names + 7U) & ~7U;
+  sites.resize(size * size * width);
+  frame_bytes = (16U + sites.size() + 7U) & ~7U;
+  // write the header
+  put_header(magic, version);
+  put_unsigned(size);
+  put_unsigned(width);
+  put_unsigned(species.size());
+  put_unsigned(frames);
+  put_unsigned(header_bytes);
+  put_unsigned(frame_bytes);
+  for (model_species::seq_citer it(species.begin()); it != species.end();
+       ++it)
+    {
+      put_string((*it)->get_name());
+    }
+  put_padding(frames_offset + 12U + names);
+  flush();
+}
+
+// dtor: do nothing
+snapshot_ofstream::~snapshot_ofstream()
+{}
+
+// snapshot_ofstream private methods
+// write zeros until the file is a multiple of 8 bytes long
+void
+snapshot_ofstream::put_padding(unsigned int written)
+  throw (bad_file)
+{
+  static const char zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  if (written % 8U != 0U)
+    {
+      put_bytes(zeros, 8U - written % 8U);
+    }
+  return;
+}
+
+// snapshot_ofstream public methods
+// append a frame of SURFACE at X after STEPS kmc steps
+void
+snapshot_ofstream::put_frame(double x, unsigned int steps,
+			     const lattice& surface)
+  throw (bad_file, bad_request, bad_value)
+{
+  CH_STD::string frame;
+  encode_frame(x, steps, surface, frame);
+  put_encoded(frame);
+  return;
+}
+
+// put the next frame, of SURFACE at X after STEPS kmc steps, in FRAME
+void
+snapshot_ofstream::encode_frame(double x, unsigned int steps,
+				const lattice& surface, CH_STD::string& frame)
+  throw (bad_request, bad_value)
+{
+  if (surface.get_size() * surface.get_size() * width != sites.size())
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":snapshot_ofstream::encode_frame(): lattice size ("
+			+ t_string(surface.get_size()) + ") is not the size "
+			"the snapshot file was created for");
+    }
+  // the frame is zero padded
+  frame.assign(frame_bytes, '\0');
+  CH_STD::memcpy(&frame[0], &x, sizeof(x));
+  CH_STD::memcpy(&frame[8], &steps, sizeof(steps));
+  CH_STD::memcpy(&frame[12], &encoded, sizeof(encoded));
+  if (!sites.empty())
+    {
+      surface.encode(ids, width, &sites[0]);
+      CH_STD::memcpy(&frame[16], &sites[0], sites.size());
+    }
+  ++encoded;
+  return;
+}
+
+// append FRAME, made by encode_frame(), to the file
+void
+snapshot_ofstream::put_encoded(const CH_STD::string& frame)
+  throw (bad_file)
+{
+  put_bytes(frame.data(), frame.size());
+  // update the frame count in the header, so the file is always complete
+  ++frames;
+  seekp(frames_offset);
+  put_unsigned(frames);
+  seekp(0, CH_STD::ios::end);
+  return;
+}
+
+// append the encoded FRAME to STREAM, a snapshot_ofstream
+void
+snapshot_ofstream::put_encoded(CH_STD::ostream& stream,
+			       const CH_STD::string& frame)
+  throw (bad_file)
+{
+  // the writer only hands this sink the stream it was given with it
+  static_cast<snapshot_ofstream&>(stream).put_encoded(frame);
+  return;
+}
+
+CH_END_NAMESPACE
+
+/* $Id$ */
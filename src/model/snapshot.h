@@ -0,0 +1,117 @@
+// -*- C++ -*-
+// Compact binary snapshots of the kinetic Monte Carlo surface.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_MODEL_SNAPSHOT_H
+#define CH_MODEL_SNAPSHOT_H 1
+
+#include <map>
+#include <string>
+#include <vector>
+#include "except.h"
+#include "file.h"
+#include "lattice.h"
+#include "species.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// file of surface snapshots, one fixed size frame per output point
+//
+// Everything is in the byte order of the machine that wrote the file,
+// which readers can check using the byte order marks.  Offsets are in
+// bytes from the start of the file.
+//
+//   0  magic "CHIMPSRF"
+//   8  format version (32 bit unsigned)
+//  12  byte order mark 0x01020304 (32 bit unsigned)
+//  16  byte order mark 1.0 (64 bit double)
+//  24  lattice size, sites per row (32 bit unsigned)
+//  28  bytes per site, 1 or 2 (32 bit unsigned)
+//  32  number of species (32 bit unsigned)
+//  36  number of frames (32 bit unsigned, updated after each frame)
+//  40  header bytes, the offset of frame 0 (32 bit unsigned)
+//  44  frame bytes (32 bit unsigned)
+//  48  species names, each a 32 bit length and its characters, whose
+//      position in the list is their id, padded with zeros to 8 bytes
+//
+// Frame k starts at header bytes + k * frame bytes and holds
+//
+//   0  x (64 bit double)
+//   8  kmc steps (32 bit unsigned)
+//  12  frame index k (32 bit unsigned)
+//  16  the species id of every site, row by row, padded with zeros to
+//      8 bytes
+//
+// so readers can seek straight to any frame, or map the file into
+// memory and use it in place.
+class snapshot_ofstream : public binary_ofstream
+{
+  unsigned int frames;		// number of frames written
+  unsigned int encoded;		// number of frames encoded
+  unsigned int width;		// bytes used for each site
+  unsigned int header_bytes;	// offset of the first frame
+  unsigned int frame_bytes;	// size of each frame
+  CH_STD::map<model_species*,unsigned int> ids; // id of each species
+  CH_STD::vector<unsigned char> sites; // species ids of the current frame
+
+  static const char* const magic; // start of snapshot files
+  static const unsigned int version; // their format version
+  static const unsigned int frames_offset; // where the frame count is
+
+private:
+  // prevent copy construction and assignment
+  snapshot_ofstream(const snapshot_ofstream&);
+  snapshot_ofstream& operator=(const snapshot_ofstream&);
+  // write zeros until the file is a multiple of 8 bytes long
+  void put_padding(unsigned int written)
+    throw (bad_file); // put_bytes()
+public:
+  // ctor: open PATH and write the header for a lattice with SIZE sites
+  // on a side that may hold any of SPECIES
+  snapshot_ofstream(const CH_STD::string& path_,
+		    const model_species::seq& species, unsigned int size)
+    throw (bad_file, bad_value); // this, binary_ofstream()
+  // dtor: parent will close stream if still open
+  ~snapshot_ofstream();
+
+  // append a frame of SURFACE at X after STEPS kmc steps
+  void put_frame(double x, unsigned int steps, const lattice& surface)
+    throw (bad_file, bad_request, bad_value); // encode_frame(),
+				// put_encoded()
+  // put the next frame, of SURFACE at X after STEPS kmc steps, in FRAME
+  void encode_frame(double x, unsigned int steps, const lattice& surface,
+		    CH_STD::string& frame)
+    throw (bad_request, bad_value); // this, lattice::encode()
+  // append FRAME, made by encode_frame(), to the file
+  void put_encoded(const CH_STD::string& frame)
+    throw (bad_file); // this
+  // append the encoded FRAME to STREAM, a snapshot_ofstream (this is an
+  // output_writer::sink)
+  static void put_encoded(CH_STD::ostream& stream,
+			  const CH_STD::string& frame)
+    throw (bad_file); // put_encoded()
+}; // end class snapshot_ofstream
+
+CH_END_NAMESPACE
+
+#endif // not CH_MODEL_SNAPSHOT_H
+
+/* $Id$ */
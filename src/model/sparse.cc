@@ -0,0 +1,276 @@
+// Methods for the LU factorization of sparse matrices.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "sparse.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iterator>
+#include <set>
+#include <utility>
+#include "t_string.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// static instance variables
+const unsigned int sparse_lu::npos = ~0U;
+
+// sparse_lu methods
+// ctor: (default) no matrix
+sparse_lu::sparse_lu()
+  : order(), lu_start(1U, 0U), lu_columns(), lu_diagonal(), positions(),
+    matrix_rows(), lu(), work(), where()
+{}
+
+// dtor: do nothing
+sparse_lu::~sparse_lu()
+{}
+
+// sparse_lu public methods
+// find the order and the pattern of the factors
+/* The pattern is made symmetric, and the rows eliminated in order of
+ * fewest neighbors left, each elimination joining the neighbors of the
+ * row to each other.  The neighbors of a row when it is eliminated are
+ * the columns of its row of U and the rows of its column of L.
+ */
+void
+sparse_lu::analyze(const index_seq& row_start, const index_seq& columns)
+  throw (bad_value)
+{
+  unsigned int n(row_start.size() - 1U);
+  // find the symmetric pattern, making sure of the diagonals
+  CH_STD::vector<index_seq> adjacent(n);
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      bool diagonal(false);
+      for (unsigned int q(row_start[i]); q < row_start[i + 1U]; ++q)
+	{
+	  unsigned int j(columns[q]);
+	  if (j >= n)
+	    {
+	      throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":sparse_lu::analyze(): column " + t_string(j) +
+			      " of row " + t_string(i) + " is not in a matrix "
+			      "of " + t_string(n) + " columns");
+	    }
+	  if (j == i)
+	    {
+	      diagonal = true;
+	    }
+	  else
+	    {
+	      adjacent[i].push_back(j);
+	      adjacent[j].push_back(i);
+	    }
+	}
+      if (!diagonal)
+	{
+	  throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			  ":sparse_lu::analyze(): row " + t_string(i) +
+			  " has no diagonal");
+	}
+    }
+  // keep each list of neighbors sorted, without repeats
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      CH_STD::sort(adjacent[i].begin(), adjacent[i].end());
+      adjacent[i].erase(CH_STD::unique(adjacent[i].begin(), adjacent[i].end()),
+			adjacent[i].end());
+    }
+  // eliminate the rows with the fewest neighbors first
+  CH_STD::set<CH_STD::pair<unsigned int,unsigned int> > degrees;
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      degrees.insert(CH_STD::make_pair(adjacent[i].size(), i));
+    }
+  index_seq rank(n);
+  CH_STD::vector<index_seq> later(n);
+  index_seq joined;
+  order.clear();
+  order.reserve(n);
+  while (!degrees.empty())
+    {
+      unsigned int v(degrees.begin()->second);
+      degrees.erase(degrees.begin());
+      rank[v] = order.size();
+      order.push_back(v);
+      later[v].swap(adjacent[v]);
+      // join its neighbors to each other, merging the sorted lists
+      for (index_seq::const_iterator a(later[v].begin());
+	   a != later[v].end(); ++a)
+	{
+	  index_seq& neighbors(adjacent[*a]);
+	  degrees.erase(CH_STD::make_pair(neighbors.size(), *a));
+	  joined.clear();
+	  CH_STD::set_union(neighbors.begin(), neighbors.end(),
+			    later[v].begin(), later[v].end(),
+			    CH_STD::back_inserter(joined));
+	  // drop v and the neighbor itself
+	  joined.erase(CH_STD::lower_bound(joined.begin(), joined.end(), v));
+	  joined.erase(CH_STD::lower_bound(joined.begin(), joined.end(), *a));
+	  neighbors.swap(joined);
+	  degrees.insert(CH_STD::make_pair(neighbors.size(), *a));
+	}
+    }
+  // lay out the rows of the factors in the new order
+  CH_STD::vector<index_seq> rows(n);
+  for (unsigned int v(0U); v < n; ++v)
+    {
+      rows[rank[v]].push_back(rank[v]);
+      for (index_seq::const_iterator w(later[v].begin()); w != later[v].end();
+	   ++w)
+	{
+	  rows[rank[v]].push_back(rank[*w]);
+	  rows[rank[*w]].push_back(rank[v]);
+	}
+    }
+  lu_start.assign(1U, 0U);
+  lu_columns.clear();
+  lu_diagonal.resize(n);
+  for (unsigned int p(0U); p < n; ++p)
+    {
+      CH_STD::sort(rows[p].begin(), rows[p].end());
+      lu_diagonal[p] = lu_columns.size()
+	+ (CH_STD::find(rows[p].begin(), rows[p].end(), p) - rows[p].begin());
+      lu_columns.insert(lu_columns.end(), rows[p].begin(), rows[p].end());
+      lu_start.push_back(lu_columns.size());
+    }
+  // find where each nonzero of the matrix goes
+  positions.resize(columns.size());
+  matrix_rows.resize(columns.size());
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      unsigned int p(rank[i]);
+      for (unsigned int q(row_start[i]); q < row_start[i + 1U]; ++q)
+	{
+	  positions[q] = CH_STD::lower_bound(lu_columns.begin() + lu_start[p],
+					     lu_columns.begin()
+					     + lu_start[p + 1U],
+					     rank[columns[q]])
+	    - lu_columns.begin();
+	  matrix_rows[q] = p;
+	}
+    }
+  lu.assign(lu_columns.size(), 0.0e0);
+  work.assign(n, 0.0e0);
+  where.assign(n, npos);
+  return;
+}
+
+// factor the matrix with the nonzeros VALUES, return false if a pivot
+// is too small
+/* Each row is reduced by the rows of U above it that its row of L
+ * names, in order; the pattern of the factors holds every nonzero this
+ * makes.  A pivot is too small if it is lost in the rounding of the
+ * largest nonzero of its row.
+ */
+bool
+sparse_lu::factor(const CH_STD::vector<double>& values)
+{
+  unsigned int n(order.size());
+  CH_STD::fill(lu.begin(), lu.end(), 0.0e0);
+  // the size of each row is kept in work
+  CH_STD::fill(work.begin(), work.end(), 0.0e0);
+  for (unsigned int q(0U); q < values.size(); ++q)
+    {
+      lu[positions[q]] += values[q];
+      work[matrix_rows[q]] = CH_STD::max(work[matrix_rows[q]],
+					 CH_STD::fabs(values[q]));
+    }
+  for (unsigned int p(0U); p < n; ++p)
+    {
+      for (unsigned int t(lu_start[p]); t < lu_start[p + 1U]; ++t)
+	{
+	  where[lu_columns[t]] = t;
+	}
+      for (unsigned int t(lu_start[p]); t < lu_diagonal[p]; ++t)
+	{
+	  unsigned int c(lu_columns[t]);
+	  double l(lu[t] /= lu[lu_diagonal[c]]);
+	  if (l != 0.0e0)
+	    {
+	      for (unsigned int u(lu_diagonal[c] + 1U); u < lu_start[c + 1U];
+		   ++u)
+		{
+		  lu[where[lu_columns[u]]] -= l * lu[u];
+		}
+	    }
+	}
+      for (unsigned int t(lu_start[p]); t < lu_start[p + 1U]; ++t)
+	{
+	  where[lu_columns[t]] = npos;
+	}
+      // false for NaN too
+      if (!(CH_STD::fabs(lu[lu_diagonal[p]]) > DBL_EPSILON * work[p]))
+	{
+	  return false;
+	}
+    }
+  return true;
+}
+
+// replace RHS by the solution of the factored matrix
+void
+sparse_lu::solve(CH_STD::vector<double>& rhs) const
+{
+  unsigned int n(order.size());
+  for (unsigned int p(0U); p < n; ++p)
+    {
+      work[p] = rhs[order[p]];
+    }
+  // forward through the unit lower factor
+  for (unsigned int p(0U); p < n; ++p)
+    {
+      for (unsigned int t(lu_start[p]); t < lu_diagonal[p]; ++t)
+	{
+	  work[p] -= lu[t] * work[lu_columns[t]];
+	}
+    }
+  // back through the upper factor
+  for (unsigned int p(n); p-- > 0U;)
+    {
+      for (unsigned int t(lu_diagonal[p] + 1U); t < lu_start[p + 1U]; ++t)
+	{
+	  work[p] -= lu[t] * work[lu_columns[t]];
+	}
+      work[p] /= lu[lu_diagonal[p]];
+    }
+  for (unsigned int p(0U); p < n; ++p)
+    {
+      rhs[order[p]] = work[p];
+    }
+  return;
+}
+
+// return the number of nonzeros in the factors
+unsigned int
+sparse_lu::get_factor_nonzeros() const
+{
+  return lu_columns.size();
+}
+
+CH_END_NAMESPACE
+
+/* $Id$ */
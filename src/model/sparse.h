@@ -0,0 +1,88 @@
+// -*- C++ -*-
+// Class for the LU factorization of sparse matrices.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_MODEL_SPARSE_H
+#define CH_MODEL_SPARSE_H 1
+
+#include <vector>
+#include "except.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// LU factorization of square matrices with a fixed pattern of nonzeros
+//
+// The matrices are stored by rows (compressed sparse rows): the columns
+// of the nonzeros of row i are in positions row_start[i] up to
+// row_start[i + 1], and every row has its diagonal.  The pattern is
+// analyzed once: the rows and columns are ordered to keep the fill-in
+// small (minimum degree on the symmetric pattern) and the pattern of the
+// factors found.  Each factorization after that only does arithmetic on
+// the nonzeros of the factors.  The pivots are the diagonal of the
+// ordered matrix, which suits matrices near the identity, such as the
+// iteration matrices of implicit integrators; a pivot that is too small
+// makes the factorization fail rather than the solution inaccurate.
+class sparse_lu
+{
+public:
+  // set up typedef's
+  typedef CH_STD::vector<unsigned int> index_seq;
+
+private:
+  index_seq order;		// original row of each row of the factors
+  index_seq lu_start;		// start of each row of the factors
+  index_seq lu_columns;		// column of each nonzero of the factors
+  index_seq lu_diagonal;	// position of the diagonal of each row
+  index_seq positions;		// where each matrix nonzero is in the factors
+  index_seq matrix_rows;	// (ordered) row of each matrix nonzero
+  CH_STD::vector<double> lu;	// the factors, L below the unit diagonal
+  mutable CH_STD::vector<double> work; // scratch for solve()
+  index_seq where;		// position of each column in the current row
+  static const unsigned int npos; // column not in the current row
+
+private:
+  // prevent copy construction and assignment
+  sparse_lu(const sparse_lu&);
+  sparse_lu& operator=(const sparse_lu&);
+public:
+  // ctor: (default) no matrix
+  sparse_lu();
+  // dtor: do nothing
+  ~sparse_lu();
+
+  // find the order and the pattern of the factors of matrices with the
+  // nonzeros in ROW_START and COLUMNS
+  void analyze(const index_seq& row_start, const index_seq& columns)
+    throw (bad_value); // this
+  // factor the matrix with the nonzeros VALUES (in the analyzed
+  // pattern), return false if a pivot is too small
+  bool factor(const CH_STD::vector<double>& values);
+  // replace RHS by the solution of the factored matrix
+  void solve(CH_STD::vector<double>& rhs) const;
+  // return the number of nonzeros in the factors
+  unsigned int get_factor_nonzeros() const;
+}; // end class sparse_lu
+
+CH_END_NAMESPACE
+
+#endif // not CH_MODEL_SPARSE_H
+
+/* $Id$ */
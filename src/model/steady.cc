@@ -0,0 +1,687 @@
+// Methods to solve directly for the steady state of a CSTR.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "steady.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include "compare.h"
+#include "cstr.h"
+#include "debug.h"
+#include "precision.h"
+#include "quantity.h"
+#include "reaction.h"
+#include "reactor.h"
+#include "t_string.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// static instance variables
+const double steady::min_damping = 1.0e0 / 64.0e0;
+const double steady::min_growth = 2.0e0;
+const double steady::max_growth = 10.0e0;
+
+// steady methods
+// ctor: (default) set the default tolerances
+steady::steady()
+  : integrator(), relative_tolerance(1.0e-8), absolute_tolerance(1.0e-12),
+    max_iterations(200U), species(), empty(0U), solved(false), y(),
+    residual(), total_change(0.0e0), fraction(), fraction_slope(), weights(),
+    rates(), row_start(), columns(), diagonal(), positions(), jacobian(),
+    column_sums(), iteration(), matrix(), iterations(0U), newton_steps(0U),
+    failed_steps(0U), evaluations(0U), factorizations(0U)
+{}
+
+// ctor: copy the tolerances (the solution is set up by initialize())
+steady::steady(const steady& o)
+  throw (bad_pointer)
+  : integrator(o), relative_tolerance(o.relative_tolerance),
+    absolute_tolerance(o.absolute_tolerance),
+    max_iterations(o.max_iterations), species(), empty(0U), solved(false),
+    y(), residual(), total_change(0.0e0), fraction(), fraction_slope(),
+    weights(), rates(), row_start(), columns(), diagonal(), positions(),
+    jacobian(), column_sums(), iteration(), matrix(), iterations(0U),
+    newton_steps(0U), failed_steps(0U), evaluations(0U), factorizations(0U)
+{}
+
+// dtor: do nothing
+steady::~steady()
+{}
+
+// steady private methods
+// set up the variables and the patterns of the matrices
+/* The row of the empty sites holds the balance of the sites, so it has
+ * the column of every surface species besides those of its reactions,
+ * and the flow out, a share of the change of all the fluids, gives each
+ * fluid row the columns of every fluid row.
+ */
+void
+steady::initialize()
+  throw (bad_pointer, bad_input, bad_value, bad_type, bad_request,
+	 bad_file)
+{
+  // call the base class initializer
+  integrator::initialize();
+  reactor* rctr(state_info->get_reactor());
+  // only the CSTR has a steady state apart from equilibrium
+  if (dynamic_cast<cstr*>(rctr) == 0)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":steady::initialize(): the steady integrator can "
+			"only solve for the steady state of a CSTR");
+    }
+  if (CH_STD::fabs(rctr->get_heating_rate()) > precision::get().get_double())
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":steady::initialize(): the steady integrator needs "
+			"a constant temperature, but the heating rate is "
+			+ t_string(rctr->get_heating_rate()));
+    }
+  // every species of the mechanism is a variable
+  species.assign(mech->species_seq_begin(), mech->species_seq_end());
+  unsigned int n(species.size());
+  // the sites not covered by the initial coverages are empty (the
+  // quantity of a surface species is its coverage, whatever the type)
+  model_species* empty_sites(mech->get_species("@"));
+  if (empty_sites != 0 && !state_info->get_previous_values())
+    {
+      double covered(0.0e0);
+      for (model_species::seq_citer it(species.begin());
+	   it != species.end(); ++it)
+	{
+	  if (*it != empty_sites)
+	    {
+	      covered += (*it)->get_surface_coordination()
+		* (*it)->get_quantity(quantity::Econcentration);
+	    }
+	}
+      empty_sites->set_quantity(quantity::Econcentration,
+				CH_STD::max(1.0e0 - covered, 0.0e0));
+    }
+  empty = n;
+  y.resize(n);
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      if (species[i] == empty_sites)
+	{
+	  empty = i;
+	}
+      // surface species ignore the type and give their coverage
+      y[i] = species[i]->get_quantity(rctr->get_fluid_type());
+    }
+  // the pattern of the rates, with the balance of the sites
+  rates.analyze(species, mech->reaction_seq_begin(), mech->reaction_seq_end());
+  const rate_jacobian::index_seq& rate_start(rates.get_row_start());
+  const rate_jacobian::index_seq& rate_columns(rates.get_columns());
+  sparse_lu::index_seq fluid_columns;
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      if (species[i]->get_surface_coordination() == 0U)
+	{
+	  fluid_columns.insert(fluid_columns.end(),
+			       rate_columns.begin() + rate_start[i],
+			       rate_columns.begin() + rate_start[i + 1U]);
+	}
+    }
+  row_start.assign(1U, 0U);
+  columns.clear();
+  diagonal.resize(n);
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      sparse_lu::index_seq row(rate_columns.begin() + rate_start[i],
+			       rate_columns.begin() + rate_start[i + 1U]);
+      if (species[i]->get_surface_coordination() == 0U)
+	{
+	  row.insert(row.end(), fluid_columns.begin(), fluid_columns.end());
+	  CH_STD::sort(row.begin(), row.end());
+	  row.erase(CH_STD::unique(row.begin(), row.end()), row.end());
+	}
+      else if (i == empty)
+	{
+	  for (unsigned int j(0U); j < n; ++j)
+	    {
+	      if (species[j]->get_surface_coordination() > 0U)
+		{
+		  row.push_back(j);
+		}
+	    }
+	  CH_STD::sort(row.begin(), row.end());
+	  row.erase(CH_STD::unique(row.begin(), row.end()), row.end());
+	}
+      diagonal[i] = columns.size()
+	+ (CH_STD::lower_bound(row.begin(), row.end(), i) - row.begin());
+      columns.insert(columns.end(), row.begin(), row.end());
+      row_start.push_back(columns.size());
+    }
+  positions.resize(rate_columns.size());
+  for (unsigned int i(0U); i < n; ++i)
+    {
+      for (unsigned int p(rate_start[i]); p < rate_start[i + 1U]; ++p)
+	{
+	  sparse_lu::index_seq::const_iterator row(columns.begin()
+						   + row_start[i]);
+	  sparse_lu::index_seq::const_iterator row_end(columns.begin()
+						       + row_start[i + 1U]);
+	  positions[p] = CH_STD::lower_bound(row, row_end, rate_columns[p])
+	    - columns.begin();
+	}
+    }
+  iteration.analyze(row_start, columns);
+  jacobian.assign(columns.size(), 0.0e0);
+  matrix.assign(columns.size(), 0.0e0);
+  column_sums.assign(n, 0.0e0);
+  residual.assign(n, 0.0e0);
+  fraction.assign(n, 0.0e0);
+  fraction_slope.assign(n, 0.0e0);
+  weights.assign(n, 1.0e0);
+  total_change = 0.0e0;
+  solved = false;
+  iterations = 0U;
+  newton_steps = 0U;
+  failed_steps = 0U;
+  evaluations = 0U;
+  factorizations = 0U;
+  return;
+}
+
+// find the steady state if not yet found, and return XF
+double
+steady::step(double /* xi */, double xf)
+  throw (bad_pointer, bad_value, bad_type)
+{
+  if (!solved)
+    {
+      solve_steady();
+      solved = true;
+    }
+  // put the steady state and its flows into the species and reactor
+  find_residual(y, residual);
+  state_info->get_reactor()->set_outflow(species, total_change);
+  return xf;
+}
+
+// output the column headings, followed by that of the iterations
+void
+steady::output_header()
+{
+  // call base class method
+  integrator::output_header();
+  // output header for the iterations
+  *out_file << "\titerations" << CH_STD::endl;
+  return;
+}
+
+// output the current output point and its values to *out_file
+void
+steady::output(double x_)
+  throw (bad_type, bad_request, bad_value, bad_file)
+{
+  output(x_, *out_file);
+  return;
+}
+
+// output the current output point, its values and the iterations taken
+void
+steady::output(double x_, CH_STD::ostream& output_stream)
+  throw (bad_type, bad_request, bad_value, bad_file)
+{
+  // call base class method
+  integrator::output(x_, output_stream);
+  // output the number of iterations
+  output_stream << '\t' << iterations << '\n';
+  return;
+}
+
+// report the work done, if debugging
+void
+steady::finish()
+  throw (bad_file)
+{
+  if (debug::get().get_level() > 0U)
+    {
+      debug::get().get_stream() << "steady: converged in " << iterations
+				<< " iterations (" << newton_steps
+				<< " newton, " << failed_steps
+				<< " failed), " << evaluations
+				<< " evaluations, " << factorizations
+				<< " factorizations (" << jacobian.size()
+				<< " nonzeros, "
+				<< iteration.get_factor_nonzeros()
+				<< " in the factors)" << CH_STD::endl;
+    }
+  return;
+}
+
+// put the quantities VALUES into the species
+void
+steady::set_values(const CH_STD::vector<double>& values)
+  throw (bad_value, bad_type)
+{
+  quantity::type type(state_info->get_reactor()->get_fluid_type());
+  for (unsigned int i(0U); i < species.size(); ++i)
+    {
+      species[i]->set_quantity(type, values[i]);
+    }
+  return;
+}
+
+// put the residual of the quantities VALUES into RESULT, return its norm
+/* The residual of each species is its rate of change, s_i - u_i S (see
+ * cstr), except that of the empty sites, which is the part of the sites
+ * not covered.
+ */
+double
+steady::find_residual(const CH_STD::vector<double>& values,
+		      CH_STD::vector<double>& result)
+  throw (bad_pointer, bad_value, bad_type)
+{
+  ++evaluations;
+  set_values(values);
+  // add up the rates of the reactions of each species
+  reactor* rctr(state_info->get_reactor());
+  mech->get_kernel().rate_derivatives(rctr->get_temperature());
+  // put them in the units of the reactor, with the flow in
+  total_change = 0.0e0;
+  for (unsigned int i(0U); i < species.size(); ++i)
+    {
+      result[i] = rctr->reactor_eqn(species[i]);
+      if (species[i]->get_surface_coordination() == 0U)
+	{
+	  total_change += result[i];
+	}
+    }
+  // and take away the flow out
+  for (unsigned int i(0U); i < species.size(); ++i)
+    {
+      double share_slope(0.0e0);
+      result[i] -= rctr->outflow_fraction(species[i], share_slope)
+	* total_change;
+    }
+  if (empty < species.size())
+    {
+      double uncovered(1.0e0);
+      for (unsigned int i(0U); i < species.size(); ++i)
+	{
+	  uncovered -= species[i]->get_surface_coordination() * values[i];
+	}
+      result[empty] = uncovered;
+    }
+  return norm(result);
+}
+
+// find the jacobian at y
+/* The jacobian of the equations is that of s_i, less S du_i/dy_i on the
+ * diagonal, less u_i times the sums of the columns of the fluid rows
+ * (the gradient of S).  The residual is found at y again to put the
+ * quantities there.
+ */
+void
+steady::find_jacobian()
+  throw (bad_pointer, bad_value, bad_type)
+{
+  find_residual(y, residual);
+  reactor* rctr(state_info->get_reactor());
+  rates.evaluate(rctr->get_temperature());
+  const rate_jacobian::index_seq& rate_start(rates.get_row_start());
+  const rate_jacobian::index_seq& rate_columns(rates.get_columns());
+  const CH_STD::vector<double>& values(rates.get_values());
+  CH_STD::fill(jacobian.begin(), jacobian.end(), 0.0e0);
+  CH_STD::fill(column_sums.begin(), column_sums.end(), 0.0e0);
+  CH_STD::fill(fraction.begin(), fraction.end(), 0.0e0);
+  for (unsigned int i(0U); i < species.size(); ++i)
+    {
+      if (i == empty)
+	{
+	  // the balance of the sites
+	  for (unsigned int p(row_start[i]); p < row_start[i + 1U]; ++p)
+	    {
+	      jacobian[p] = - (double)
+		species[columns[p]]->get_surface_coordination();
+	    }
+	  continue;		// for (i)
+	}
+      fraction[i] = rctr->outflow_fraction(species[i], fraction_slope[i]);
+      double quantity_slope(0.0e0);
+      double slope(rctr->reactor_eqn_slope(species[i], quantity_slope));
+      bool fluid(species[i]->get_surface_coordination() == 0U);
+      for (unsigned int p(rate_start[i]); p < rate_start[i + 1U]; ++p)
+	{
+	  double partial(slope * values[p]);
+	  jacobian[positions[p]] = partial;
+	  if (fluid)
+	    {
+	      column_sums[rate_columns[p]] += partial;
+	    }
+	}
+      jacobian[diagonal[i]] += quantity_slope
+	- fraction_slope[i] * total_change;
+      if (fluid)
+	{
+	  column_sums[i] += quantity_slope;
+	}
+    }
+  // the flow out takes its share of the change of all the fluids
+  for (unsigned int i(0U); i < species.size(); ++i)
+    {
+      if (fraction[i] != 0.0e0)
+	{
+	  for (unsigned int p(row_start[i]); p < row_start[i + 1U]; ++p)
+	    {
+	      jacobian[p] -= fraction[i] * column_sums[columns[p]];
+	    }
+	}
+    }
+  return;
+}
+
+// factor the iteration matrix for the pseudo time step DT, return false
+// if it is singular
+/* The balance of the sites has no pseudo time derivative.
+ */
+bool
+steady::factor(double dt)
+{
+  ++factorizations;
+  for (unsigned int p(0U); p < jacobian.size(); ++p)
+    {
+      matrix[p] = - jacobian[p];
+    }
+  if (dt > 0.0e0)
+    {
+      for (unsigned int i(0U); i < diagonal.size(); ++i)
+	{
+	  if (i != empty)
+	    {
+	      matrix[diagonal[i]] += 1.0e0 / dt;
+	    }
+	}
+    }
+  return iteration.factor(matrix);
+}
+
+// return the largest of the magnitudes of VALUES times the weights
+double
+steady::norm(const CH_STD::vector<double>& values) const
+{
+  double largest(0.0e0);
+  for (unsigned int i(0U); i < values.size(); ++i)
+    {
+      largest = CH_STD::max(largest, CH_STD::fabs(values[i] * weights[i]));
+    }
+  return largest;
+}
+
+// put Y plus LAMBDA times CHANGE, kept in range, into VALUES
+void
+steady::move(const CH_STD::vector<double>& change, double lambda,
+	     CH_STD::vector<double>& values) const
+{
+  values.resize(y.size());
+  for (unsigned int i(0U); i < y.size(); ++i)
+    {
+      values[i] = CH_STD::max(y[i] + lambda * change[i], 0.0e0);
+      if (species[i]->get_surface_coordination() > 0U)
+	{
+	  values[i] = CH_STD::min(values[i], 1.0e0);
+	}
+    }
+  return;
+}
+
+// find the steady state from y
+/* Each newton step is halved until the simplified newton step from
+ * where it leads (using the same factors) is shorter by enough; the
+ * state is steady once a full step changes no quantity by more than its
+ * tolerance.  If no fraction of the step will do, or the matrix is
+ * singular, pseudo time steps are taken instead, starting short enough
+ * to change the quantities by about their size and lengthened at least
+ * twofold each step, more as the residual falls, until it has fallen a
+ * hundredfold.
+ */
+void
+steady::solve_steady()
+  throw (bad_pointer, bad_value, bad_type)
+{
+  unsigned int n(y.size());
+  CH_STD::vector<double> change(n);
+  CH_STD::vector<double> trial(n);
+  CH_STD::vector<double> trial_residual(n);
+  CH_STD::vector<double> simplified(n);
+  // anything larger is not finite
+  double largest(CH_STD::numeric_limits<double>::max());
+  bool newton(true);
+  bool current(false);		// is the jacobian for y
+  double dt(0.0e0);
+  double start_norm(0.0e0);
+  while (iterations < max_iterations)
+    {
+      ++iterations;
+      if (!current)
+	{
+	  // the tolerances of the current quantities
+	  for (unsigned int i(0U); i < n; ++i)
+	    {
+	      weights[i] = 1.0e0 / (relative_tolerance * CH_STD::fabs(y[i])
+				    + absolute_tolerance);
+	    }
+	  find_jacobian();
+	  current = true;
+	}
+      double residual_norm(norm(residual));
+      if (newton)
+	{
+	  bool accepted(false);
+	  if (factor(0.0e0))
+	    {
+	      change = residual;
+	      iteration.solve(change);
+	      double change_norm(norm(change));
+	      for (double lambda(1.0e0); lambda >= min_damping; lambda *= 0.5e0)
+		{
+		  move(change, lambda, trial);
+		  if (!(find_residual(trial, trial_residual) <= largest))
+		    {
+		      continue;	// for (lambda)
+		    }
+		  // natural monotonicity test
+		  simplified = trial_residual;
+		  iteration.solve(simplified);
+		  double bound((1.0e0 - 0.25e0 * lambda) * change_norm);
+		  if (norm(simplified) <= bound)
+		    {
+		      if (lambda == 1.0e0 && change_norm <= 1.0e0)
+			{
+			  // converged
+			  ++newton_steps;
+			  y.swap(trial);
+			  return;
+			}
+		      accepted = true;
+		      break;	// for (lambda)
+		    }
+		}
+	    }
+	  if (accepted)
+	    {
+	      ++newton_steps;
+	      y.swap(trial);
+	      current = false;
+	      continue;		// while ()
+	    }
+	  // fall back on pseudo time steps
+	  ++failed_steps;
+	  newton = false;
+	  start_norm = residual_norm;
+	  dt = 1.0e0 / (relative_tolerance * residual_norm);
+	  continue;		// while ()
+	}
+      if (!factor(dt))
+	{
+	  ++failed_steps;
+	  dt *= 0.25e0;
+	  continue;		// while ()
+	}
+      change = residual;
+      iteration.solve(change);
+      move(change, 1.0e0, trial);
+      double trial_norm(find_residual(trial, trial_residual));
+      if (!(trial_norm <= max_growth * residual_norm))
+	{
+	  ++failed_steps;
+	  dt *= 0.25e0;
+	  continue;		// while ()
+	}
+      // switched evolution relaxation, but always lengthening the step
+      dt *= CH_STD::min(max_growth, CH_STD::max(min_growth,
+						residual_norm / trial_norm));
+      y.swap(trial);
+      current = false;
+      if (trial_norm <= 1.0e-2 * start_norm)
+	{
+	  newton = true;
+	}
+    }
+  throw bad_value(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		  ":steady::solve_steady(): the steady state was not found "
+		  "in " + t_string(max_iterations) + " iterations (with "
+		  "little or no flow in, there may be no single steady "
+		  "state)");
+}
+
+// steady public methods
+// parse integrator input
+void
+steady::parse(token_seq_citer& token_it, token_seq_citer end)
+  throw (bad_input, bad_request, bad_value, bad_type, bad_pointer)
+{
+  // loop through input
+  while (token_it != end)
+    {
+      if (icompare(*token_it, "begin") == 0)
+	{
+	  ++token_it;		// next token
+	  if (icompare(*token_it, "state") == 0)
+	    {
+	      // call the state parser
+	      state_info->parse(++token_it, end);
+	      continue;		// while ()
+	    }
+	  else
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":steady::parse(): syntax error in input "
+			      "for integrator: do not know how to begin "
+			      + *token_it);
+	    }
+	}
+      // set the change allowed relative to each quantity
+      else if (icompare(*token_it, "relative_tolerance") == 0)
+	{
+	  relative_tolerance = CH_STD::atof((++token_it)->c_str());
+	  if (!(relative_tolerance > 0.0e0))
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":steady::parse(): syntax error in input "
+			      "for integrator: relative tolerance must be "
+			      "positive: " + *token_it);
+	    }
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set the change allowed for quantities near zero
+      else if (icompare(*token_it, "absolute_tolerance") == 0)
+	{
+	  absolute_tolerance = CH_STD::atof((++token_it)->c_str());
+	  if (!(absolute_tolerance > 0.0e0))
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":steady::parse(): syntax error in input "
+			      "for integrator: absolute tolerance must be "
+			      "positive: " + *token_it);
+	    }
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      // set the most steps to take
+      else if (icompare(*token_it, "max_iterations") == 0)
+	{
+	  int most(CH_STD::atoi((++token_it)->c_str()));
+	  if (most < 1)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":steady::parse(): syntax error in input "
+			      "for integrator: maximum iterations must be "
+			      "positive: " + *token_it);
+	    }
+	  max_iterations = (unsigned int) most;
+	  // increment token
+	  ++token_it;
+	  continue;		// while ()
+	}
+      else if (icompare(*token_it, "end") == 0)
+	{
+	  // make sure it is the end of integrator input
+	  if (icompare(*++token_it, "integrator") != 0)
+	    {
+	      throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			      ":steady::parse(): syntax error in input "
+			      "for integrator: corresponding end token does "
+			      "not end an integrator: " + *token_it);
+	    }
+	  // increment one further
+	  ++token_it;
+	  // return to caller
+	  return;
+	}
+      else
+	{
+	  throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			  ":steady::parse(): syntax error in input "
+			  "for integrator: unrecognized token: "
+			  + *token_it);
+	}
+    }
+  // end of file reached
+  throw bad_input(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		  "steady::parse(): syntax error in input for integrator: "
+		  "end of file reached while parsing input");
+  // shouldn't get here
+  return;
+}
+
+// create a copy of this steady state solver, return pointer to it
+integrator*
+steady::copy() const
+  throw (bad_pointer)
+{
+  return new steady(*this);
+}
+
+CH_END_NAMESPACE
+
+/* $Id$ */
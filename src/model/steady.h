@@ -0,0 +1,157 @@
+// -*- C++ -*-
+// Direct solution for the steady state of a continuous stirred-tank reactor.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_MODEL_STEADY_H
+#define CH_MODEL_STEADY_H 1
+
+#include <vector>
+#include "except.h"
+#include "integrate.h"
+#include "jacobian.h"
+#include "sparse.h"
+#include "species.h"
+#include "token.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// class for the steady state of the mean-field equations of a CSTR
+//
+// Rather than integrating through the transient, the quantities at
+// which the design equations (see cstr) give no change are solved for
+// directly, starting from the initial values of the state.  The row of
+// the empty sites is replaced by the balance of the sites, which the
+// equations otherwise only conserve.  Newton steps are damped until
+// they pass the natural monotonicity test (Deuflhard, ``Newton Methods
+// for Nonlinear Problems,'' Springer, 2004); when damping does not help,
+// implicit Euler steps in a pseudo time, lengthened as the residual
+// falls (Kelley and Keyes, SIAM J. Numer. Anal. 35, 508 (1998)), bring
+// the quantities near enough for Newton to take over.  The jacobian is
+// that of the reactions (see rate_jacobian), kept sparse, with the flow
+// out joining each fluid to everything the rates of the fluids depend
+// on.  Every output point after the start gets the steady state.
+class steady : public integrator
+{
+  double relative_tolerance;	// change allowed relative to each quantity
+  double absolute_tolerance;	// change allowed for quantities near zero
+  unsigned int max_iterations;	// most newton and pseudo-time steps
+  model_species::seq species;	// species whose quantities are solved for
+  unsigned int empty;		// row of the empty sites (size() if none)
+  bool solved;			// has the steady state been found
+  CH_STD::vector<double> y;	// current quantities
+  CH_STD::vector<double> residual; // rates of change at y
+  double total_change;		// change of all the fluids (last residual)
+  CH_STD::vector<double> fraction; // share of the flow out of each, at y
+  CH_STD::vector<double> fraction_slope; // its change with the quantity
+  CH_STD::vector<double> weights; // inverse of the change allowed
+  rate_jacobian rates;		// jacobian of the rates of the reactions
+  sparse_lu::index_seq row_start; // start of each row of the matrix
+  sparse_lu::index_seq columns;	// column of each nonzero of the matrix
+  sparse_lu::index_seq diagonal; // position of the diagonal of each row
+  sparse_lu::index_seq positions; // where each rate derivative goes
+  CH_STD::vector<double> jacobian; // of the equations
+  CH_STD::vector<double> column_sums; // of the fluid rows of the rates
+  sparse_lu iteration;		// LU factors of I / dt - J
+  CH_STD::vector<double> matrix; // I / dt - J
+  unsigned int iterations;	// steps taken
+  unsigned int newton_steps;	// of them newton steps
+  unsigned int failed_steps;	// steps rejected
+  unsigned int evaluations;	// times the residual was found
+  unsigned int factorizations;	// times the iteration matrix was factored
+  static const double min_damping; // smallest fraction of a newton step
+  static const double min_growth; // least lengthening of the pseudo time
+  static const double max_growth; // largest lengthening of the pseudo time
+
+private:
+  // prevent assignment
+  steady& operator=(const steady&);
+  // ctor: copy
+  explicit steady(const steady& original)
+    throw (bad_pointer); // integrator::integrator()
+  // set up the variables and the patterns of the matrices
+  virtual void initialize()
+    throw (bad_pointer, bad_input, bad_value, bad_type, bad_request,
+	   bad_file); // this, integrator::initialize()
+  // find the steady state if not yet found, and return XF
+  virtual double step(double xi, double xf)
+    throw (bad_pointer, bad_value, bad_type); // solve_steady(),
+				// set_values(), reactor::set_outflow()
+  // output the column headings, followed by that of the iterations
+  virtual void output_header();
+  // output the current output point and its values to *out_file
+  virtual void output(double x_)
+    throw (bad_type, bad_request, bad_value, bad_file); // output()
+  // output the current output point, its values and the iterations
+  // taken to the stream
+  virtual void output(double x_, CH_STD::ostream& output_stream)
+    throw (bad_type, bad_request, bad_value, bad_file);
+				// integrator::output()
+  // report the work done, if debugging
+  virtual void finish()
+    throw (bad_file);
+  // put the quantities VALUES into the species
+  void set_values(const CH_STD::vector<double>& values)
+    throw (bad_value, bad_type); // model_species::set_quantity()
+  // put the residual of the quantities VALUES into RESULT, return its norm
+  double find_residual(const CH_STD::vector<double>& values,
+		       CH_STD::vector<double>& result)
+    throw (bad_pointer, bad_value, bad_type); // set_values(),
+				// rate_kernel::rate_derivatives(),
+				// reactor::reactor_eqn(),
+				// reactor::outflow_fraction()
+  // find the jacobian and the shares of the flow out at y
+  void find_jacobian()
+    throw (bad_pointer, bad_value, bad_type); // find_residual(),
+				// rate_jacobian::evaluate(),
+				// reactor::reactor_eqn_slope(),
+				// reactor::outflow_fraction()
+  // factor the iteration matrix for the pseudo time step DT (0 for a
+  // newton step), return false if it is singular
+  bool factor(double dt);
+  // return the largest of the magnitudes of VALUES times the weights
+  double norm(const CH_STD::vector<double>& values) const;
+  // put Y plus LAMBDA times CHANGE, kept in range, into VALUES
+  void move(const CH_STD::vector<double>& change, double lambda,
+	    CH_STD::vector<double>& values) const;
+  // find the steady state from y
+  void solve_steady()
+    throw (bad_pointer, bad_value, bad_type); // this, find_residual(),
+				// find_jacobian()
+public:
+  // ctor: (default) set the default tolerances
+  steady();
+  // dtor: do nothing
+  virtual ~steady();
+
+  // parse integrator input
+  virtual void parse(token_seq_citer& token_it, token_seq_citer end)
+    throw (bad_input, bad_request, bad_value, bad_type, bad_pointer); // this,
+				// state::parse()
+  // create a copy of this steady state solver, return pointer to it
+  virtual integrator* copy() const
+    throw (bad_pointer); // steady()
+}; // end class steady
+
+CH_END_NAMESPACE
+
+#endif // not CH_MODEL_STEADY_H
+
+/* $Id$ */
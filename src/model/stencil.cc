@@ -0,0 +1,329 @@
+// Methods to find and apply the site groups of the surface points.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "stencil.h"
+#include <algorithm>
+#include <cstdlib>		// for abs()
+#include "environment.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// stencil methods
+// ctor: set the surface and its environments (in order of index)
+stencil::stencil(lattice* surface_,
+		 const CH_STD::vector<environment*>* environments_)
+  : surface(surface_), environments(environments_), size(0U), radius(0U),
+    shared(true), shapes(), touch(), offset_shapes(), point_groups(),
+    point_touch()
+{}
+
+// dtor: do nothing
+stencil::~stencil()
+{}
+
+// stencil private methods
+// return the offset of ENV from the point at ROW, COLUMN
+stencil::offset
+stencil::get_offset(unsigned int row, unsigned int column,
+		    const environment* env) const
+{
+  unsigned int index(env->get_index());
+  return CH_STD::make_pair(int(index / size) - int(row),
+			   int(index % size) - int(column));
+}
+
+// return the index of the point at OFF from the point at ROW, COLUMN
+unsigned int
+stencil::get_index(unsigned int row, unsigned int column,
+		   const offset& off) const
+{
+  // offsets never reach more than once around the surface
+  int r(int(row) + off.first);
+  int c(int(column) + off.second);
+  r = (r < 0) ? r + int(size) : ((r >= int(size)) ? r - int(size) : r);
+  c = (c < 0) ? c + int(size) : ((c >= int(size)) ? c - int(size) : c);
+  return r * size + c;
+}
+
+// append the environments of shape SHAPE_INDEX put on the point at INDEX
+void
+stencil::put_shape(unsigned int index, unsigned int shape_index,
+		   CH_STD::vector<environment*>& members) const
+{
+  const shape& group_shape(shapes[shape_index]);
+  unsigned int row(index / size);
+  unsigned int column(index % size);
+  if (row >= radius && row + radius < size && column >= radius
+      && column + radius < size)
+    {
+      // away from the edges the offsets can just be added
+      for (shape::const_iterator it(group_shape.begin());
+	   it != group_shape.end(); ++it)
+	{
+	  members.push_back((*environments)[index + it->first * int(size)
+					    + it->second]);
+	}
+      return;
+    }
+  // else the group may wrap around the edges
+  for (shape::const_iterator it(group_shape.begin());
+       it != group_shape.end(); ++it)
+    {
+      members.push_back((*environments)[get_index(row, column, *it)]);
+    }
+  return;
+}
+
+// stencil public methods
+// find the groups of sites from the environments
+void
+stencil::create()
+  throw (bad_input)
+{
+  // clear out anything from a previous surface
+  shapes.clear();
+  touch.clear();
+  offset_shapes.clear();
+  point_groups.clear();
+  point_touch.clear();
+  radius = 0U;
+  size = surface->get_size();
+  if (environments->empty())
+    {
+      return;
+    }
+  // groups can only wrap onto themselves if they reach halfway around
+  unsigned int reach(environment::get_reach());
+  shared = (size >= 2U * reach + 1U);
+  if (shared)
+    {
+      // find the groups of a point whose groups all fit on the surface
+      environment* center((*environments)[reach * size + reach]);
+      environment::group near;
+      environment::group_set groups;
+      center->connect(near, groups);
+      // convert them into offsets, keeping their order
+      for (environment::group_set_citer it(groups.begin()); it != groups.end();
+	   ++it)
+	{
+	  shape group_shape;
+	  group_shape.reserve(it->size());
+	  for (environment::group_citer git(it->begin()); git != it->end();
+	       ++git)
+	    {
+	      group_shape.push_back(get_offset(reach, reach, *git));
+	    }
+	  shapes.push_back(group_shape);
+	}
+      for (environment::group_citer it(near.begin()); it != near.end(); ++it)
+	{
+	  offset off(get_offset(reach, reach, *it));
+	  touch.push_back(off);
+	  // the groups are within the points they touch
+	  radius = CH_STD::max(radius, (unsigned int) abs(off.first));
+	  radius = CH_STD::max(radius, (unsigned int) abs(off.second));
+	}
+      // index the shapes by the offsets they contain
+      unsigned int width(2U * radius + 1U);
+      offset_shapes.resize(width * width);
+      for (unsigned int i(0U); i < shapes.size(); ++i)
+	{
+	  for (shape::const_iterator it(shapes[i].begin());
+	       it != shapes[i].end(); ++it)
+	    {
+	      offset_shapes[(it->first + radius) * width + it->second
+			    + radius].push_back(i);
+	    }
+	}
+      return;
+    }
+  // else each point keeps its own groups
+  point_groups.resize(environments->size());
+  point_touch.resize(environments->size());
+  for (unsigned int i(0U); i < environments->size(); ++i)
+    {
+      environment::group near;
+      environment::group_set groups;
+      (*environments)[i]->connect(near, groups);
+      for (environment::group_set_citer it(groups.begin()); it != groups.end();
+	   ++it)
+	{
+	  point_groups[i].push_back(CH_STD::vector<unsigned int>());
+	  for (environment::group_citer git(it->begin()); git != it->end();
+	       ++git)
+	    {
+	      point_groups[i].back().push_back((*git)->get_index());
+	    }
+	}
+      for (environment::group_citer it(near.begin()); it != near.end(); ++it)
+	{
+	  point_touch[i].push_back((*it)->get_index());
+	}
+    }
+  return;
+}
+
+// put the groups containing the point at INDEX in MEMBERS, their ends in ENDS
+void
+stencil::get_groups(unsigned int index, CH_STD::vector<environment*>& members,
+		    CH_STD::vector<unsigned int>& ends) const
+{
+  members.clear();
+  ends.clear();
+  if (!shared)
+    {
+      // copy the groups of this point
+      const CH_STD::vector<CH_STD::vector<unsigned int> >&
+	groups(point_groups[index]);
+      for (unsigned int i(0U); i < groups.size(); ++i)
+	{
+	  for (unsigned int j(0U); j < groups[i].size(); ++j)
+	    {
+	      members.push_back((*environments)[groups[i][j]]);
+	    }
+	  ends.push_back(members.size());
+	}
+      return;
+    }
+  for (unsigned int i(0U); i < shapes.size(); ++i)
+    {
+      put_shape(index, i, members);
+      ends.push_back(members.size());
+    }
+  return;
+}
+
+// put the groups containing the point at INDEX and any of NEAR in
+// MEMBERS, their ends in ENDS, and their positions in POSITIONS
+/* The shapes containing the offset of each of NEAR give the groups
+ * directly; only on a surface too small to share them are all of the
+ * groups found and those containing none of NEAR left out.
+ */
+void
+stencil::get_groups(unsigned int index,
+		    const CH_STD::vector<environment*>& near,
+		    CH_STD::vector<environment*>& members,
+		    CH_STD::vector<unsigned int>& ends,
+		    CH_STD::vector<unsigned int>& positions) const
+{
+  members.clear();
+  ends.clear();
+  positions.clear();
+  if (!shared)
+    {
+      CH_STD::vector<environment*> all;
+      CH_STD::vector<unsigned int> all_ends;
+      get_groups(index, all, all_ends);
+      for (unsigned int i(0U); i < all_ends.size(); ++i)
+	{
+	  CH_STD::vector<environment*>::const_iterator
+	    begin(all.begin() + ((i > 0U) ? all_ends[i - 1U] : 0U));
+	  CH_STD::vector<environment*>::const_iterator
+	    end(all.begin() + all_ends[i]);
+	  if (CH_STD::find_first_of(begin, end, near.begin(), near.end())
+	      != end)
+	    {
+	      members.insert(members.end(), begin, end);
+	      ends.push_back(members.size());
+	      positions.push_back(i);
+	    }
+	}
+      return;
+    }
+  // else find the shapes containing the offsets of the points
+  unsigned int row(index / size);
+  unsigned int column(index % size);
+  unsigned int width(2U * radius + 1U);
+  for (CH_STD::vector<environment*>::const_iterator it(near.begin());
+       it != near.end(); ++it)
+    {
+      // the offset, going around the surface if that is nearer (the
+      // surface is too large for both ways to be within the radius)
+      unsigned int near_index((*it)->get_index());
+      int r(int(near_index / size) - int(row));
+      int c(int(near_index % size) - int(column));
+      if (r > int(radius))
+	{
+	  r -= int(size);
+	}
+      else if (r < -int(radius))
+	{
+	  r += int(size);
+	}
+      if (c > int(radius))
+	{
+	  c -= int(size);
+	}
+      else if (c < -int(radius))
+	{
+	  c += int(size);
+	}
+      // a point further away is in none of the groups
+      if (abs(r) > int(radius) || abs(c) > int(radius))
+	{
+	  continue;		// for (it)
+	}
+      const CH_STD::vector<unsigned int>&
+	found(offset_shapes[(r + int(radius)) * width + c + int(radius)]);
+      positions.insert(positions.end(), found.begin(), found.end());
+    }
+  CH_STD::sort(positions.begin(), positions.end());
+  positions.erase(CH_STD::unique(positions.begin(), positions.end()),
+		  positions.end());
+  for (CH_STD::vector<unsigned int>::const_iterator it(positions.begin());
+       it != positions.end(); ++it)
+    {
+      put_shape(index, *it, members);
+      ends.push_back(members.size());
+    }
+  return;
+}
+
+// append the environments whose groups contain the point at INDEX
+void
+stencil::get_touching(unsigned int index,
+		      CH_STD::vector<environment*>& touching) const
+{
+  if (!shared)
+    {
+      const CH_STD::vector<unsigned int>& near(point_touch[index]);
+      for (unsigned int i(0U); i < near.size(); ++i)
+	{
+	  touching.push_back((*environments)[near[i]]);
+	}
+      return;
+    }
+  unsigned int row(index / size);
+  unsigned int column(index % size);
+  for (shape::const_iterator it(touch.begin()); it != touch.end(); ++it)
+    {
+      touching.push_back((*environments)[get_index(row, column, *it)]);
+    }
+  return;
+}
+
+CH_END_NAMESPACE
+
+/* $Id$ */
@@ -0,0 +1,136 @@
+// -*- C++ -*-
+// Class of the site groups shared by all of the points of a surface.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_MODEL_STENCIL_H
+#define CH_MODEL_STENCIL_H 1
+
+#include <utility>
+#include <vector>
+#include "except.h"
+#include "lattice.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// defined in environment.h
+class environment;
+
+// groups of sites (sets of environments) containing each point of a
+// periodic square surface
+//
+// Every point of the surface has groups of the same shapes, so they
+// are found once, as (row, column) offsets from a point far enough from
+// the edges that none of them wraps around, and put on any point by
+// adding its index.  The groups of every point are in the order of
+// their shapes, which is also the order of the indices of their
+// environments away from the edges.  Only when the surface is so small
+// that a group could reach around onto itself does each point keep its
+// own groups (in the order of the indices of their environments).
+class stencil
+{
+public:
+  // set up typedef's
+  typedef CH_STD::pair<int,int> offset; // rows and columns from the center
+  typedef CH_STD::vector<offset> shape; // offsets of the points in a group
+
+private:
+  lattice* surface;		// surface the environments are points of
+  const CH_STD::vector<environment*>* environments; // all of them, by index
+  unsigned int size;		// points on each side of the surface
+  unsigned int radius;		// rows or columns any offset reaches
+  bool shared;			// do all points use shapes and touch
+  CH_STD::vector<shape> shapes;	// groups containing the center, in the
+				// order they have away from the edges
+  shape touch;			// points whose groups contain the center
+  // shapes containing each offset (row by row from -radius, -radius)
+  CH_STD::vector<CH_STD::vector<unsigned int> > offset_shapes;
+  // groups and touching points (by index) of every point of a small surface
+  CH_STD::vector<CH_STD::vector<CH_STD::vector<unsigned int> > > point_groups;
+  CH_STD::vector<CH_STD::vector<unsigned int> > point_touch;
+
+private:
+  // prevent copy construction and assignment
+  stencil(const stencil&);
+  stencil& operator=(const stencil&);
+  // return the offset of ENV from the point at ROW, COLUMN
+  offset get_offset(unsigned int row, unsigned int column,
+		    const environment* env) const;
+  // return the index of the point at OFF from the point at ROW, COLUMN
+  unsigned int get_index(unsigned int row, unsigned int column,
+			 const offset& off) const;
+  // append the environments of shape SHAPE_INDEX put on the point at
+  // INDEX to MEMBERS
+  void put_shape(unsigned int index, unsigned int shape_index,
+		 CH_STD::vector<environment*>& members) const;
+public:
+  // ctor: set the surface and its environments (in order of index)
+  stencil(lattice* surface_, const CH_STD::vector<environment*>* environments_);
+  // dtor: do nothing
+  ~stencil();
+
+  // find the groups of sites from the environments, whose neighbors
+  // must have been set
+  void create()
+    throw (bad_input);		// environment::connect()
+  // return the surface the environments are points of
+  lattice* get_surface() const;
+  // return true if every point has groups of the same shapes, in the
+  // order of the shapes
+  bool is_shared() const;
+  // put the groups containing the point at INDEX (always in the same
+  // order) one after another in MEMBERS and where each of them ends in
+  // MEMBERS in ENDS
+  void get_groups(unsigned int index, CH_STD::vector<environment*>& members,
+		  CH_STD::vector<unsigned int>& ends) const;
+  // as above, but only the groups also containing any of NEAR (in the
+  // same order, each once), and the position of each among all of the
+  // groups of the point in POSITIONS
+  void get_groups(unsigned int index,
+		  const CH_STD::vector<environment*>& near,
+		  CH_STD::vector<environment*>& members,
+		  CH_STD::vector<unsigned int>& ends,
+		  CH_STD::vector<unsigned int>& positions) const;
+  // append the environments whose groups contain the point at INDEX
+  // (including its own) to TOUCHING
+  void get_touching(unsigned int index,
+		    CH_STD::vector<environment*>& touching) const;
+}; // end class stencil
+
+// inline functions
+// return the surface the environments are points of
+inline lattice*
+stencil::get_surface() const
+{
+  return surface;
+}
+
+// return true if every point has groups of the same shapes
+inline bool
+stencil::is_shared() const
+{
+  return shared;
+}
+
+CH_END_NAMESPACE
+
+#endif // not CH_MODEL_STENCIL_H
+
+/* $Id$ */
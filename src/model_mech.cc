@@ -29,10 +29,15 @@
 CH_BEGIN_NAMESPACE
 
 // model_mechanism class methods
+// ctor: (default) empty mechanism, filled by copy()
+model_mechanism::model_mechanism()
+  : speciess(), reactions(), s2m(), kernel()
+{}
+
 // ctor: convert input into model-usable classes
 model_mechanism::model_mechanism(const mechanism& mech)
   throw (bad_pointer)
-  : speciess(), reactions(), s2m()
+  : speciess(), reactions(), s2m(), kernel()
 {
   // make sure the sequences are allocated big enough
   speciess.reserve(mech.get_total_species());
@@ -55,6 +60,8 @@ model_mechanism::model_mechanism(const mechanism& mech)
       // create model_reaction pointer and add it to list
       reactions.push_back(new model_reaction(**it, s2m));
     }
+  // flatten the rate expressions once
+  kernel.compile(speciess, reactions);
 }
 
 // dtor: delete everything we created
@@ -138,6 +145,13 @@ model_mechanism::reaction_seq_end() const
   return reactions.end();
 }
 
+// return the rate expressions of the reactions, as arrays
+rate_kernel&
+model_mechanism::get_kernel()
+{
+  return kernel;
+}
+
 // set all the model_species values to zero
 void
 model_mechanism::zero_quantities()
@@ -149,6 +163,51 @@ model_mechanism::zero_quantities()
   return;
 }
 
+// return pointer to a new mechanism with its own species (having the
+// current quantities) and reactions (sharing the rate constants)
+model_mechanism*
+model_mechanism::copy() const
+  throw (bad_pointer)
+{
+  model_mechanism* mm(new model_mechanism());
+  mm->speciess.reserve(speciess.size());
+  mm->reactions.reserve(reactions.size());
+  // our model_species to those of the copy
+  species2model old2new;
+  for (model_species::seq_citer it(speciess.begin()); it != speciess.end();
+       ++it)
+    {
+      // the new species starts with a copy of our quantity
+      model_species* ms_tmp(new model_species(static_cast<const species&>
+					      (**it)));
+      ms_tmp->set_quantity((*it)->copy_quantity());
+      mm->speciess.push_back(ms_tmp);
+      old2new.insert(CH_STD::make_pair(*it, ms_tmp));
+    }
+  // the copy answers to the same base species we do
+  for (species2model_citer it(s2m.begin()); it != s2m.end(); ++it)
+    {
+      mm->s2m.insert(CH_STD::make_pair(it->first, old2new[it->second]));
+    }
+  // create model_reactions using the new species
+  try
+    {
+      for (model_reaction::seq_citer it(reactions.begin());
+	   it != reactions.end(); ++it)
+	{
+	  mm->reactions.push_back(new model_reaction(**it, old2new));
+	}
+      mm->kernel.compile(mm->speciess, mm->reactions);
+    }
+  catch (bad_pointer&)
+    {
+      // do not leak the partial copy
+      delete mm;
+      throw;
+    }
+  return mm;
+}
+
 CH_END_NAMESPACE
 
 /* $Id: model_mech.cc,v 1.1.1.1 2004/11/25 20:24:05 banjo Exp $ */
@@ -24,6 +24,7 @@
 
 #include <string>
 #include "except.h"
+#include "kernel.h"
 #include "mechanism.h"
 #include "reaction.h"
 #include "species.h"
@@ -37,15 +38,18 @@ class model_mechanism
   model_species::seq speciess;	// list of species
   model_reaction::seq reactions; // list of reactions
   species2model s2m;		// species to mode_species mapping
+  rate_kernel kernel;		// rate expressions of the reactions
 
 private:
   // prevent copy construction and assignment
   model_mechanism(const model_mechanism&);
   model_mechanism& operator=(const model_mechanism&);
+  // ctor: (default) empty mechanism, filled by copy()
+  model_mechanism();
 public:
   // ctor: convert input into model-usable classes
   model_mechanism(const mechanism& mech)
-    throw (bad_pointer); // model_reaction()
+    throw (bad_pointer); // model_reaction(), rate_kernel::compile()
   // dtor: clean house
   ~model_mechanism();
 
@@ -63,8 +67,14 @@ public:
   model_reaction::seq_citer reaction_seq_begin() const;
   // return iterator to beginning of reaction list
   model_reaction::seq_citer reaction_seq_end() const;
+  // return the rate expressions of the reactions, as arrays
+  rate_kernel& get_kernel();
   // set all species quantities to zero
   void zero_quantities();
+  // return pointer to a new mechanism with its own species (having the
+  // current quantities) and reactions (sharing the rate constants)
+  model_mechanism* copy() const
+    throw (bad_pointer); // model_reaction(), rate_kernel::compile()
 }; // end class model_mechanism
 
 CH_END_NAMESPACE
@@ -31,13 +31,17 @@ CH_BEGIN_NAMESPACE
 
 // initialize parameter static members, allow multiple instances with same name
 unique parameter::name_list("par", true);
+unsigned long parameter::generation = 0UL;
 
 // parameter methods
 // ctor: (default) create name for parameter
 // ctor: defaults value_ = 0.0e0
 parameter::parameter(double value_)
   : name(name_list.insert()), value(value_)
-{}
+{
+  // values computed from the previous parameters may now be stale
+  ++generation;
+}
 
 // ctor: with name given
 // ctor: defaults value_ = 0.0e0
@@ -45,6 +49,8 @@ parameter::parameter(const CH_STD::string& name_, double value_)
   : name(name_), value(value_)
 {
   name_list.insert(name);
+  // values computed from the previous parameters may now be stale
+  ++generation;
 }
 
 // dtor: erase name from list of used names
@@ -74,6 +80,8 @@ parameter::set_value(double value_)
 {
   double old(value);
   value = value_;
+  // let anything computed from parameter values know it must be redone
+  ++generation;
   return old;
 }
 
@@ -83,6 +91,13 @@ parameter::stringify() const
 {
   return name;
 }
+
+// return a number that changes whenever any parameter value changes
+unsigned long
+parameter::get_generation()
+{
+  return generation;
+}
 
 // opt_parameter methods
 // ctor: (default) optional value and bounds
@@ -39,6 +39,7 @@ class parameter
   CH_STD::string name;		// the name of the parameter
   double value;			// actual current value of parameter
   static unique name_list;	// keep track of all parameter names
+  static unsigned long generation; // changes whenever any value changes
 
 private:
   // prevent copy construction and assignment
@@ -60,6 +61,8 @@ public:
   double set_value(double value_);
   // return name of parameter
   CH_STD::string stringify() const;
+  // return a number that changes whenever any parameter value changes
+  static unsigned long get_generation();
 }; // end class parameter
 
 // set up containers and iterators for parameter
@@ -0,0 +1,156 @@
+// Methods for timing the phases of a piece of work.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "profile.h"
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif // HAVE_SYS_TIME_H
+#include <unistd.h>
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// return the clock ticks per second of times()
+static long int
+clock_ticks()
+{
+  long int clktck(sysconf(_SC_CLK_TCK));
+  if (clktck <= 0L)
+    {
+      clktck = CLOCKS_PER_SEC;
+    }
+  return clktck;
+}
+
+// return the elapsed seconds since some fixed time, or a negative
+// number if they are unknown
+/* times() only counts in clock ticks, often a hundredth of a second,
+ * so the finest clock there is is used instead when there is one.
+ */
+static double
+elapsed_seconds()
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+  struct timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC, &now) == 0)
+    {
+      return now.tv_sec + now.tv_nsec * 1.0e-9;
+    }
+#endif // HAVE_CLOCK_GETTIME && CLOCK_MONOTONIC
+#ifdef HAVE_GETTIMEOFDAY
+  struct timeval now_tv;
+  if (gettimeofday(&now_tv, 0) == 0)
+    {
+      return now_tv.tv_sec + now_tv.tv_usec * 1.0e-6;
+    }
+#endif // HAVE_GETTIMEOFDAY
+  struct tms ignored;
+  clock_t now_ticks(times(&ignored));
+  if (now_ticks == (clock_t) -1)
+    {
+      return -1.0e0;
+    }
+  return now_ticks / (double) clock_ticks();
+}
+
+// profile methods
+// ctor: (default) start timing the first phase
+profile::profile()
+  : phases(), last(), last_wall(-1.0e0)
+{
+  start();
+}
+
+// dtor: do nothing
+profile::~profile()
+{}
+
+// profile public methods
+// forget any phases and start timing the first one again
+void
+profile::start()
+{
+  phases.clear();
+  times(&last);
+  last_wall = elapsed_seconds();
+  return;
+}
+
+// end the current phase, calling it NAME, and start the next one
+void
+profile::mark(const CH_STD::string& name)
+{
+  struct tms now;
+  times(&now);
+  double now_wall(elapsed_seconds());
+  // clock ticks per second
+  long int clktck(clock_ticks());
+  phase done;
+  done.name = name;
+  done.user = (now.tms_utime - last.tms_utime) / (double) clktck;
+  done.system = (now.tms_stime - last.tms_stime) / (double) clktck;
+  done.wall = 0.0e0;
+  // the elapsed time is unknown if the clock failed
+  if (now_wall >= 0.0e0 && last_wall >= 0.0e0)
+    {
+      done.wall = now_wall - last_wall;
+    }
+  phases.push_back(done);
+  last = now;
+  last_wall = now_wall;
+  return;
+}
+
+// write a line for each phase and one for their total to OUT
+void
+profile::report(CH_STD::ostream& out, const CH_STD::string& prefix,
+		unsigned int count) const
+{
+  phase total;
+  total.name = "total";
+  total.user = 0.0e0;
+  total.system = 0.0e0;
+  total.wall = 0.0e0;
+  for (CH_STD::vector<phase>::const_iterator it(phases.begin());
+       it != phases.end(); ++it)
+    {
+      out << prefix << it->name << " = " << it->user << "u "
+	  << it->system << "s " << it->wall << "w";
+      if (count > 1U)
+	{
+	  out << " (" << it->wall / count << "w each)";
+	}
+      out << CH_STD::endl;
+      total.user += it->user;
+      total.system += it->system;
+      total.wall += it->wall;
+    }
+  out << prefix << total.name << " = " << total.user << "u "
+      << total.system << "s " << total.wall << "w" << CH_STD::endl;
+  return;
+}
+
+CH_END_NAMESPACE
+
+/* $Id$ */
@@ -0,0 +1,74 @@
+// -*- C++ -*-
+// Class for timing the phases of a piece of work.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_PROFILE_H
+#define CH_PROFILE_H 1
+
+#include <ctime>
+#include <ostream>
+#include <string>
+#include <sys/times.h>
+#include <vector>
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// processor and elapsed times of the phases of a piece of work, each
+// phase ending when it is marked (processor times include those of all
+// threads, so they exceed the elapsed time of phases done in parallel)
+class profile
+{
+  // times spent in one phase
+  struct phase
+  {
+    CH_STD::string name;	// what was being done
+    double user;		// processor seconds spent in the program
+    double system;		// processor seconds spent in the system
+    double wall;		// elapsed seconds
+  };
+
+  CH_STD::vector<phase> phases;	// phases marked so far
+  struct tms last;		// processor times at the last mark
+  double last_wall;		// elapsed seconds at the last mark, negative
+				// if unknown
+
+public:
+  // ctor: (default) start timing the first phase
+  profile();
+  // dtor: do nothing
+  ~profile();
+
+  // forget any phases and start timing the first one again
+  void start();
+  // end the current phase, calling it NAME, and start the next one
+  void mark(const CH_STD::string& name);
+  // write a line for each phase and one for their total to OUT, each
+  // starting with PREFIX, adding the elapsed time of each of COUNT
+  // repetitions of the work done in a phase if there were several
+  void report(CH_STD::ostream& out, const CH_STD::string& prefix,
+	      unsigned int count = 1U) const;
+}; // end class profile
+
+CH_END_NAMESPACE
+
+#endif // not CH_PROFILE_H
+
+/* $Id$ */
@@ -182,6 +182,24 @@ surface_quantity::zero_quantity()
   set_coverage();		// zero is default
   return;
 }
+
+// write the coverage to OUT
+void
+surface_quantity::save(binary_ofstream& out) const
+  throw (bad_file)
+{
+  out.put_double(coverage);
+  return;
+}
+
+// read the coverage written by save() from IN
+void
+surface_quantity::restore(binary_ifstream& in)
+  throw (bad_file)
+{
+  coverage = in.get_double();
+  return;
+}
 
 // fluid_quantity methods
 // ctor: (default) set values to zero
@@ -413,6 +431,28 @@ fluid_quantity::zero_quantity()
   return;
 }
 
+// write the values to OUT
+void
+fluid_quantity::save(binary_ofstream& out) const
+  throw (bad_file)
+{
+  out.put_double(concentration);
+  out.put_double(pressure);
+  out.put_double(flow);
+  return;
+}
+
+// read the values written by save() from IN
+void
+fluid_quantity::restore(binary_ifstream& in)
+  throw (bad_file)
+{
+  concentration = in.get_double();
+  pressure = in.get_double();
+  flow = in.get_double();
+  return;
+}
+
 CH_END_NAMESPACE
 
 /* $Id: quantity.cc,v 1.1.1.1 2004/11/25 20:24:06 banjo Exp $ */
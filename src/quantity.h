@@ -24,6 +24,7 @@
 
 #include <string>
 #include "except.h"
+#include "file.h"
 #include "precision.h"
 
 // set namespace to avoid possible clashes
@@ -70,6 +71,12 @@ public:
   virtual double add_to_quantity(type type_, double increment = 0.0e0) = 0;
   // set all values to zero
   virtual void zero_quantity() = 0;
+  // write the values to OUT
+  virtual void save(binary_ofstream& out) const
+    throw (bad_file) = 0; // binary_ofstream::put_double()
+  // read the values written by save() from IN
+  virtual void restore(binary_ifstream& in)
+    throw (bad_file) = 0; // binary_ifstream::get_double()
 }; // end class quantity
 
 class surface_quantity : public quantity
@@ -108,6 +115,12 @@ public:
     throw (bad_value); // set_coverage()
   // set all values to zero
   virtual void zero_quantity();
+  // write the values to OUT
+  virtual void save(binary_ofstream& out) const
+    throw (bad_file); // binary_ofstream::put_double()
+  // read the values written by save() from IN
+  virtual void restore(binary_ifstream& in)
+    throw (bad_file); // binary_ifstream::get_double()
 }; // end class surface_quantity
 
 class fluid_quantity : public quantity
@@ -161,6 +174,12 @@ public:
     throw (bad_type, bad_value); // this, set_concentration(), set_pressure()
   // set all values to zero
   virtual void zero_quantity();
+  // write the values to OUT
+  virtual void save(binary_ofstream& out) const
+    throw (bad_file); // binary_ofstream::put_double()
+  // read the values written by save() from IN
+  virtual void restore(binary_ifstream& in)
+    throw (bad_file); // binary_ifstream::get_double()
 }; // end class fluid_quantity
 
 CH_END_NAMESPACE
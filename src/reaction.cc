@@ -31,25 +31,42 @@
 CH_BEGIN_NAMESPACE
 
 // initialize static instance variables
+const int stoichiometric::max_order;
 quantity::type model_reaction::amount_type(quantity::Econcentration);
 
 // stoiciometric coefficient class methods
 // ctor: (default) set coefficient to given value
 // ctor: default coefficient_ = 0.0e0
 stoichiometric::stoichiometric(double coefficient_)
-  : coefficient(coefficient_), power(coefficient_), power_set(false)
-{}
+  : coefficient(coefficient_), power(coefficient_), order(-1),
+    power_set(false)
+{
+  set_order();
+}
 
 // ctor: copy
 stoichiometric::stoichiometric(const stoichiometric& original)
   : coefficient(original.coefficient), power(original.power),
-    power_set(original.power_set)
+    order(original.order), power_set(original.power_set)
 {}
 
 // dtor: do nothing
 stoichiometric::~stoichiometric()
 {}
 
+// stoichiometric private methods
+// set ORDER from POWER
+void
+stoichiometric::set_order()
+{
+  order = -1;
+  if (power >= 0.0e0 && power <= max_order && power == CH_STD::floor(power))
+    {
+      order = static_cast<int>(power);
+    }
+  return;
+}
+
 // stoichiometric public methods
 // return current value of stoichiometric coefficient
 double
@@ -65,6 +82,13 @@ stoichiometric::get_power() const
   return power;
 }
 
+// return the exponent if it is a small whole number, else -1
+int
+stoichiometric::get_order() const
+{
+  return order;
+}
+
 // return whether power was explicitly set
 bool
 stoichiometric::is_power_set() const
@@ -105,6 +129,7 @@ stoichiometric::increment(const stoichiometric& delta)
     {
       power = coefficient;
     }
+  set_order();
   return coefficient;
 }
 
@@ -116,6 +141,7 @@ stoichiometric::operator+=(double increment)
   if (!power_set)
     {
       power = coefficient;
+      set_order();
     }
   return coefficient;
 }
@@ -125,7 +151,9 @@ double
 stoichiometric::set_power(double power_)
 {
   power_set = true;
-  return power = power_;
+  power = power_;
+  set_order();
+  return power;
 }
 
 // reaction class methods
@@ -133,7 +161,8 @@ stoichiometric::set_power(double power_)
 // ctor: defaults k_reverse_ = 0, own_k_ = true
 reaction::reaction(k* k_forward_, k* k_reverse_, bool own_k_)
   : reactants(), products(), net(), k_forward(k_forward_),
-    k_reverse(k_reverse_), own_k(own_k_)
+    k_reverse(k_reverse_), own_k(own_k_), forward_cache(k_forward),
+    reverse_cache(k_reverse)
 {}
 
 // dtor: delete rate constants
@@ -151,7 +180,8 @@ reaction::~reaction()
 // ctor: make a new (model compatible) reaction from and old one and a map
 reaction::reaction(const reaction& original, const species2model& s2m)
   throw (bad_pointer)
-  : k_forward(original.k_forward), k_reverse(original.k_reverse), own_k(false)
+  : k_forward(original.k_forward), k_reverse(original.k_reverse), own_k(false),
+    forward_cache(k_forward), reverse_cache(k_reverse)
 {
   for (stoich_map_citer it = original.reactants.begin();
        it != original.reactants.end(); it++)
@@ -197,7 +227,8 @@ reaction::get_forward_k(double T, double R) const
 			":reaction::get_forward_k(): forward rate constant "
 			"pointer points to null");
     }
-  return k_forward->get_k(T, R);
+  // only evaluate (exp()) if temperature or a parameter changed
+  return forward_cache.get_k(T, R);
 }
 
 // return value of reverse rate constant at temperature T
@@ -209,7 +240,7 @@ reaction::get_reverse_k(double T, double R) const
       return 0.0e0;
     }
   // else
-  return k_reverse->get_k(T, R);
+  return reverse_cache.get_k(T, R);
 }
 
 // public methods
@@ -221,6 +252,20 @@ reaction::get_rate_constants()
   return CH_STD::make_pair(k_forward, k_reverse);
 }
 
+// return the forward rate constant, keeping ownership
+const k*
+reaction::get_forward_constant() const
+{
+  return k_forward;
+}
+
+// return the reverse rate constant, keeping ownership
+const k*
+reaction::get_reverse_constant() const
+{
+  return k_reverse;
+}
+
 // add species to reactant list, return COEFFICIENT after incrementing by COEFF
 // defaults coeff = 1.0e0
 double
@@ -505,11 +550,12 @@ model_reaction::get_forward_rate(double T, double R) const
   throw (bad_pointer, bad_type)
 {
   double rate(get_forward_k(T, R));
-  const stoich_map r(get_reactants());
-  for (stoich_map_citer it = r.begin(); it != r.end(); it++)
+  quantity::type type(get_amount_type());
+  const stoich_map& r(get_reactants());
+  for (stoich_map_citer it = r.begin(); it != r.end(); ++it)
     {
-      rate *= pow(static_cast<model_species*>(it->first)->get_quantity(get_amount_type()),
-		  it->second.get_power());
+      rate *= raise(static_cast<model_species*>(it->first)->get_quantity(type),
+		    it->second.get_order(), it->second.get_power());
     }
   return rate;
 }
@@ -526,11 +572,12 @@ model_reaction::get_reverse_rate(double T, double R) const
     }
   // else
   double rate(get_reverse_k(T, R));
-  const stoich_map p(get_products());
-  for (stoich_map_citer it = p.begin(); it != p.end(); it++)
+  quantity::type type(get_amount_type());
+  const stoich_map& p(get_products());
+  for (stoich_map_citer it = p.begin(); it != p.end(); ++it)
     {
-      rate *= pow(static_cast<model_species*>(it->first)->get_quantity(get_amount_type()),
-		  it->second.get_power());
+      rate *= raise(static_cast<model_species*>(it->first)->get_quantity(type),
+		    it->second.get_order(), it->second.get_power());
     }
   return rate;
 }
@@ -548,8 +595,8 @@ model_reaction::get_net_rate(double T, double R) const
 void
 model_reaction::derivatives(double rate)
 {
-  const stoich_map n(get_net_coefficients());
-  for (stoich_map_citer it = n.begin(); it != n.end(); it++)
+  const stoich_map& n(get_net_coefficients());
+  for (stoich_map_citer it = n.begin(); it != n.end(); ++it)
     {
       static_cast<model_species*>(it->first)->add_to_derivative(it->second.get_coefficient() * rate);
     }
@@ -566,6 +613,80 @@ model_reaction::rate_derivatives(double T, double R)
   return rate;
 }
 
+// put the derivative of the net rate with respect to each species into
+// PARTIALS
+/* The rate of each direction is k times the product of the quantities
+ * to their powers, so its derivative with respect to one quantity is
+ * the product of the others times the derivative of that one's term,
+ * which stays finite when a quantity is zero.
+ */
+void
+model_reaction::rate_partials(double T, double* partials, double R) const
+  throw (bad_pointer, bad_type)
+{
+  quantity::type type(get_amount_type());
+  const stoich_map& r(get_reactants());
+  double k_f(get_forward_k(T, R));
+  for (stoich_map_citer it = r.begin(); it != r.end(); ++it, ++partials)
+    {
+      double power(it->second.get_power());
+      if (power == 0.0e0)
+	{
+	  // the rate does not depend on it
+	  *partials = 0.0e0;
+	  continue;		// for (it)
+	}
+      model_species* msp(static_cast<model_species*>(it->first));
+      double partial(k_f * power
+		     * raise(msp->get_quantity(type),
+			     it->second.get_order() - 1, power - 1.0e0));
+      for (stoich_map_citer other = r.begin(); other != r.end(); ++other)
+	{
+	  if (other != it)
+	    {
+	      model_species* factor(static_cast<model_species*>(other->first));
+	      partial *= raise(factor->get_quantity(type),
+			       other->second.get_order(),
+			       other->second.get_power());
+	    }
+	}
+      *partials = partial;
+    }
+  if (!is_reversible())
+    {
+      return;
+    }
+  // the reverse rate is subtracted
+  const stoich_map& p(get_products());
+  double k_r(get_reverse_k(T, R));
+  for (stoich_map_citer it = p.begin(); it != p.end(); ++it, ++partials)
+    {
+      double power(it->second.get_power());
+      if (power == 0.0e0)
+	{
+	  // the rate does not depend on it
+	  *partials = 0.0e0;
+	  continue;		// for (it)
+	}
+      model_species* msp(static_cast<model_species*>(it->first));
+      double partial(- k_r * power
+		     * raise(msp->get_quantity(type),
+			     it->second.get_order() - 1, power - 1.0e0));
+      for (stoich_map_citer other = p.begin(); other != p.end(); ++other)
+	{
+	  if (other != it)
+	    {
+	      model_species* factor(static_cast<model_species*>(other->first));
+	      partial *= raise(factor->get_quantity(type),
+			       other->second.get_order(),
+			       other->second.get_power());
+	    }
+	}
+      *partials = partial;
+    }
+  return;
+}
+
 // return a sequence containing the reactants
 const model_species::seq&
 model_reaction::get_reactant_seq()
@@ -653,12 +774,15 @@ model_reaction::get_fluid_forward_rate(double T, double R) const
   throw (bad_pointer, bad_type)
 {
   double rate(get_forward_k(T, R));
-  const stoich_map r(get_reactants());
-  for (stoich_map_citer it = r.begin(); it != r.end(); it++)
+  quantity::type type(get_amount_type());
+  const stoich_map& r(get_reactants());
+  for (stoich_map_citer it = r.begin(); it != r.end(); ++it)
     {
       if (it->first->get_surface_coordination() < 1)
 	{
-	  rate *= pow(static_cast<model_species*>(it->first)->get_quantity(get_amount_type()), it->second.get_power());
+	  model_species* msp(static_cast<model_species*>(it->first));
+	  rate *= raise(msp->get_quantity(type), it->second.get_order(),
+			it->second.get_power());
 	}
     }
   return rate;
@@ -676,12 +800,15 @@ model_reaction::get_fluid_reverse_rate(double T, double R) const
     }
   // else
   double rate(get_reverse_k(T, R));
-  const stoich_map p(get_products());
-  for (stoich_map_citer it = p.begin(); it != p.end(); it++)
+  quantity::type type(get_amount_type());
+  const stoich_map& p(get_products());
+  for (stoich_map_citer it = p.begin(); it != p.end(); ++it)
     {
       if (it->first->get_surface_coordination() < 1)
 	{
-	  rate *= pow(static_cast<model_species*>(it->first)->get_quantity(get_amount_type()), it->second.get_power());
+	  model_species* msp(static_cast<model_species*>(it->first));
+	  rate *= raise(msp->get_quantity(type), it->second.get_order(),
+			it->second.get_power());
 	}
     }
   return rate;
@@ -22,6 +22,7 @@
 #ifndef CH_REACTION_H
 #define CH_REACTION_H 1
 
+#include <cmath>
 #include <map>
 #include <utility>
 #include <vector>
@@ -40,11 +41,18 @@ class stoichiometric
 {
   double coefficient;		// value of coefficient
   double power;			// exponent in rate equation
+  int order;			// POWER if a small whole number, else -1
   bool power_set;		// value of power set explicitly
 
+public:
+  // static instance variables
+  static const int max_order = 4; // largest power taken by multiplication
+
 private:
   // prevent assignment
   stoichiometric& operator=(const stoichiometric&);
+  // set ORDER from POWER
+  void set_order();
 public:
   // ctor: (default) initialize to given coefficient
   explicit stoichiometric(double coefficient_ = 0.0e0);
@@ -57,6 +65,8 @@ public:
   double get_coefficient() const;
   // return current value of exponent
   double get_power() const;
+  // return the exponent if it is a small whole number, else -1
+  int get_order() const;
   // return whether power was explicitly set
   bool is_power_set() const;
   // set the coefficient, return old value
@@ -91,6 +101,8 @@ private:
   k* k_forward;			// rate constant for forward reaction
   k* k_reverse;			// rate constant for reverse reaction
   bool own_k;			// whether this reaction owns the k's
+  mutable k_cache forward_cache; // last value of k_forward
+  mutable k_cache reverse_cache; // last value of k_reverse
 
 private:
   // prevent copy construction and assignment
@@ -100,19 +112,25 @@ protected:
   // ctor: make a new (model compatible) reaction from and old one and a map
   reaction(const reaction& reaction_, const species2model& s2m)
     throw (bad_pointer); // this
-  // return forward rate constant
-  double get_forward_k(double T, double R) const
-    throw (bad_pointer); // this
-  // return reverse rate constant
-  double get_reverse_k(double T, double R) const;
 public:
   // ctor: (default) create an empty reaction with the given rates
   reaction(k* k_forward_, k* k_reverse_ = 0, bool own_k_ = true);
   // dtor: delete rate constants
   ~reaction();
 
+  // return forward rate constant
+  double get_forward_k(double T, double R) const
+    throw (bad_pointer); // this
+  // return reverse rate constant (zero if not reversible)
+  double get_reverse_k(double T, double R) const;
+
   // return rate constant pointers, release ownership
   CH_STD::pair<k*,k*> get_rate_constants();
+  // return the forward rate constant, keeping ownership
+  const k* get_forward_constant() const;
+  // return the reverse rate constant (zero if not reversible), keeping
+  // ownership
+  const k* get_reverse_constant() const;
   // add species to reactants, return COEFFICIENT after += -COEFF
   double add_reactant(species* reactant, double coeff = 1.0e0);
   // add species to products, return COEFFICIENT after += COEFF
@@ -193,6 +211,12 @@ public:
   // calculate rate and update derivatives of reactants and products, return rate
   double rate_derivatives(double T, double R = constant::r)
     throw (bad_pointer, bad_type); // get_net_rate()
+  // put the derivative of the net rate at temperature T with respect to
+  // the quantity of each reactant, then (if reversible) each product, in
+  // the order of get_reactants() and get_products(), into PARTIALS
+  void rate_partials(double T, double* partials, double R = constant::r)
+    const throw (bad_pointer, bad_type); // get_forward_k(),
+				// model_species::get_quantity()
   // return a sequence containing the reactants having each
   // species appear in the list the number of times given by its
   // stoichiometric coefficient
@@ -216,6 +240,28 @@ public:
     throw (bad_type); // model_species::get_quantity()
 }; // end class model_reaction
 
+// inline functions
+// return AMOUNT to the power POWER, by multiplication if ORDER (see
+// stoichiometric::get_order()) is not negative
+/* Most powers are the stoichiometric coefficients, small whole numbers,
+ * and a product or two is much quicker than pow().
+ */
+inline double
+raise(double amount, int order, double power)
+{
+  if (order < 0)
+    {
+      return CH_STD::pow(amount, power);
+    }
+  // else
+  double result(1.0e0);
+  for (int i(0); i < order; ++i)
+    {
+      result *= amount;
+    }
+  return result;
+}
+
 CH_END_NAMESPACE
 
 #endif // not CH_REACTION_H
@@ -214,6 +214,31 @@ model_species::set_quantity(quantity* amount_)
   return;
 }
 
+// return a copy of the current quantity (caller owns it)
+quantity*
+model_species::copy_quantity() const
+{
+  return amount->copy();
+}
+
+// write the current quantity to OUT
+void
+model_species::save_quantity(binary_ofstream& out) const
+  throw (bad_file)
+{
+  amount->save(out);
+  return;
+}
+
+// read the quantity written by save_quantity() from IN
+void
+model_species::restore_quantity(binary_ifstream& in)
+  throw (bad_file)
+{
+  amount->restore(in);
+  return;
+}
+
 // set the specified quantity of the model species, return old value
 // default type = Econcentration, amount_ = 0.0e0
 double
@@ -141,6 +141,14 @@ public:
   void zero_quantity();
   // replace current quantity with the one given
   void set_quantity(quantity* amount_);
+  // return a copy of the current quantity (caller owns it)
+  quantity* copy_quantity() const;
+  // write the current quantity to OUT
+  void save_quantity(binary_ofstream& out) const
+    throw (bad_file); // quantity::save()
+  // read the quantity written by save_quantity() from IN
+  void restore_quantity(binary_ifstream& in)
+    throw (bad_file); // quantity::restore()
   // set the specified quantity of the model species, return old value
   double set_quantity(quantity::type type = quantity::Econcentration,
 		      double amount_ = 0.0e0)
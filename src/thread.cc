@@ -0,0 +1,263 @@
+// Methods for running work in several threads at once.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <exception>
+#include <vector>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>		// sysconf()
+#endif // HAVE_UNISTD_H
+#include "thread.h"
+#include "t_string.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+#ifdef CH_THREADS
+// what a new thread needs to know to join its team
+struct member_start
+{
+  thread_team* team;		// team the thread is a member of
+  unsigned int rank;		// position of thread in team
+};
+#endif // CH_THREADS
+
+// thread_team methods
+// ctor: (default) team with SIZE_ members (at least one)
+// ctor: default size_ = 1U
+thread_team::thread_team(unsigned int size_)
+  : size(size_), task(0), data(0), waiting(0U), cycle(0UL), released(false),
+    failed(false), stopped(false), message()
+{
+#ifdef CH_THREADS
+  // need at least the calling thread
+  if (size < 1U)
+    {
+      size = 1U;
+    }
+  pthread_mutex_init(&lock, 0);
+  pthread_cond_init(&opened, 0);
+#else // not CH_THREADS
+  // everything is done by the calling thread
+  size = 1U;
+#endif // not CH_THREADS
+}
+
+// dtor: release the synchronization objects
+thread_team::~thread_team()
+{
+#ifdef CH_THREADS
+  pthread_cond_destroy(&opened);
+  pthread_mutex_destroy(&lock);
+#endif // CH_THREADS
+}
+
+// thread_team private methods
+// run the task as member RANK, recording any failure
+void
+thread_team::member(unsigned int rank)
+{
+  // exceptions can not leave a thread
+  try
+    {
+      (*task)(data, rank);
+    }
+  catch (CH_STD::exception& e)
+    {
+      fail(e.what());
+    }
+  catch (...)
+    {
+      fail("thread_team::member(): unknown exception");
+    }
+  return;
+}
+
+#ifdef CH_THREADS
+// start routine for the threads, ARG points to a member_start
+void*
+thread_team::start(void* arg)
+{
+  member_start* who(static_cast<member_start*>(arg));
+  thread_team* team(who->team);
+  // wait until the size of the team is known
+  pthread_mutex_lock(&team->lock);
+  while (!team->released)
+    {
+      pthread_cond_wait(&team->opened, &team->lock);
+    }
+  pthread_mutex_unlock(&team->lock);
+  team->member(who->rank);
+  return 0;
+}
+#endif // CH_THREADS
+
+// thread_team public methods
+// return the number of members in the team
+unsigned int
+thread_team::get_size() const
+{
+  return size;
+}
+
+// run TASK_(DATA_, rank) in every member, the calling thread being rank
+// zero, and return when all have finished
+void
+thread_team::run(work task_, void* data_)
+  throw (bad_request)
+{
+  task = task_;
+  data = data_;
+  waiting = 0U;
+  released = false;
+  failed = false;
+  stopped = false;
+  message.clear();
+#ifdef CH_THREADS
+  // start the other members (they wait until released)
+  CH_STD::vector<member_start> starts(size);
+  CH_STD::vector<pthread_t> threads(size);
+  unsigned int started(1U);
+  for (; started < size; ++started)
+    {
+      starts[started].team = this;
+      starts[started].rank = started;
+      if (pthread_create(&threads[started], 0, &thread_team::start,
+			 &starts[started]) != 0)
+	{
+	  break;		// for (started)
+	}
+    }
+  // let them go with however many members could be started
+  pthread_mutex_lock(&lock);
+  size = started;
+  released = true;
+  pthread_cond_broadcast(&opened);
+  pthread_mutex_unlock(&lock);
+  // the calling thread is rank zero
+  member(0U);
+  // wait for them all to finish
+  for (unsigned int i(1U); i < started; ++i)
+    {
+      pthread_join(threads[i], 0);
+    }
+#else // not CH_THREADS
+  member(0U);
+#endif // not CH_THREADS
+  if (failed)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":thread_team::run(): a member of the team failed: "
+			+ message);
+    }
+  return;
+}
+
+// wait until every member of the team has called barrier(), return
+// false if any member had failed by then
+/* Checking has_failed() after the barrier is not enough, since a fast
+ * member could fail in the next stage before a slow one looks, leaving
+ * the fast one waiting forever for a member that quit.  The state is
+ * instead recorded when the barrier opens; it can not change before
+ * every member has read it, since that takes another opening.
+ */
+bool
+thread_team::barrier()
+{
+#ifdef CH_THREADS
+  pthread_mutex_lock(&lock);
+  unsigned long arrived_in(cycle);
+  // the last one to arrive opens the barrier
+  if (++waiting >= size)
+    {
+      waiting = 0U;
+      ++cycle;
+      stopped = failed;
+      pthread_cond_broadcast(&opened);
+    }
+  else
+    {
+      // guard against spurious wake ups
+      while (cycle == arrived_in)
+	{
+	  pthread_cond_wait(&opened, &lock);
+	}
+    }
+  bool result(!stopped);
+  pthread_mutex_unlock(&lock);
+  return result;
+#else // not CH_THREADS
+  stopped = failed;
+  return !stopped;
+#endif // not CH_THREADS
+}
+
+// record that a member failed, the first MESSAGE is kept
+void
+thread_team::fail(const CH_STD::string& message_)
+{
+#ifdef CH_THREADS
+  pthread_mutex_lock(&lock);
+#endif // CH_THREADS
+  if (!failed)
+    {
+      failed = true;
+      message = message_;
+    }
+#ifdef CH_THREADS
+  pthread_mutex_unlock(&lock);
+#endif // CH_THREADS
+  return;
+}
+
+// return whether any member has failed
+bool
+thread_team::has_failed()
+{
+#ifdef CH_THREADS
+  pthread_mutex_lock(&lock);
+  bool result(failed);
+  pthread_mutex_unlock(&lock);
+  return result;
+#else // not CH_THREADS
+  return failed;
+#endif // not CH_THREADS
+}
+
+// return the number of processors available, or one if unknown
+unsigned int
+thread_team::get_processors()
+{
+#if defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+  long n(sysconf(_SC_NPROCESSORS_ONLN));
+  if (n > 0L)
+    {
+      return (unsigned int) n;
+    }
+#endif // HAVE_UNISTD_H && _SC_NPROCESSORS_ONLN
+  return 1U;
+}
+
+CH_END_NAMESPACE
+
+/* $Id: thread.cc,v 1.1.1.1 2004/11/25 20:24:05 banjo Exp $ */
@@ -0,0 +1,99 @@
+// -*- C++ -*-
+// Class for running work in several threads at once.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_THREAD_H
+#define CH_THREAD_H 1
+
+// only use threads if the POSIX thread library was found
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_LIBPTHREAD)
+#define CH_THREADS 1
+#include <pthread.h>
+#endif // HAVE_PTHREAD_H && HAVE_LIBPTHREAD
+
+#include <string>
+#include "except.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// a fixed number of members which all run the same function and can
+// wait for each other at a barrier; without thread support the team
+// has exactly one member (the calling thread)
+class thread_team
+{
+public:
+  // function run by each member, RANK goes from zero to size - 1
+  typedef void (*work)(void* data, unsigned int rank);
+
+private:
+  unsigned int size;		// number of members in the team
+  work task;			// function the members are running
+  void* data;			// argument passed to task
+  unsigned int waiting;		// members waiting at the barrier
+  unsigned long cycle;		// number of times barrier has opened
+  bool released;		// whether started members may begin the task
+  bool failed;			// whether any member failed
+  bool stopped;			// whether any had failed when barrier opened
+  CH_STD::string message;	// what the first failure was
+#ifdef CH_THREADS
+  pthread_mutex_t lock;		// protects the variables above
+  pthread_cond_t opened;	// signalled when barrier opens
+#endif // CH_THREADS
+
+private:
+  // prevent copy construction and assignment
+  thread_team(const thread_team&);
+  thread_team& operator=(const thread_team&);
+  // run the task as member RANK, recording any failure
+  void member(unsigned int rank);
+#ifdef CH_THREADS
+  // start routine for the threads, ARG points to a member_start
+  static void* start(void* arg);
+#endif // CH_THREADS
+public:
+  // ctor: (default) team with SIZE_ members (at least one)
+  explicit thread_team(unsigned int size_ = 1U);
+  // dtor: release the synchronization objects
+  ~thread_team();
+
+  // return the number of members in the team
+  unsigned int get_size() const;
+  // run TASK_(DATA_, rank) in every member, the calling thread being
+  // rank zero, and return when all have finished; if not all threads
+  // can be created the team shrinks to those that were
+  void run(work task_, void* data_)
+    throw (bad_request); // this
+  // wait until every member of the team has called barrier(), return
+  // false if any member had failed by then (the same for all members)
+  bool barrier();
+  // record that a member failed, the first MESSAGE is kept
+  void fail(const CH_STD::string& message_);
+  // return whether any member has failed
+  bool has_failed();
+  // return the number of processors available, or one if unknown
+  static unsigned int get_processors();
+}; // end class thread_team
+
+CH_END_NAMESPACE
+
+#endif // not CH_THREAD_H
+
+/* $Id: thread.h,v 1.1.1.1 2004/11/25 20:24:05 banjo Exp $ */
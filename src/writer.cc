@@ -0,0 +1,273 @@
+// Methods for writing output in a background thread.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <exception>
+#include <set>
+#include "writer.h"
+#include "t_string.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// output_writer methods
+// ctor: (default) write records as they are put
+output_writer::output_writer()
+  : capacity(0U), queue(), running(false), stopping(false), failed(false),
+    message()
+{
+#ifdef CH_THREADS
+  pthread_mutex_init(&lock, 0);
+  pthread_cond_init(&filled, 0);
+  pthread_cond_init(&emptied, 0);
+#endif // CH_THREADS
+}
+
+// dtor: write whatever is still queued
+output_writer::~output_writer()
+{
+  // a failure can no longer be reported
+  try
+    {
+      finish();
+    }
+  catch (...)
+    {}
+#ifdef CH_THREADS
+  pthread_cond_destroy(&emptied);
+  pthread_cond_destroy(&filled);
+  pthread_mutex_destroy(&lock);
+#endif // CH_THREADS
+}
+
+// output_writer private methods
+// write the records in BATCH and flush their streams, return an empty
+// string or what went wrong
+CH_STD::string
+output_writer::write(CH_STD::deque<record>& batch)
+{
+  // the streams are flushed once per batch, not once per record
+  CH_STD::set<CH_STD::ostream*> streams;
+  try
+    {
+      for (CH_STD::deque<record>::iterator it(batch.begin());
+	   it != batch.end(); ++it)
+	{
+	  (*it->put)(*it->stream, it->data);
+	  streams.insert(it->stream);
+	}
+    }
+  catch (CH_STD::exception& e)
+    {
+      return e.what();
+    }
+  for (CH_STD::set<CH_STD::ostream*>::iterator it(streams.begin());
+       it != streams.end(); ++it)
+    {
+      (*it)->flush();
+      if (!**it)
+	{
+	  return PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+	    ":output_writer::write(): could not write output";
+	}
+    }
+  return CH_STD::string();
+}
+
+// write DATA to STREAM
+void
+output_writer::put_text(CH_STD::ostream& stream, const CH_STD::string& data)
+{
+  stream.write(data.data(), data.size());
+  return;
+}
+
+#ifdef CH_THREADS
+// start routine for the writer thread, ARG is the output_writer
+void*
+output_writer::start(void* arg)
+{
+  static_cast<output_writer*>(arg)->drain();
+  return 0;
+}
+
+// write batches of records until told to stop
+void
+output_writer::drain()
+{
+  CH_STD::deque<record> batch;
+  pthread_mutex_lock(&lock);
+  while (true)
+    {
+      // wait for something to do
+      while (queue.empty() && !stopping)
+	{
+	  pthread_cond_wait(&filled, &lock);
+	}
+      if (queue.empty())
+	{
+	  break;		// while (true)
+	}
+      // take everything waiting, freeing the queue for the producer
+      batch.swap(queue);
+      pthread_cond_broadcast(&emptied);
+      pthread_mutex_unlock(&lock);
+      CH_STD::string what(write(batch));
+      batch.clear();
+      pthread_mutex_lock(&lock);
+      if (what.size() > 0U && !failed)
+	{
+	  failed = true;
+	  message = what;
+	}
+    }
+  pthread_mutex_unlock(&lock);
+  return;
+}
+#endif // CH_THREADS
+
+// throw if the writer thread failed to write anything
+void
+output_writer::check()
+  throw (bad_file)
+{
+#ifdef CH_THREADS
+  pthread_mutex_lock(&lock);
+  bool result(failed);
+  pthread_mutex_unlock(&lock);
+#else // not CH_THREADS
+  bool result(failed);
+#endif // not CH_THREADS
+  if (result)
+    {
+      throw bad_file(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+		     ":output_writer::check(): output could not be "
+		     "written: " + message);
+    }
+  return;
+}
+
+// output_writer public methods
+// start writing in a thread of its own, letting up to CAPACITY_ records
+// wait (zero keeps writing them as they are put)
+void
+output_writer::start(unsigned int capacity_)
+  throw (bad_request)
+{
+  if (running)
+    {
+      throw bad_request(PACKAGE ":" __FILE__ ":" + t_string(__LINE__) +
+			":output_writer::start(): the writer thread has "
+			"already been started");
+    }
+  capacity = capacity_;
+#ifdef CH_THREADS
+  if (capacity > 0U)
+    {
+      stopping = false;
+      // if no thread can be created just keep writing synchronously
+      running = (pthread_create(&thread, 0, &output_writer::start, this)
+		 == 0);
+    }
+#endif // CH_THREADS
+  return;
+}
+
+// queue TEXT to be written to STREAM
+void
+output_writer::put(CH_STD::ostream& stream, const CH_STD::string& text)
+  throw (bad_file)
+{
+  put(stream, &output_writer::put_text, text);
+  return;
+}
+
+// queue DATA to be written to STREAM by PUT_
+void
+output_writer::put(CH_STD::ostream& stream, sink put_,
+		   const CH_STD::string& data)
+  throw (bad_file)
+{
+  record r;
+  r.stream = &stream;
+  r.put = put_;
+#ifdef CH_THREADS
+  if (running)
+    {
+      pthread_mutex_lock(&lock);
+      // only wait for the disk when the queue is full
+      while (queue.size() >= capacity && !failed)
+	{
+	  pthread_cond_wait(&emptied, &lock);
+	}
+      bool ok(!failed);
+      if (ok)
+	{
+	  queue.push_back(r);
+	  queue.back().data = data;
+	  pthread_cond_signal(&filled);
+	}
+      pthread_mutex_unlock(&lock);
+      if (!ok)
+	{
+	  check();
+	}
+      return;
+    }
+#endif // CH_THREADS
+  // write it now
+  r.data = data;
+  CH_STD::deque<record> batch(1U, r);
+  CH_STD::string what(write(batch));
+  if (what.size() > 0U)
+    {
+      failed = true;
+      message = what;
+      check();
+    }
+  return;
+}
+
+// write everything queued and stop the writer thread
+void
+output_writer::finish()
+  throw (bad_file)
+{
+#ifdef CH_THREADS
+  if (running)
+    {
+      pthread_mutex_lock(&lock);
+      stopping = true;
+      pthread_cond_signal(&filled);
+      pthread_mutex_unlock(&lock);
+      pthread_join(thread, 0);
+      running = false;
+    }
+#endif // CH_THREADS
+  check();
+  return;
+}
+
+CH_END_NAMESPACE
+
+/* $Id$ */
@@ -0,0 +1,109 @@
+// -*- C++ -*-
+// Class for writing output in a background thread.
+// Copyright (C) 2004 David Dooling <banjo@users.sourceforge.net>
+//
+// This file is part of CHIMP.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+#ifndef CH_WRITER_H
+#define CH_WRITER_H 1
+
+#include <deque>
+#include <ostream>
+#include <string>
+#include "except.h"
+#include "thread.h"
+
+// set namespace to avoid possible clashes
+CH_BEGIN_NAMESPACE
+
+// bounded queue of formatted output records written to their streams
+// by a thread of its own, so the thread producing them only waits for
+// the disk when the queue is full; without thread support (or before
+// start() is called) records are written as they are put
+class output_writer
+{
+public:
+  // function writing DATA to STREAM, the default writes the characters
+  typedef void (*sink)(CH_STD::ostream& stream, const CH_STD::string& data);
+
+private:
+  // one piece of output waiting to be written
+  struct record
+  {
+    CH_STD::ostream* stream;	// where the output goes
+    sink put;			// how to write it
+    CH_STD::string data;	// the output itself
+  };
+
+  unsigned int capacity;	// most records that may wait in queue
+  CH_STD::deque<record> queue;	// records waiting to be written
+  bool running;			// whether the writer thread was started
+  bool stopping;		// whether the writer thread should quit
+  bool failed;			// whether any record could not be written
+  CH_STD::string message;	// what the first failure was
+#ifdef CH_THREADS
+  pthread_t thread;		// the writer thread
+  pthread_mutex_t lock;		// protects the variables above
+  pthread_cond_t filled;	// signalled when records are queued
+  pthread_cond_t emptied;	// signalled when records are taken
+#endif // CH_THREADS
+
+private:
+  // prevent copy construction and assignment
+  output_writer(const output_writer&);
+  output_writer& operator=(const output_writer&);
+  // write the records in BATCH and flush their streams, return an
+  // empty string or what went wrong
+  static CH_STD::string write(CH_STD::deque<record>& batch);
+  // write DATA to STREAM
+  static void put_text(CH_STD::ostream& stream, const CH_STD::string& data);
+#ifdef CH_THREADS
+  // start routine for the writer thread, ARG is the output_writer
+  static void* start(void* arg);
+  // write batches of records until told to stop
+  void drain();
+#endif // CH_THREADS
+  // throw if the writer thread failed to write anything
+  void check()
+    throw (bad_file); // this
+public:
+  // ctor: (default) write records as they are put
+  output_writer();
+  // dtor: write whatever is still queued
+  ~output_writer();
+
+  // start writing in a thread of its own, letting up to CAPACITY_
+  // records wait (zero keeps writing them as they are put)
+  void start(unsigned int capacity_)
+    throw (bad_request); // this
+  // queue TEXT to be written to STREAM
+  void put(CH_STD::ostream& stream, const CH_STD::string& text)
+    throw (bad_file); // put()
+  // queue DATA to be written to STREAM by PUT_
+  void put(CH_STD::ostream& stream, sink put_, const CH_STD::string& data)
+    throw (bad_file); // check(), write()
+  // write everything queued and stop the writer thread
+  void finish()
+    throw (bad_file); // check()
+}; // end class output_writer
+
+CH_END_NAMESPACE
+
+#endif // not CH_WRITER_H
+
+/* $Id$ */